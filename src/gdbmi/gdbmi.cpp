@@ -1,18 +1,29 @@
 #include "gdbmi.h"
 
-GDBMI::GDBMI()
+GDBMI::GDBMI() : GDBMI(LaunchOptions())
+{
+
+}
+
+GDBMI::GDBMI(const LaunchOptions &options)
 {
 	m_exitThreads = false;
+	m_launchOptions = options;
 	
 	initLogs();
-	initPipe();
-	sleep(1); // This is to give time for the forked child to call exec(), otherwise bad things happen :(
+	initPipe(m_launchOptions);
 	initHandlers();
+	initCommands();
+	initEvents();
 	initState();
 	initControl();
 	
 	sendCommand("-gdb-set mi-async on");
 	sendCommand("-gdb-set disassembly-flavor intel");
+	
+	// The commands above are just queued, so they go out as soon as GDB reads its input
+	if(waitReady() == false)
+		logPrintf(LogLevel::Error, "GDB is not ready (it exited, or timed out after %u ms)\n", GDB_READY_TIMEOUT_MS);
 }
 
 GDBMI::~GDBMI()
@@ -22,6 +33,8 @@ GDBMI::~GDBMI()
 	destroyControl();
 	destroyState();
 	destroyHandlers();
+	destroyEvents();
 	destroyPipe();
+	destroyCommands();
 	destroyLogs();
 }
@@ -6,16 +6,42 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <algorithm>
 #include <deque>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <future>
+#include <coroutine>
+#include <memory>
 #include <cstring>
 
 #include <unistd.h>
 #include <fcntl.h>
 
-#define GDB_HANDLER_THREAD_COUNT	32
+#include "gdbmi_framer.h"
+#include "gdbmi_tokenmap.h"
+#include "gdbmi_snapshot.h"
+#include "gdbmi_symtab.h"
+#include "gdbmi_symindex.h"
+#include "gdbmi_mikey.h"
+#include "gdbmi_mivalue.h"
+#include "gdbmi_mibind.h"
+#include "gdbmi_symstream.h"
+
+#define GDB_HANDLER_THREAD_COUNT	4 // Default size of the record handler pool
+#define GDB_READY_TIMEOUT_MS		5000
+#define GDB_COMMAND_TIMEOUT_MS		30000 // Default for sendCommand(); 0 means no timeout
+#define GDB_COMMAND_WINDOW			2 // Default number of commands written to GDB but not answered yet
+#define GDB_DISAS_CACHE_ENTRIES		32 // Functions kept by the disassembly cache
+#define GDB_SEARCH_MAX_RESULTS		200 // Default for searchSymbols()
+#define GDB_SYMBOL_STREAM_BYTES		(256 * 1024) // Symbol lists longer than this are parsed as they're read
+#define GDB_READ_BURST_BYTES		(1024 * 1024) // Most read from GDB before the records are handed on
+#define GDB_DEFAULT_PATH			"gdb"
 #define GDB_DEFAULT_LOG_LEVEL		LogLevel::Info
 #define GDB_MAX_LOG_ITEMS			1024
 
@@ -36,20 +62,52 @@ class GDBMI
 {
 	public:
 	
+		// How to launch GDB. The MI arguments GDBMI depends on
+		// ('--interpreter=mi --nx') are always passed first.
+		struct LaunchOptions
+		{
+			// A bare name is looked up in $PATH
+			string gdbPath = GDB_DEFAULT_PATH;
+			
+			// Appended to GDB's command line
+			vector<string> extraArgs;
+			
+			// "NAME=value" entries, added to (or replacing) the environment GDB gets
+			vector<string> env;
+			
+			// If false, GDB gets only the variables in 'env'
+			bool inheritEnv = true;
+			
+			// Number of threads handling the records GDB sends us
+			uint32_t handlerThreads = GDB_HANDLER_THREAD_COUNT;
+			
+			// How many commands may be written to GDB ahead of their results.
+			// GDB runs them one at a time, so anything past this waits in our
+			// own queues, where interactive commands can still jump ahead.
+			uint32_t commandWindow = GDB_COMMAND_WINDOW;
+		};
+		
 		GDBMI();
+		GDBMI(const LaunchOptions &options);
 		~GDBMI();
 		
+		const LaunchOptions &getLaunchOptions() { return m_launchOptions; }
+		
 	// *INDENT-OFF*
 	#include "gdbmi_log.h"
 	#include "gdbmi_parse.h"
 	#include "gdbmi_handlers.h"
+	#include "gdbmi_commands.h"
+	#include "gdbmi_events.h"
 	#include "gdbmi_pipe.h"
 	#include "gdbmi_control.h"
 	#include "gdbmi_state.h"
 	#include "gdbmi_data.h"
+	#include "gdbmi_search.h"
 	// *INDENT-ON*
 		
 		bool m_exitThreads;
+		LaunchOptions m_launchOptions;
 		
 };
 
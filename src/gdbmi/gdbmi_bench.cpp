@@ -0,0 +1,651 @@
+#ifdef BUILD_GDBMI_TESTS
+#include "gdbmi.h"
+#include "gdbmi_testutil.h"
+
+#include <chrono>
+
+#include "../catch.h"
+
+// These are hidden test cases, so they don't run with the regular tests.
+// Run them with: ./gdbmi_test [benchmark]
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double elapsedSec(BenchClock::time_point start)
+{
+	return std::chrono::duration<double>(BenchClock::now() - start).count();
+}
+
+// Builds the results of a '-data-disassemble' response (what follows "^done,")
+// with instCount instructions
+static string makeDisassembly(uint32_t instCount)
+{
+	string ret = "asm_insns=[";
+	uint64_t addr = 0x555555555000;
+	
+	for(uint32_t i = 0; i < instCount; i++)
+	{
+		char buf[256];
+		snprintf(buf, sizeof(buf), "%s{address=\"0x%016llx\",func-name=\"function_%u\",offset=\"%u\","
+				 "inst=\"mov    0x%x(%%rbp),%%eax\"}", (i > 0) ? "," : "", (unsigned long long) addr, i / 64, (i % 64) * 4, i % 512);
+				 
+		ret += buf;
+		addr += 4;
+	}
+	
+	ret += "]";
+	return ret;
+}
+
+TEST_CASE("MI line framer throughput", "[.benchmark][framer]")
+{
+	// A stream of small async records with a few multi-megabyte symbol responses mixed in
+	string stream;
+	for(uint32_t i = 0; i < 4; i++)
+	{
+		for(uint32_t j = 0; j < 2000; j++)
+			stream += "=library-loaded,id=\"/usr/lib/libfoo.so\",target-name=\"/usr/lib/libfoo.so\"\n(gdb) \n";
+			
+		stream += makeSymbolResponse(100 + i, 400, 50) + "\n";
+	}
+	
+	const size_t chunkSize = 64 * 1024;
+	double streamMB = (double) stream.length() / (1024.0 * 1024.0);
+	
+	// The framer, fed the same way readPipe() feeds it
+	size_t frameLines = 0;
+	size_t frameBytes = 0;
+	MILineFramer framer;
+	
+	auto start = BenchClock::now();
+	for(size_t pos = 0; pos < stream.length(); pos += chunkSize)
+	{
+		size_t len = std::min(chunkSize, stream.length() - pos);
+		memcpy(framer.writePtr(chunkSize), stream.data() + pos, len);
+		framer.commit(len);
+		
+		std::string_view line;
+		while(framer.nextLine(line))
+		{
+			frameLines++;
+			frameBytes += line.length();
+		}
+	}
+	double frameSec = elapsedSec(start);
+	
+	// The previous substr()-based line splitting, for comparison
+	size_t legacyLines = 0;
+	size_t legacyBytes = 0;
+	string gdbResponseBuf;
+	
+	start = BenchClock::now();
+	for(size_t pos = 0; pos < stream.length(); pos += chunkSize)
+	{
+		gdbResponseBuf.append(stream, pos, chunkSize);
+		
+		while(gdbResponseBuf.length() > 0)
+		{
+			while(gdbResponseBuf.length() > 0 && gdbResponseBuf[0] == '\n')
+				gdbResponseBuf.erase(gdbResponseBuf.begin());
+				
+			size_t nlPos = gdbResponseBuf.find_first_of('\n');
+			if(nlPos == string::npos)
+				break;
+				
+			string respStr = gdbResponseBuf.substr(0, nlPos);
+			gdbResponseBuf = gdbResponseBuf.substr(nlPos + 1);
+			
+			legacyLines++;
+			legacyBytes += respStr.length();
+		}
+	}
+	double legacySec = elapsedSec(start);
+	
+	REQUIRE(frameLines == legacyLines);
+	REQUIRE(frameBytes == legacyBytes);
+	
+	printf("Framer: %.1f MB in %zu lines: %.2f ms (%.0f MB/s); substr() splitting: %.2f ms (%.0f MB/s)\n",
+		   streamMB, frameLines,
+		   frameSec * 1000.0, streamMB / frameSec,
+		   legacySec * 1000.0, streamMB / legacySec);
+}
+
+TEST_CASE("Symbol table load time and memory", "[.benchmark][symbols]")
+{
+	// 300k symbols, about what our bigger binaries have
+	const uint32_t fileCount = 3000;
+	const uint32_t symsPerFile = 100;
+	
+	GDBMI gdb;
+	uint32_t token = gdb.getToken();
+	string response = makeSymbolResponse(token, fileCount, symsPerFile);
+	uint64_t version = gdb.getFunctionSymbols()->version;
+	
+	// From the record being handed to the handlers to the table being published
+	auto start = BenchClock::now();
+	gdb.registerCallback(token, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::OrderDomain::Symbols);
+	gdb.handleResponse(response);
+	
+	waitUntil([&]() { return gdb.getFunctionSymbols()->version != version; }, 60 * 1000, 100);
+	double loadSec = elapsedSec(start);
+	
+	GDBMI::SymbolSnapshot symbols = gdb.getFunctionSymbols();
+	const SymbolTable &table = symbols->data;
+	REQUIRE(table.size() == fileCount * symsPerFile);
+	
+	// The one-struct-per-symbol list this replaced, built from the same data
+	struct ListSymbol
+	{
+		bool isActive;
+		string fullPath;
+		string shortName;
+		string lineNumber;
+		string name;
+		string type;
+		string description;
+	};
+	
+	vector<ListSymbol> list;
+	list.reserve(table.size());
+	for(size_t i = 0; i < table.size(); i++)
+	{
+		list.push_back({false, string(table.fullPath(i)), string(table.shortName(i)), std::to_string(table.line(i)),
+						string(table.name(i)), string(table.type(i)), string(table.description(i))
+					   });
+	}
+	
+	// Strings longer than the small string buffer get a heap block of their own
+	auto heapBytes = [](const string & s) -> size_t
+	{
+		return (s.capacity() > 15) ? ((s.capacity() + 1 + 16 + 15) & ~(size_t) 15) : 0;
+	};
+	
+	size_t listBytes = list.capacity() * sizeof(ListSymbol);
+	for(auto &sym : list)
+	{
+		listBytes += heapBytes(sym.fullPath) + heapBytes(sym.shortName) + heapBytes(sym.lineNumber);
+		listBytes += heapBytes(sym.name) + heapBytes(sym.type) + heapBytes(sym.description);
+	}
+	
+	double responseMB = (double) response.length() / (1024.0 * 1024.0);
+	double tableMB = (double) table.memoryUsage() / (1024.0 * 1024.0);
+	double listMB = (double) listBytes / (1024.0 * 1024.0);
+	
+	printf("Symbols: %zu in %zu files (%.1f MB response) loaded in %.1f ms; "
+		   "table: %.1f MB, per-symbol structs: %.1f MB (%.1fx)\n",
+		   table.size(), table.fileCount(), responseMB, loadSec * 1000.0,
+		   tableMB, listMB, listMB / tableMB);
+}
+
+TEST_CASE("Symbol list streamed as it's read", "[.benchmark][symbols]")
+{
+	const uint32_t fileCount = 3000;
+	const uint32_t symsPerFile = 100;
+	const size_t piece = 64 * 1024;
+	
+	// Nothing reads from the framer on the read thread without a GDB
+	GDBMI::LaunchOptions opts;
+	opts.gdbPath = "/nonexistent/path/to/gdb";
+	GDBMI gdb(opts);
+	
+	uint32_t token = gdb.getToken();
+	string line = makeSymbolResponse(token, fileCount, symsPerFile) + "\n";
+	registerSymbolList(gdb, token, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::SymbolListKind::Functions);
+	
+	size_t firstAt = 0;
+	size_t maxFramed = 0;
+	double feedSec = 0;
+	
+	for(size_t i = 0; i < line.length(); i += piece)
+	{
+		std::string_view data = std::string_view(line).substr(i, piece);
+		memcpy(gdb.m_framer.writePtr(data.length()), data.data(), data.length());
+		gdb.m_framer.commit(data.length());
+		
+		auto feedStart = BenchClock::now();
+		gdb.dispatchFramed();
+		feedSec += elapsedSec(feedStart);
+		
+		maxFramed = std::max(maxFramed, gdb.m_framer.capacity());
+		
+		if(firstAt == 0 && gdb.getFunctionSymbols()->data.size() > 0)
+			firstAt = i + data.length();
+	}
+	
+	auto lastByte = BenchClock::now();
+	waitUntil([&]() { return gdb.getFunctionSymbols()->data.size() == fileCount * symsPerFile; }, 60 * 1000, 100);
+	
+	double tailMs = elapsedSec(lastByte) * 1000.0;
+	REQUIRE(gdb.getFunctionSymbols()->data.size() == fileCount * symsPerFile);
+	
+	printf("%.1f MB symbol list in %zu KB pieces:\n", line.length() / (1024.0 * 1024.0), piece / 1024);
+	printf("  first symbols published after %zu KB\n", firstAt / 1024);
+	printf("  parsing while reading: %.1f ms, last byte to whole table: %.1f ms\n", feedSec * 1000.0, tailMs);
+	printf("  framer buffer: %.2f MB (the whole line used to be buffered, then copied)\n", maxFramed / (1024.0 * 1024.0));
+}
+
+TEST_CASE("Symbol search over a million names", "[.benchmark][search]")
+{
+	SymbolTable table;
+	const uint32_t fileCount = 10000;
+	const uint32_t symsPerFile = 100;
+	
+	for(uint32_t f = 0; f < fileCount; f++)
+	{
+		uint32_t file = table.addFile("/home/user/project/src/file_" + std::to_string(f) + ".cpp", "file_" + std::to_string(f) + ".cpp");
+		
+		for(uint32_t s = 0; s < symsPerFile; s++)
+		{
+			string name = "ns_" + std::to_string(f) + "::Widget" + std::to_string(s % 37) + "::handle_event_" + std::to_string(s);
+			table.addSymbol(file, s, name, "void (int)", "void " + name + "(int);");
+		}
+	}
+	table.finish();
+	
+	auto start = BenchClock::now();
+	SymbolIndex index;
+	index.build(table);
+	double buildSec = elapsedSec(start);
+	
+	printf("Search index: %zu names, %zu trigrams, %.1f MB, built in %.0f ms\n",
+		   table.size(), index.trigramCount(), index.memoryUsage() / (1024.0 * 1024.0), buildSec * 1000.0);
+		   
+	vector<string> queries = { "ns_9999::widget3", "handle_event_42", "Widget12", "hadnle_evnet", "ns_1234", "zz", "w" };
+	for(auto &query : queries)
+	{
+		const uint32_t runs = 10;
+		size_t hits = 0;
+		
+		start = BenchClock::now();
+		for(uint32_t r = 0; r < runs; r++)
+			hits = index.search(query, GDB_SEARCH_MAX_RESULTS).size();
+		double querySec = elapsedSec(start) / runs;
+		
+		printf("  '%s': %zu hits in %.2f ms\n", query.c_str(), hits, querySec * 1000.0);
+	}
+}
+
+TEST_CASE("MI record parsing", "[.benchmark][parser]")
+{
+	string disas = makeDisassembly(50000);
+	string symbols = makeSymbolResults(400, 250);
+	
+	GDBMI gdb;
+	const uint32_t runs = 5;
+	
+	auto report = [](const char *what, size_t bytes, double sec)
+	{
+		printf("  %-44s %8.2f ms  %8.1f MB/s\n", what, sec * 1000.0, (bytes / (1024.0 * 1024.0)) / sec);
+	};
+	
+	printf("Disassembly: %.1f MB, symbols: %.1f MB\n", disas.length() / (1024.0 * 1024.0), symbols.length() / (1024.0 * 1024.0));
+	
+	// The way the callbacks used to go about it: split the list into
+	// items, then each item into its pairs, copying every piece
+	auto start = BenchClock::now();
+	size_t fields = 0;
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		string rawDisas = disas;
+		KVPair rootPair = gdb.parserGetKVPair(rawDisas);
+		string rawList = rootPair.second.substr(1, rootPair.second.length() - 2);
+		
+		ListItemVector disasList;
+		gdb.parserGetListItems(rawList, disasList);
+		
+		fields = 0;
+		for(auto &asmTuple : disasList)
+		{
+			string tuple = gdb.parserGetTuple(asmTuple);
+			KVPairVector kvpList;
+			gdb.parserGetKVPairs(tuple, kvpList);
+			fields += kvpList.size();
+		}
+	}
+	report("disassembly, parserGet* helpers", disas.length(), elapsedSec(start) / runs);
+	
+	MIArena arena;
+	size_t values = 0;
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		arena.clear();
+		MIParser::parseResults(disas, arena);
+		values = arena.valueCount();
+	}
+	report("disassembly, value tree", disas.length(), elapsedSec(start) / runs);
+	
+	REQUIRE(fields == 50000 * 4);
+	REQUIRE(values == 2 + 50000 * 5);
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		arena.clear();
+		MIParser::parseResults(symbols, arena);
+	}
+	report("symbols, value tree", symbols.length(), elapsedSec(start) / runs);
+	
+	printf("  %zu values, arena: %.1f MB\n", arena.valueCount(), arena.memoryUsage() / (1024.0 * 1024.0));
+}
+
+TEST_CASE("Stop record field access", "[.benchmark][parser]")
+{
+	// A stop in a function whose arguments print as a lot of text
+	auto makeStop = [](uint32_t argCount)
+	{
+		string ret = "reason=\"breakpoint-hit\",disp=\"keep\",bkptno=\"1\",frame={addr=\"0x0000555555555131\","
+					 "func=\"handle_event\",args=[";
+					 
+		for(uint32_t i = 0; i < argCount; i++)
+			ret += string(i > 0 ? "," : "") + "{name=\"arg" + std::to_string(i) + "\",value=\"{x = 1, y = [2, 3], s = \\\"str\\\"}\"}";
+			
+		ret += "],file=\"main.c\",fullname=\"/src/main.c\",line=\"42\",arch=\"i386:x86-64\"},thread-id=\"1\","
+			   "stopped-threads=\"all\",core=\"3\"";
+			   
+		return ret;
+	};
+	
+	for(uint32_t argCount : { 0, 10, 1000, 100000 })
+	{
+		string rec = makeStop(argCount);
+		const uint32_t runs = (argCount >= 1000) ? 20 : 20000;
+		
+		printf("%6u args (%8zu bytes):\n", argCount, rec.length());
+		
+		MIArena arena;
+		size_t found = 0;
+		
+		auto start = BenchClock::now();
+		for(uint32_t r = 0; r < runs; r++)
+		{
+			arena.clear();
+			const MIValue *stop = MIParser::parseResults(rec, arena);
+			found += (stop->get("reason").length() > 0) + (stop->find("frame")->get("addr").length() > 0);
+		}
+		printf("  %-24s %10.2f us\n", "value tree", elapsedSec(start) / runs * 1e6);
+		
+		start = BenchClock::now();
+		for(uint32_t r = 0; r < runs; r++)
+		{
+			MIRecordView stop(rec);
+			found += (stop.get("reason").length() > 0) + (stop.get("frame", "addr").length() > 0);
+		}
+		printf("  %-24s %10.2f us\n", "record view", elapsedSec(start) / runs * 1e6);
+		
+		REQUIRE(found == runs * 4);
+	}
+}
+
+TEST_CASE("MI field dispatch by key ID", "[.benchmark][parser]")
+{
+	string disas = makeDisassembly(50000);
+	
+	MIArena arena;
+	const MIValue *asmList = MIParser::parseResults(disas, arena)->find(MIKey::AsmInsns);
+	REQUIRE(asmList != 0);
+	
+	const uint32_t runs = 20;
+	
+	// Only the matching is timed here; each match adds up the field's
+	// length, which both ways have to agree on
+	auto byName = [&]()
+	{
+		size_t sum = 0;
+		for(const MIValue &asmTuple : *asmList)
+		{
+			for(const MIValue &field : asmTuple)
+			{
+				if(field.key == "address")
+					sum += field.source.length();
+				else if(field.key == "func-name")
+					sum += field.source.length() * 2;
+				else if(field.key == "offset")
+					sum += field.source.length() * 3;
+				else if(field.key == "inst")
+					sum += field.source.length() * 4;
+			}
+		}
+		
+		return sum;
+	};
+	
+	auto byID = [&]()
+	{
+		size_t sum = 0;
+		for(const MIValue &asmTuple : *asmList)
+		{
+			for(const MIValue &field : asmTuple)
+			{
+				// *INDENT-OFF*
+				switch(field.id)
+				{
+					case MIKey::Address:	sum += field.source.length();		break;
+					case MIKey::FuncName:	sum += field.source.length() * 2;	break;
+					case MIKey::Offset:		sum += field.source.length() * 3;	break;
+					case MIKey::Inst:		sum += field.source.length() * 4;	break;
+					default:													break;
+				}
+				// *INDENT-ON*
+			}
+		}
+		
+		return sum;
+	};
+	
+	size_t nameSum = 0, idSum = 0;
+	
+	auto start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+		nameSum += byName();
+	double nameSec = elapsedSec(start) / runs;
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+		idSum += byID();
+	double idSec = elapsedSec(start) / runs;
+	
+	REQUIRE(nameSum == idSum);
+	
+	// What the parser pays for the tags: one lookup per key (timed with
+	// the same walk over the tree as above)
+	size_t tagged = 0;
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		for(const MIValue &asmTuple : *asmList)
+		{
+			for(const MIValue &field : asmTuple)
+				tagged += (MIKeyTable::lookup(field.key) != MIKey::Unknown);
+		}
+	}
+	double tagSec = elapsedSec(start) / runs;
+	
+	REQUIRE(tagged == runs * 50000 * 4);
+	
+	printf("50000 instructions, 200000 fields:\n");
+	printf("  %-28s %8.3f ms\n", "string compares", nameSec * 1000.0);
+	printf("  %-28s %8.3f ms\n", "switch on key ID", idSec * 1000.0);
+	printf("  %-28s %8.3f ms\n", "tagging keys while parsing", tagSec * 1000.0);
+	
+	// Parse and fill as getDisassemblyCallback() does, against the same
+	// with the parser's tagging turned off and the fields matched by name,
+	// as the callback did before there were IDs
+	GDBMI gdb;
+	vector<GDBMI::DisassemblyInstruction> taggedInsts;
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		taggedInsts.clear();
+		REQUIRE(gdb.parseDisassembly(disas, taggedInsts));
+	}
+	double taggedSec = elapsedSec(start) / runs;
+	
+	vector<GDBMI::DisassemblyInstruction> untaggedInsts;
+	MIParser::tagKeys = false;
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		MIArena untaggedArena;
+		const MIValue *list = MIParser::parseResults(disas, untaggedArena)->find("asm_insns");
+		
+		untaggedInsts.clear();
+		untaggedInsts.reserve(list->count);
+		
+		for(const MIValue &asmTuple : *list)
+		{
+			GDBMI::DisassemblyInstruction inst;
+			
+			for(const MIValue &field : asmTuple)
+			{
+				if(field.key == "address")
+				{
+					inst.addrStr = field.text();
+					inst.address = strtoull(inst.addrStr.c_str(), 0, 16);
+				}
+				else if(field.key == "func-name")
+					inst.funcName = field.text();
+				else if(field.key == "offset")
+					inst.offset = field.text();
+				else if(field.key == "inst")
+					inst.instruction = field.text();
+			}
+			
+			untaggedInsts.push_back(std::move(inst));
+		}
+	}
+	double untaggedSec = elapsedSec(start) / runs;
+	
+	MIParser::tagKeys = true;
+	
+	REQUIRE(taggedInsts.size() == 50000);
+	REQUIRE(untaggedInsts.size() == taggedInsts.size());
+	for(size_t i = 0; i < taggedInsts.size(); i++)
+	{
+		REQUIRE(taggedInsts[i].address == untaggedInsts[i].address);
+		REQUIRE(taggedInsts[i].funcName == untaggedInsts[i].funcName);
+	}
+	
+	printf("  %-28s %8.3f ms\n", "parse and fill, tagged", taggedSec * 1000.0);
+	printf("  %-28s %8.3f ms\n", "parse and fill, untagged", untaggedSec * 1000.0);
+}
+
+TEST_CASE("MI tuples bound into structs", "[.benchmark][parser]")
+{
+	string disas = makeDisassembly(50000);
+	
+	GDBMI gdb;
+	const uint32_t runs = 5;
+	
+	typedef GDBMI::DisassemblyInstruction Inst;
+	
+	// The way getDisassemblyCallback() used to do it: the pairs of each
+	// tuple copied into a KVPairVector, then matched by name
+	auto start = BenchClock::now();
+	vector<Inst> oldInsts;
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		string rawDisas = disas;
+		KVPair rootPair = gdb.parserGetKVPair(rawDisas);
+		string rawList = rootPair.second.substr(1, rootPair.second.length() - 2);
+		
+		ListItemVector disasList;
+		gdb.parserGetListItems(rawList, disasList);
+		
+		oldInsts.clear();
+		for(auto &asmTuple : disasList)
+		{
+			string tuple = gdb.parserGetTuple(asmTuple);
+			KVPairVector kvpList;
+			gdb.parserGetKVPairs(tuple, kvpList);
+			
+			Inst inst;
+			for(auto &kvp : kvpList)
+			{
+				if(kvp.first == "address")
+				{
+					inst.addrStr = kvp.second;
+					inst.address = strtoull(inst.addrStr.c_str(), 0, 16);
+				}
+				else if(kvp.first == "func-name")
+					inst.funcName = kvp.second;
+				else if(kvp.first == "offset")
+					inst.offset = kvp.second;
+				else if(kvp.first == "inst")
+					inst.instruction = kvp.second;
+			}
+			
+			oldInsts.push_back(inst);
+		}
+	}
+	double oldSec = elapsedSec(start) / runs;
+	
+	MIArena arena;
+	vector<Inst> insts;
+	
+	start = BenchClock::now();
+	for(uint32_t r = 0; r < runs; r++)
+	{
+		arena.clear();
+		const MIValue *asmList = MIParser::parseResults(disas, arena)->find(MIKey::AsmInsns);
+		
+		insts.clear();
+		insts.reserve(asmList->count);
+		
+		for(const MIValue &asmTuple : *asmList)
+			insts.push_back(GDBMI::disassemblySchema.bind(asmTuple));
+	}
+	double newSec = elapsedSec(start) / runs;
+	
+	REQUIRE(insts.size() == 50000);
+	REQUIRE(oldInsts.size() == insts.size());
+	for(size_t i = 0; i < insts.size(); i++)
+	{
+		REQUIRE(insts[i].address == oldInsts[i].address);
+		REQUIRE(insts[i].instruction == oldInsts[i].instruction);
+	}
+	
+	printf("50000 instructions (%.1f MB):\n", disas.length() / (1024.0 * 1024.0));
+	printf("  %-36s %8.2f ms\n", "parserGet* helpers, KVPairVector", oldSec * 1000.0);
+	printf("  %-36s %8.2f ms\n", "value tree, schema binding", newSec * 1000.0);
+}
+
+TEST_CASE("MI structural scan throughput", "[.benchmark][parser]")
+{
+	string disas = makeDisassembly(50000);
+	string symbols = makeSymbolResponse(1, 400, 250);
+	
+	vector<std::pair<const char *, const string *>> inputs = { { "disassembly", &disas }, { "symbols", &symbols } };
+	
+	for(auto &input : inputs)
+	{
+		const string &text = *input.second;
+		printf("%s (%.1f MB):\n", input.first, text.length() / (1024.0 * 1024.0));
+		
+		for(auto kernel : { MIScanner::Kernel::Scalar, MIScanner::Kernel::SSE2, MIScanner::Kernel::AVX2 })
+		{
+			if(MIScanner::kernelSupported(kernel) == false)
+				continue;
+				
+			const uint32_t runs = 10;
+			vector<uint32_t> structurals;
+			structurals.reserve(text.length() / 4);
+			
+			auto start = BenchClock::now();
+			for(uint32_t r = 0; r < runs; r++)
+			{
+				structurals.clear();
+				MIScanner::findStructurals(text, structurals, kernel);
+			}
+			double sec = elapsedSec(start) / runs;
+			
+			printf("  %-8s %7.2f ms  %6.2f GB/s  (%zu structural)\n", MIScanner::kernelName(kernel), sec * 1000.0,
+				   (text.length() / (1024.0 * 1024.0 * 1024.0)) / sec, structurals.size());
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,361 @@
+#include "gdbmi_private.h"
+
+#include "gdbmi.h"
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+// #include "gdbmi_commands.h"
+#endif
+
+using Clock = std::chrono::steady_clock;
+using Micros = std::chrono::duration<double, std::micro>;
+
+void GDBMI::initCommands()
+{
+
+}
+
+void GDBMI::destroyCommands()
+{
+	// Nobody is left to answer these, so don't leave anyone waiting on them
+	failPendingCommands(MIResult::Status::GDBExited);
+}
+
+GDBMI::CommandHandle GDBMI::sendCommand(string cmd, CmdCallback cb, OrderDomain domain, uint32_t timeoutMs, CmdPriority priority)
+{
+	CommandHandle handle;
+	handle.m_gdb = this;
+	
+	PendingCommand pc;
+	pc.callback = cb;
+	pc.domain = domain;
+	pc.result = std::make_shared<std::promise<MIResult>>();
+	handle.m_result = pc.result->get_future().share();
+	
+	handle.m_token = submitCommand(std::move(cmd), std::move(pc), timeoutMs, priority);
+	return handle;
+}
+
+GDBMI::CmdPriority GDBMI::getCommandPriority(std::string_view cmd)
+{
+	// First match wins, so the exceptions go before the general prefixes
+	static const pair<std::string_view, CmdPriority> lanes[] =
+	{
+		{ "-break-list",			CmdPriority::View },
+		{ "-symbol-",				CmdPriority::Bulk },
+		{ "-exec-",					CmdPriority::Interactive },
+		{ "-break-",				CmdPriority::Interactive },
+		{ "-target-",				CmdPriority::Interactive },
+		{ "-file-",					CmdPriority::Interactive },
+		{ "-gdb-",					CmdPriority::Interactive },
+		{ "-interpreter-exec",		CmdPriority::Interactive },
+	};
+	
+	for(auto &lane : lanes)
+	{
+		if(cmd.starts_with(lane.first))
+			return lane.second;
+	}
+	
+	return CmdPriority::View;
+}
+
+uint32_t GDBMI::submitCommand(string cmd, PendingCommand pc, uint32_t timeoutMs, CmdPriority priority)
+{
+	if(priority == CmdPriority::Auto)
+		priority = getCommandPriority(cmd);
+		
+	uint32_t token = getToken();
+	pc.sentAt = Clock::now();
+	
+	if(timeoutMs > 0)
+		pc.deadline = pc.sentAt + std::chrono::milliseconds(timeoutMs);
+		
+	m_pendingCmdMutex.lock();
+	
+	// Nothing would ever answer it. The read thread marks GDB as exited before
+	// it fails the pending commands, so checking under the lock can't miss both.
+	if(hasExited())
+	{
+		m_pendingCmdMutex.unlock();
+		
+		MIResult result;
+		result.status = MIResult::Status::GDBExited;
+		result.token = token;
+		finishCommand(pc, std::move(result));
+		
+		return token;
+	}
+	
+	m_nextDeadline = std::min(m_nextDeadline, pc.deadline);
+	m_pendingCommands.insert(token, std::move(pc));
+	
+	m_commandStats.maxPending = std::max(m_commandStats.maxPending, (uint32_t) m_pendingCommands.size());
+	m_pendingCmdMutex.unlock();
+	
+	cmd = std::to_string(token) + cmd;
+	
+	if(cmd.back() != '\n')
+		cmd += "\n";
+		
+	string logCmd("Sending: ");
+	logCmd += cmd;
+	logPrintf(LogLevel::Verbose, logCmd.c_str());
+	
+	// queueCommand() wakes the read thread, which picks up the new deadline
+	queueCommand(std::move(cmd), token, priority);
+	
+	return token;
+}
+
+bool GDBMI::cancelCommand(uint32_t token)
+{
+	PendingCommand cmd;
+	
+	m_pendingCmdMutex.lock();
+	bool found = m_pendingCommands.take(token, cmd);
+	
+	if(found)
+		m_commandStats.cancelled++;
+	m_pendingCmdMutex.unlock();
+	
+	if(found == false)
+		return false;
+		
+	MIResult result;
+	result.status = MIResult::Status::Cancelled;
+	result.token = token;
+	finishCommand(cmd, std::move(result));
+	
+	return true;
+}
+
+bool GDBMI::completeCommand(const GDBResponse &response)
+{
+	PendingCommand cmd;
+	
+	// Whoever takes the entry out of the table owns the command, so a
+	// result racing with a timeout or a cancel is only handled once
+	m_pendingCmdMutex.lock();
+	bool found = (response.recordToken != 0 && m_pendingCommands.take(response.recordToken, cmd));
+	m_pendingCmdMutex.unlock();
+	
+	if(found == false)
+		return false;
+		
+	MIResult result;
+	result.token = response.recordToken;
+	result.resultClass = response.recordClass;
+	
+	// The inferior has moved since this was sent, so the data would only
+	// overwrite newer data. Drop it without handing it to the parser.
+	if(cmd.stopGeneration != 0 && cmd.stopGeneration != getStopGeneration())
+	{
+		m_pendingCmdMutex.lock();
+		m_commandStats.stale++;
+		m_pendingCmdMutex.unlock();
+		
+		result.status = MIResult::Status::Stale;
+		finishCommand(cmd, std::move(result));
+		
+		return true;
+	}
+	
+	if(cmd.callback != 0)
+		cmd.callback(this, response);
+		
+	result.status = (response.recordClass == "error" ? MIResult::Status::Error : MIResult::Status::Done);
+	result.data = response.recordData;
+	
+	if(cmd.result != 0 || cmd.continuation != 0)
+	{
+		double latencyUs = Micros(Clock::now() - cmd.sentAt).count();
+		
+		m_pendingCmdMutex.lock();
+		m_commandStats.completed++;
+		
+		if(result.status == MIResult::Status::Error)
+			m_commandStats.errors++;
+			
+		m_commandStats.maxLatencyUs = std::max(m_commandStats.maxLatencyUs, latencyUs);
+		m_totalLatencyUs += latencyUs;
+		m_pendingCmdMutex.unlock();
+	}
+	
+	finishCommand(cmd, std::move(result));
+	return true;
+}
+
+void GDBMI::finishCommand(PendingCommand &cmd, MIResult result)
+{
+	// Commands registered with registerCallback() have nobody waiting on them
+	if(cmd.continuation != 0)
+		cmd.continuation(result);
+	else if(cmd.result != 0)
+		cmd.result->set_value(std::move(result));
+}
+
+void GDBMI::resumeOnPool(OrderDomain domain, std::coroutine_handle<> coro)
+{
+	// The workers are gone (or going) when GDBMI is being destroyed,
+	// so the sequence can't continue. Free its frame instead.
+	if(m_exitThreads)
+	{
+		coro.destroy();
+		return;
+	}
+	
+	postTask(domain, [coro]() { coro.resume(); });
+}
+
+void GDBMI::CommandAwaiter::await_suspend(std::coroutine_handle<> coro)
+{
+	PendingCommand pc;
+	pc.callback = m_callback;
+	pc.domain = m_domain;
+	pc.symbolList = m_symbolList;
+	
+	// This can run before submitCommand() returns, on another thread,
+	// so nothing here touches the awaiter after the command is submitted
+	GDBMI *gdb = m_gdb;
+	OrderDomain domain = m_domain;
+	pc.continuation = [this, gdb, domain, coro](MIResult & res)
+	{
+		m_result = std::move(res);
+		gdb->resumeOnPool(domain, coro);
+	};
+	
+	gdb->submitCommand(m_cmd, std::move(pc), m_timeoutMs, m_priority);
+}
+
+void GDBMI::CommandGroupAwaiter::await_suspend(std::coroutine_handle<> coro)
+{
+	m_results.resize(m_commands.size());
+	m_remaining = m_commands.size();
+	
+	// Copied out first for the same reason as in CommandAwaiter::await_suspend()
+	GDBMI *gdb = m_gdb;
+	OrderDomain domain = m_domain;
+	vector<CommandAwaiter> commands = std::move(m_commands);
+	
+	for(size_t i = 0; i < commands.size(); i++)
+	{
+		PendingCommand pc;
+		pc.callback = commands[i].m_callback;
+		pc.domain = commands[i].m_domain;
+		pc.symbolList = commands[i].m_symbolList;
+		
+		// Each result has its own slot. The last command to finish resumes the coroutine.
+		pc.continuation = [this, gdb, domain, coro, i](MIResult & res)
+		{
+			m_results[i] = std::move(res);
+			
+			if(--m_remaining == 0)
+				gdb->resumeOnPool(domain, coro);
+		};
+		
+		gdb->submitCommand(commands[i].m_cmd, std::move(pc), commands[i].m_timeoutMs, commands[i].m_priority);
+	}
+}
+
+void GDBMI::expireCommands()
+{
+	Clock::time_point now = Clock::now();
+	vector<pair<uint32_t, PendingCommand>> expired;
+	
+	m_pendingCmdMutex.lock();
+	if(now >= m_nextDeadline)
+	{
+		vector<uint32_t> expiredTokens;
+		m_nextDeadline = Clock::time_point::max();
+		
+		m_pendingCommands.forEach([&](uint32_t token, PendingCommand & pc)
+		{
+			if(pc.deadline <= now)
+				expiredTokens.push_back(token);
+			else
+				m_nextDeadline = std::min(m_nextDeadline, pc.deadline);
+		});
+		
+		for(uint32_t token : expiredTokens)
+		{
+			expired.emplace_back(token, PendingCommand());
+			m_pendingCommands.take(token, expired.back().second);
+		}
+		
+		m_commandStats.timedOut += expired.size();
+	}
+	m_pendingCmdMutex.unlock();
+	
+	for(auto &exp : expired)
+	{
+		logPrintf(LogLevel::Warn, "Command %u timed out; its result will be ignored\n", exp.first);
+		
+		MIResult result;
+		result.status = MIResult::Status::Timeout;
+		result.token = exp.first;
+		finishCommand(exp.second, std::move(result));
+	}
+}
+
+int32_t GDBMI::nextCommandTimeout()
+{
+	m_pendingCmdMutex.lock();
+	Clock::time_point deadline = m_nextDeadline;
+	m_pendingCmdMutex.unlock();
+	
+	if(deadline == Clock::time_point::max())
+		return -1;
+		
+	auto waitMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count() + 1;
+	return (int32_t) std::clamp<decltype(waitMs)>(waitMs, 0, INT32_MAX);
+}
+
+void GDBMI::failPendingCommands(MIResult::Status status)
+{
+	vector<pair<uint32_t, PendingCommand>> failed;
+	
+	m_pendingCmdMutex.lock();
+	m_pendingCommands.forEach([&](uint32_t token, PendingCommand & pc)
+	{
+		failed.emplace_back(token, pc);
+	});
+	
+	for(auto &f : failed)
+		m_pendingCommands.erase(f.first);
+		
+	m_nextDeadline = Clock::time_point::max();
+	m_pendingCmdMutex.unlock();
+	
+	for(auto &f : failed)
+	{
+		MIResult result;
+		result.status = status;
+		result.token = f.first;
+		finishCommand(f.second, std::move(result));
+	}
+}
+
+GDBMI::CommandStats GDBMI::getCommandStats()
+{
+	CommandStats ret;
+	m_pendingCmdMutex.lock();
+	ret = m_commandStats;
+	ret.pending = m_pendingCommands.size();
+	
+	if(ret.completed > 0)
+		ret.avgLatencyUs = m_totalLatencyUs / ret.completed;
+	m_pendingCmdMutex.unlock();
+	
+	m_inFlightMutex.lock();
+	ret.coalesced = m_coalescedRequests;
+	ret.trailingFetches = m_trailingFetches;
+	m_inFlightMutex.unlock();
+	
+	m_outQueueMutex.lock();
+	ret.unanswered = m_unanswered.size();
+	
+	for(size_t i = 0; i < (size_t) CmdPriority::Count; i++)
+		ret.queued[i] = m_outQueues[i].size();
+	m_outQueueMutex.unlock();
+	
+	return ret;
+}
@@ -0,0 +1,265 @@
+#ifndef UNIQUE_GDBMI_COMMANDS_H
+#define UNIQUE_GDBMI_COMMANDS_H
+
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_private.h"
+
+class GDBMI
+{
+
+#define SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_handlers.h"
+#undef SOMETHING_UNIQUE_GDBMI_H
+
+#endif
+
+	public:
+	
+		// Which outbound lane a command waits in. GDB runs one command at a
+		// time, so this only decides what gets written next; see scheduleCommands().
+		enum class CmdPriority : uint8_t
+		{
+			Interactive = 0,	// Stepping, running, breakpoints: the user is waiting on these
+			View,				// Refreshing registers, the backtrace, disassembly...
+			Bulk,				// Symbol queries, which can take seconds on big binaries
+			Count,
+			Auto = Count		// Picked from the command text by getCommandPriority()
+		};
+		
+		// What became of a command sent with sendCommand()
+		struct MIResult
+		{
+			enum class Status : uint8_t
+			{
+				Done = 0,	// GDB answered with ^done, ^running, ^connected or ^exit
+				Error,		// GDB answered with ^error
+				Timeout,	// No answer before the command's timeout ran out
+				Cancelled,	// cancelCommand() got to it first
+				GDBExited,	// GDB went away (or GDBMI was destroyed) first
+				Stale		// Answered, but the inferior has stopped or started since it was sent
+			};
+			
+			Status status = Status::Done;
+			uint32_t token = 0;
+			string resultClass;	// "done", "running", "error"... Empty if GDB never answered
+			string data;		// The result record's data, e.g. msg="..." for ^error
+			
+			bool ok() const { return status == Status::Done; }
+		};
+		
+		// Returned by sendCommand(). Copies share the same result.
+		// A handle must not be used after its GDBMI object is destroyed.
+		class CommandHandle
+		{
+			public:
+			
+				uint32_t token() const { return m_token; }
+				bool valid() const { return m_result.valid(); }
+				
+				// Blocks until the command completes, fails, times out or is cancelled
+				const MIResult &get() const { return m_result.get(); }
+				
+				// Returns true if the result is available within timeoutMs
+				bool waitFor(uint32_t timeoutMs) const
+				{
+					return m_result.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready;
+				}
+				
+				bool isDone() const { return waitFor(0); }
+				
+				// Stops waiting for the result; see cancelCommand()
+				bool cancel() { return (m_gdb != 0 ? m_gdb->cancelCommand(m_token) : false); }
+				
+				std::shared_future<MIResult> future() const { return m_result; }
+				
+			private:
+			
+				friend class GDBMI;
+				
+				GDBMI *m_gdb = 0;
+				uint32_t m_token = 0;
+				std::shared_future<MIResult> m_result;
+		};
+		
+		struct CommandStats
+		{
+			uint32_t pending = 0;		// Commands waiting for their result right now
+			uint32_t maxPending = 0;	// High-water mark since startup
+			uint64_t completed = 0;		// Answered by GDB, errors included
+			uint64_t errors = 0;
+			uint64_t timedOut = 0;
+			uint64_t cancelled = 0;
+			double avgLatencyUs = 0;	// From sendCommand() to the result being handled
+			double maxLatencyUs = 0;
+			
+			uint64_t coalesced = 0;			// Data requests that joined an identical one in flight
+			uint64_t trailingFetches = 0;	// Fetches sent for those, after the one in flight
+			uint64_t stale = 0;				// Results dropped because they were for an older stop
+			
+			uint32_t unanswered = 0;	// Written to GDB, result not read yet
+			uint32_t queued[(size_t) CmdPriority::Count] = {};	// Waiting in each lane to be written
+		};
+		
+		// Sends a command to GDB, prefixed with a new token. 'cb' (if given) is
+		// called with the result record on the worker pool, in 'domain', before
+		// the handle's result is set. The pending entry is removed as soon as the
+		// result arrives, or after timeoutMs (0 waits for as long as it takes).
+		// Interactive commands are written ahead of queued view and bulk ones.
+		CommandHandle sendCommand(string cmd, CmdCallback cb = 0, OrderDomain domain = OrderDomain::None,
+								  uint32_t timeoutMs = GDB_COMMAND_TIMEOUT_MS, CmdPriority priority = CmdPriority::Auto);
+								  
+		// The lane a command goes in when sent with CmdPriority::Auto
+		static CmdPriority getCommandPriority(std::string_view cmd);
+		
+		// Completes the command with Status::Cancelled and drops its callback.
+		// GDB still runs the command; its result is ignored when it arrives.
+		// Returns false if the command had already completed.
+		bool cancelCommand(uint32_t token);
+		
+		CommandStats getCommandStats();
+		
+		
+		
+		
+		// Coroutine interface
+		//
+		// Multi-step sequences are written as coroutines returning CommandTask:
+		//
+		//	GDBMI::CommandTask GDBMI::someSequence()
+		//	{
+		//		MIResult res = co_await command("-file-exec-and-symbols ...");
+		//		vector<CommandAwaiter> fetches;
+		//		fetches.push_back(command("-break-list"));
+		//		fetches.push_back(command("-stack-list-frames"));
+		//		vector<MIResult> all = co_await whenAll(std::move(fetches));
+		//	}
+		//
+		// A command is sent when it's awaited, and the coroutine continues on the
+		// worker pool (in the command's ordering domain) once its result is in.
+		// Commands that fail, time out or are cancelled resume it the same way.
+		
+		// Fire-and-forget coroutine. It runs on the calling thread until its first
+		// co_await, and its frame is freed when it finishes. A sequence still waiting
+		// on a command when GDBMI is destroyed is freed without being resumed.
+		struct CommandTask
+		{
+			struct promise_type
+			{
+				CommandTask get_return_object() { return {}; }
+				std::suspend_never initial_suspend() noexcept { return {}; }
+				std::suspend_never final_suspend() noexcept { return {}; }
+				void return_void() {}
+				void unhandled_exception() { std::terminate(); }
+			};
+		};
+		
+		class CommandAwaiter
+		{
+			public:
+			
+				CommandAwaiter(GDBMI *gdb, string cmd, CmdCallback cb, OrderDomain domain, uint32_t timeoutMs, CmdPriority priority) :
+					m_gdb(gdb), m_cmd(std::move(cmd)), m_callback(cb), m_domain(domain), m_timeoutMs(timeoutMs), m_priority(priority) {}
+					
+				bool await_ready() { return false; }
+				void await_suspend(std::coroutine_handle<> coro);
+				MIResult await_resume() { return std::move(m_result); }
+				
+			private:
+			
+				friend class GDBMI;
+				
+				GDBMI *m_gdb;
+				string m_cmd;
+				CmdCallback m_callback;
+				OrderDomain m_domain;
+				uint32_t m_timeoutMs;
+				CmdPriority m_priority;
+				SymbolListKind m_symbolList = SymbolListKind::None;
+				MIResult m_result;
+		};
+		
+		class CommandGroupAwaiter
+		{
+			public:
+			
+				CommandGroupAwaiter(GDBMI *gdb, vector<CommandAwaiter> commands, OrderDomain domain) :
+					m_gdb(gdb), m_commands(std::move(commands)), m_domain(domain) {}
+					
+				bool await_ready() { return m_commands.size() == 0; }
+				void await_suspend(std::coroutine_handle<> coro);
+				vector<MIResult> await_resume() { return std::move(m_results); }
+				
+			private:
+			
+				GDBMI *m_gdb;
+				vector<CommandAwaiter> m_commands;
+				OrderDomain m_domain;
+				vector<MIResult> m_results;
+				std::atomic<size_t> m_remaining = {0};
+		};
+		
+		// Same arguments as sendCommand(). 'cb' still runs (in 'domain')
+		// before the coroutine is resumed with the result.
+		CommandAwaiter command(string cmd, CmdCallback cb = 0, OrderDomain domain = OrderDomain::None,
+							   uint32_t timeoutMs = GDB_COMMAND_TIMEOUT_MS, CmdPriority priority = CmdPriority::Auto)
+		{
+			return CommandAwaiter(this, std::move(cmd), cb, domain, timeoutMs, priority);
+		}
+		
+		// Sends all the commands at once. The coroutine is resumed (in 'domain')
+		// when the last one completes, with the results in the same order.
+		CommandGroupAwaiter whenAll(vector<CommandAwaiter> commands, OrderDomain domain = OrderDomain::None)
+		{
+			return CommandGroupAwaiter(this, std::move(commands), domain);
+		}
+		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		// Called by the GDBMI constructor
+		void initCommands();
+		
+		// Called by the GDBMI destructor, once the read thread has stopped
+		void destroyCommands();
+		
+		// Removes the command's pending entry, runs its callback and sets its result.
+		// Called from handleResultRecord(). Returns false if the token isn't pending.
+		bool completeCommand(const GDBResponse &response);
+		
+		// Adds the token and pending entry and queues the command; returns the token
+		uint32_t submitCommand(string cmd, PendingCommand pc, uint32_t timeoutMs, CmdPriority priority);
+		
+		// Sets the result of a command whose pending entry was already taken out
+		void finishCommand(PendingCommand &cmd, MIResult result);
+		
+		// Continues a coroutine waiting on a command on the worker pool
+		void resumeOnPool(OrderDomain domain, std::coroutine_handle<> coro);
+		
+		// Fails every pending command that has passed its deadline.
+		// Called from the read thread.
+		void expireCommands();
+		
+		// How long the read thread may wait in epoll_wait() before the
+		// next deadline comes up; -1 if no pending command has one
+		int32_t nextCommandTimeout();
+		
+		// Fails every pending command, e.g. when GDB exits
+		void failPendingCommands(MIResult::Status status);
+		
+		// Guarded by m_pendingCmdMutex
+		std::chrono::steady_clock::time_point m_nextDeadline = std::chrono::steady_clock::time_point::max();
+		CommandStats m_commandStats;
+		double m_totalLatencyUs = 0;
+		
+		
+		
+// *INDENT-OFF*
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+};
+#endif
+// *INDENT-ON*
+
+#endif
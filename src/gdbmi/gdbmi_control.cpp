@@ -25,15 +25,8 @@ void GDBMI::doExecCommand(ExecCmd cmd, string location)
 		
 		case ExecCmd::Finish:
 		{
-			string cmdToken = getTokenStr();
-			auto finishCB = [&](GDBMI * obj, GDBResponse resp) -> void
-			{
-				requestCurrentExecPos();
-				requestDisassembleAddr("$pc");
-			};
-			
-			registerCallback(cmdToken, finishCB);
-			sendCommand(cmdToken + "-exec-finish");
+			// The *stopped record (reason "function-finished") refreshes the position
+			sendCommand("-exec-finish");
 		}
 		break;
 		
@@ -106,26 +99,7 @@ void GDBMI::doFileCommand(FileCmd cmd, string arg)
 		
 		case FileCmd::FileExecWithSymbols:
 		{
-			string token = getTokenStr();
-			auto inferiorLoadCB = [&](GDBMI * obj, GDBResponse resp) -> void
-			{
-				setState(GDBState::Stopped, "Inferior loaded, not running");
-				obj->requestFunctionSymbols();
-				obj->requestGlobalVarSymbols();
-				
-				
-				string tok2 = obj->getTokenStr();
-				registerCallback(tok2, GDBMI::getregNamesCallbackThunk);
-				
-				sendCommand(tok2 + "-data-list-register-names");
-				
-				CallbackIter cb;
-				if(findCallback(resp.recordToken, cb) == true)
-					eraseCallback(cb);
-			};
-			
-			registerCallback(token, inferiorLoadCB);
-			sendCommand(token + string("-file-exec-and-symbols ") + arg);
+			loadInferior(string("-file-exec-and-symbols ") + arg);
 		}
 		break;
 		
@@ -140,38 +114,47 @@ void GDBMI::doFileCommand(FileCmd cmd, string arg)
 
 void GDBMI::attachToPID(string pid)
 {
-	string token = getTokenStr();
-	auto inferiorLoadCB = [&](GDBMI * obj, GDBResponse resp) -> void
+	loadInferior(string("-target-attach ") + pid);
+}
+
+GDBMI::CommandTask GDBMI::loadInferior(string loadCmd)
+{
+	// Reading the symbols of a big binary can take a while, so no timeout
+	MIResult loaded = co_await command(loadCmd, 0, OrderDomain::ExecState, 0);
+	
+	if(loaded.ok() == false)
 	{
-		setState(GDBState::Stopped, "Inferior loaded, not running");
-		obj->requestFunctionSymbols();
-		obj->requestGlobalVarSymbols();
-		
-		
-		string tok2 = obj->getTokenStr();
-		registerCallback(tok2, GDBMI::getregNamesCallbackThunk);
-		
-		sendCommand(tok2 + "-data-list-register-names");
-		
-		CallbackIter cb;
-		if(findCallback(resp.recordToken, cb) == true)
-			eraseCallback(cb);
-	};
+		logPrintf(LogLevel::Error, "Failed to load the inferior ('%s')\n", loadCmd.c_str());
+		co_return;
+	}
+	
+	setState(GDBState::Stopped, "Inferior loaded, not running");
+	
+	// None of these depend on each other, so they all go out at once
+	vector<CommandAwaiter> fetches;
+	fetches.push_back(command("-symbol-info-functions", GDBMI::getFuncSymbolsCallbackThunk, OrderDomain::Symbols, 0));
+	fetches.back().m_symbolList = SymbolListKind::Functions;
+	fetches.push_back(command("-symbol-info-variables", GDBMI::getGlobalVarSymbolsCallbackThunk, OrderDomain::Symbols, 0));
+	fetches.back().m_symbolList = SymbolListKind::Globals;
+	fetches.push_back(command("-data-list-register-names", GDBMI::getregNamesCallbackThunk, OrderDomain::Registers));
 	
-	registerCallback(token, inferiorLoadCB);
-	sendCommand(token + string("-target-attach ") + pid);
+	vector<MIResult> fetched = co_await whenAll(std::move(fetches));
+	
+	for(auto &res : fetched)
+	{
+		if(res.ok() == false)
+			logPrintf(LogLevel::Warn, "Fetching the inferior's data failed (token %u)\n", res.token);
+	}
 }
 
 void GDBMI::detachInferior()
 {
-	string token = getTokenStr();
 	auto detachCB = [](GDBMI * obj, GDBResponse resp) -> void
 	{
 		obj->refreshData();
 	};
 	
-	registerCallback(token, detachCB);
-	sendCommand("-target-detach");
+	sendCommand("-target-detach", detachCB, OrderDomain::ExecState);
 	refreshData();
 }
 
@@ -189,9 +172,7 @@ void GDBMI::insertBreakpointAtAddress(string addr)
 		obj->requestBreakpointList();
 	};
 	
-	string cmdToken = getTokenStr();
-	registerCallback(cmdToken, insertCB);
-	sendCommand(cmdToken + string("-break-insert *") + addr);
+	sendCommand(string("-break-insert *") + addr, insertCB, OrderDomain::Breakpoints);
 }
 
 void GDBMI::deleteBreakpoint(uint32_t bpNum)
@@ -201,7 +182,5 @@ void GDBMI::deleteBreakpoint(uint32_t bpNum)
 		obj->requestBreakpointList();
 	};
 	
-	string cmdToken = getTokenStr();
-	registerCallback(cmdToken, deleteCB);
-	sendCommand(cmdToken + string("-break-delete ") + std::to_string(bpNum));
+	sendCommand(string("-break-delete ") + std::to_string(bpNum), deleteCB, OrderDomain::Breakpoints);
 }
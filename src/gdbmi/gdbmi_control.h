@@ -59,6 +59,12 @@ class GDBMI
 		void insertBreakpointAtAddress(string addr);
 		void deleteBreakpoint(uint32_t bpNum);
 		
+	private:
+	
+		// Loads the inferior with 'loadCmd' (-file-exec-and-symbols or -target-attach),
+		// then fetches its symbols and register names
+		CommandTask loadInferior(string loadCmd);
+		
 // *INDENT-OFF*
 #ifndef SOMETHING_UNIQUE_GDBMI_H
 };
@@ -8,35 +8,27 @@ void GDBMI::evaluateExpr(string expr)
 	sendCommand(string("-data-evaluate-expression ") + expr);
 }
 
+// Symbol lookups on big binaries can take GDB a long time,
+// so these two don't time out
+
 void GDBMI::requestFunctionSymbols()
 {
-	string token = getTokenStr();
-	registerCallback(token, getFuncSymbolsCallbackThunk);
-	sendCommand(token + "-symbol-info-functions");
+	sendCoalesced("-symbol-info-functions", getFuncSymbolsCallbackThunk, OrderDomain::Symbols, false, 0, SymbolListKind::Functions);
 }
 
 void GDBMI::requestGlobalVarSymbols()
 {
-	string token = getTokenStr();
-	registerCallback(token, getGlobalVarSymbolsCallbackThunk);
-	sendCommand(token + "-symbol-info-variables");
+	sendCoalesced("-symbol-info-variables", getGlobalVarSymbolsCallbackThunk, OrderDomain::Symbols, false, 0, SymbolListKind::Globals);
 }
 
 void GDBMI::requestCurrentExecPos()
 {
 	auto updateCurrentPosCB = [](GDBMI * obj, GDBResponse r)
 	{
-		string data = r.recordData;
-		KVPair kvp = obj->parserGetKVPair(data);
-		
-		string rawPos = kvp.second;
+		// value="0x0000555555555131 <main+8>"
+		MIRecordView result(r.recordData);
+		string rawPos(result.get("value"));
 		
-		if(rawPos.front() == '"')
-			rawPos.erase(rawPos.begin());
-			
-		if(rawPos.back() == '"')
-			rawPos.pop_back();
-			
 		size_t pos = rawPos.find_first_of(' ');
 		
 		if(pos != string::npos)
@@ -57,45 +49,44 @@ void GDBMI::requestCurrentExecPos()
 		}
 	};
 	
-	string token = getTokenStr();
-	registerCallback(token, updateCurrentPosCB);
-	sendCommand(token + "-data-evaluate-expression $pc");
+	sendCoalesced("-data-evaluate-expression $pc", updateCurrentPosCB, OrderDomain::ExecState, true);
 }
 
 void GDBMI::requestDisassembleAddr(string addr)
 {
-	string token = getTokenStr();
-	registerCallback(token, getDisassemblyCallbackThunk);
-	sendCommand(token + string("-data-disassemble -a ") + addr + " 0");
+	sendCoalesced(string("-data-disassemble -a ") + addr + " 0", getDisassemblyCallbackThunk, OrderDomain::Disassembly, false);
+}
+
+void GDBMI::requestStopDisassembly(string addr, uint64_t pc)
+{
+	if(pc != 0 && showCachedDisassembly(pc))
+		return;
+		
+	sendCoalesced(string("-data-disassemble -a ") + addr + " 0", getDisassemblyCallbackThunk, OrderDomain::Disassembly, true);
 }
 
 void GDBMI::requestDisassembleLine(string file, string line)
 {
-	string token = getTokenStr();
-	registerCallback(token, getDisassemblyCallbackThunk);
-	sendCommand(token + string("-data-disassemble -f ") + file + string(" -l ") + line + " 0");
+	sendCoalesced(string("-data-disassemble -f ") + file + string(" -l ") + line + " 0", getDisassemblyCallbackThunk, OrderDomain::Disassembly, false);
 }
 
 void GDBMI::requestBreakpointList()
 {
-	string cmdToken = getTokenStr();
-	registerCallback(cmdToken, GDBMI::bpListCallbackThunk);
-	sendCommand(cmdToken + "-break-list");
+	sendCoalesced("-break-list", GDBMI::bpListCallbackThunk, OrderDomain::Breakpoints, false);
 }
 
 void GDBMI::requestRegisterInfo()
 {
-	string cmdToken = getTokenStr();
-	registerCallback(cmdToken, GDBMI::getregValsCallbackThunk);
-	sendCommand(cmdToken + "-data-list-register-values x");
+	// Only the registers GDB reports as changed are fetched again. The list
+	// isn't tied to the stop: GDB compares against the previous time it was
+	// asked, so a dropped reply would lose changes.
+	sendCoalesced("-data-list-changed-registers", GDBMI::getChangedRegsCallbackThunk, OrderDomain::Registers, false);
 }
 
 
 void GDBMI::requestBacktrace()
 {
-	string cmdToken = getTokenStr();
-	registerCallback(cmdToken, GDBMI::getStackFramesCallbackThunk);
-	sendCommand(cmdToken + "-stack-list-frames");
+	sendCoalesced("-stack-list-frames", GDBMI::getStackFramesCallbackThunk, OrderDomain::Backtrace, true);
 }
 
 void GDBMI::refreshData()
@@ -106,57 +97,287 @@ void GDBMI::refreshData()
 	requestFunctionSymbols();
 	requestGlobalVarSymbols();
 	requestCurrentExecPos();
-	requestDisassembleAddr("$pc");
+	requestStopDisassembly("$pc");
 }
 
 
-vector<GDBMI::SymbolObject> GDBMI::getFunctionSymbols()
+void GDBMI::sendCoalesced(string cmd, CmdCallback cb, OrderDomain domain, bool tiedToStop, uint32_t timeoutMs,
+						  SymbolListKind symbolList)
 {
-	vector<SymbolObject> ret;
-	m_funcSymMutex.lock();
-	ret = m_functionSymbols;
-	m_funcSymMutex.unlock();
+	m_inFlightMutex.lock();
+	auto inFlight = m_inFlightRequests.find(cmd);
 	
-	return ret;
+	if(inFlight != m_inFlightRequests.end())
+	{
+		// The trailing fetch goes out the way the latest caller asked for it
+		inFlight->second.tiedToStop = tiedToStop;
+		inFlight->second.trailing = true;
+		m_coalescedRequests++;
+		m_inFlightMutex.unlock();
+		
+		return;
+	}
+	
+	InFlightRequest &req = m_inFlightRequests[cmd];
+	req.callback = cb;
+	req.domain = domain;
+	req.timeoutMs = timeoutMs;
+	req.tiedToStop = tiedToStop;
+	req.symbolList = symbolList;
+	InFlightRequest toSend = req;
+	m_inFlightMutex.unlock();
+	
+	sendInFlight(cmd, toSend);
 }
 
-vector<GDBMI::SymbolObject> GDBMI::getGlobalVarSymbols()
+void GDBMI::sendInFlight(const string &cmd, const InFlightRequest &req)
 {
-	vector<SymbolObject> ret;
-	m_globalVarMutex.lock();
-	ret = m_globalVarSymbols;
-	m_globalVarMutex.unlock();
+	PendingCommand pc;
+	pc.callback = req.callback;
+	pc.domain = req.domain;
+	pc.symbolList = req.symbolList;
 	
-	return ret;
+	if(req.tiedToStop)
+		pc.stopGeneration = getStopGeneration();
+	
+	// Runs after 'cb', and also if the command fails or times out, so
+	// a request can't be left marked as in flight
+	pc.continuation = [this, cmd](MIResult &) { coalescedRequestDone(cmd); };
+	
+	submitCommand(cmd, std::move(pc), req.timeoutMs, CmdPriority::Auto);
 }
 
-vector<GDBMI::RegisterInfo> GDBMI::getRegisters()
+void GDBMI::coalescedRequestDone(const string &cmd)
 {
-	vector<RegisterInfo> ret;
-	m_regValListMutex.lock();
-	ret = m_regValList;
-	m_regValListMutex.unlock();
+	m_inFlightMutex.lock();
+	auto inFlight = m_inFlightRequests.find(cmd);
 	
-	return ret;
+	if(inFlight == m_inFlightRequests.end())
+	{
+		m_inFlightMutex.unlock();
+		return;
+	}
+	
+	if(inFlight->second.trailing == false || m_exitThreads)
+	{
+		m_inFlightRequests.erase(inFlight);
+		m_inFlightMutex.unlock();
+		
+		return;
+	}
+	
+	// The request stays in flight, now for the trailing fetch
+	inFlight->second.trailing = false;
+	InFlightRequest req = inFlight->second;
+	m_trailingFetches++;
+	m_inFlightMutex.unlock();
+	
+	sendInFlight(cmd, req);
 }
 
-vector<GDBMI::FrameInfo> GDBMI::getBacktrace()
+void GDBMI::streamSymbols()
 {
-	vector<FrameInfo> ret;
-	m_backtraceMutex.lock();
-	ret = m_backtrace;
-	m_backtraceMutex.unlock();
+	std::string_view partial = m_framer.partialLine();
 	
-	return ret;
+	if(m_symbolStream.parser == 0)
+	{
+		if(partial.length() < GDB_SYMBOL_STREAM_BYTES)
+			return;
+			
+		// 123^done,symbols={debug=[...
+		size_t tokenEnd = 0;
+		uint32_t token = 0;
+		while(tokenEnd < partial.length() && partial[tokenEnd] >= '0' && partial[tokenEnd] <= '9')
+			token = (token * 10) + (partial[tokenEnd++] - '0');
+			
+		const std::string_view resultStart = "^done,";
+		if(token == 0 || partial.substr(tokenEnd).starts_with("^done,symbols=") == false)
+			return;
+			
+		// Results tied to a stop are checked when they complete, which
+		// is too late for this
+		PendingCommand cmd;
+		if(findCallback(token, cmd) == false || cmd.stopGeneration != 0 || cmd.symbolList == SymbolListKind::None)
+			return;
+			
+		m_symbolStream.parser = std::make_unique<MISymbolStream>();
+		m_symbolStream.token = token;
+		m_symbolStream.functions = (cmd.symbolList == SymbolListKind::Functions);
+		m_symbolStream.published = 0;
+		m_symbolStream.before = m_symbolStream.functions ? m_functionSymbols.get() : m_globalVarSymbols.get();
+		
+		m_framer.consumePartial(tokenEnd + resultStart.length());
+		partial = m_framer.partialLine();
+	}
+	
+	m_symbolStream.parser->feed(partial);
+	m_framer.consumePartial(partial.length());
+	
+	// Each table published is at least twice as big as the last, so the
+	// copies cost no more than the table itself
+	SymbolTable &symbols = m_symbolStream.parser->symbols();
+	if(symbols.size() > 0 && symbols.size() >= m_symbolStream.published * 2)
+	{
+		m_symbolStream.published = symbols.size();
+		publishStreamedSymbols(m_symbolStream.functions, symbols.finishedCopy(), false);
+	}
+}
+
+void GDBMI::finishSymbolStream(std::string_view rest)
+{
+	SymbolStream stream = std::move(m_symbolStream);
+	m_symbolStream = SymbolStream();
+	
+	stream.parser->feed(rest);
+	bool functions = stream.functions;
+	
+	if(stream.parser->finish() == false)
+	{
+		logPrintf(LogLevel::Warn, "Symbol list (token %u) is malformed, keeping the one from before it\n", stream.token);
+		
+		// As if it hadn't been streamed: the partial tables published so far
+		// are replaced by the old one, which the search index was built from
+		if(stream.published > 0)
+		{
+			SymbolSnapshot before = stream.before;
+			
+			postTask(OrderDomain::Symbols, [this, before, functions]()
+			{
+				publishStreamedSymbols(functions, before->data.finishedCopy(), false);
+			});
+		}
+	}
+	else
+	{
+		// Published on the worker pool, where the search index can take its
+		// time, and ahead of the command's own callback
+		auto symbols = std::make_shared<SymbolTable>(std::move(stream.parser->symbols()));
+		
+		postTask(OrderDomain::Symbols, [this, symbols, functions]()
+		{
+			publishStreamedSymbols(functions, std::move(*symbols), true);
+		});
+	}
+	
+	// The data has been read already. The callback gets none, and just
+	// sends the event again.
+	handleResponse(std::to_string(stream.token) + "^done");
+}
+
+void GDBMI::publishStreamedSymbols(bool functions, SymbolTable symbols, bool complete)
+{
+	SnapshotCell<SymbolTable> &cell = functions ? m_functionSymbols : m_globalVarSymbols;
+	
+	cell.publish(std::move(symbols));
+	publishEvent(functions ? EventType::FunctionsChanged : EventType::GlobalsChanged);
+	
+	if(complete)
+		rebuildSearchIndex(functions ? SymbolKind::Function : SymbolKind::GlobalVar, cell.get());
+}
+
+bool GDBMI::showCachedDisassembly(uint64_t pc)
+{
+	m_disasCacheMutex.lock();
+	
+	DisasCacheEntry *found = 0;
+	for(auto &entry : m_disasCache)
+	{
+		if(pc >= entry.startAddr && pc <= entry.endAddr)
+		{
+			found = &entry;
+			break;
+		}
+	}
+	
+	if(found == 0)
+	{
+		m_disasCacheMisses++;
+		m_disasCacheMutex.unlock();
+		
+		return false;
+	}
+	
+	m_disasCacheHits++;
+	found->lastUse = ++m_disasCacheClock;
+	
+	// Still stepping through the function on screen; only the PC moved
+	if(found->shownVersion == m_disasLines.version())
+	{
+		m_disasCacheMutex.unlock();
+		return true;
+	}
+	
+	Event ev;
+	ev.type = EventType::DisassemblyChanged;
+	ev.startAddr = found->startAddr;
+	ev.endAddr = found->endAddr;
+	
+	// Published under the lock so shownVersion matches what's in m_disasLines
+	found->shownVersion = m_disasLines.publish(found->lines);
+	m_disasCacheMutex.unlock();
+	
+	publishEvent(std::move(ev));
+	return true;
+}
+
+void GDBMI::cacheDisassembly(vector<DisassemblyInstruction> lines, uint64_t version)
+{
+	if(lines.size() == 0)
+		return;
+		
+	DisasCacheEntry entry;
+	entry.startAddr = lines.front().address;
+	entry.endAddr = lines.back().address;
+	entry.lines = std::move(lines);
+	entry.shownVersion = version;
+	
+	m_disasCacheMutex.lock();
+	entry.lastUse = ++m_disasCacheClock;
+	
+	// A fresh copy of a function replaces anything overlapping it
+	for(auto it = m_disasCache.begin(); it != m_disasCache.end();)
+	{
+		if(it->startAddr <= entry.endAddr && entry.startAddr <= it->endAddr)
+			it = m_disasCache.erase(it);
+		else
+			it++;
+	}
+	
+	if(m_disasCache.size() >= GDB_DISAS_CACHE_ENTRIES)
+	{
+		auto oldest = std::min_element(m_disasCache.begin(), m_disasCache.end(),
+									   [](const DisasCacheEntry & a, const DisasCacheEntry & b) { return a.lastUse < b.lastUse; });
+		m_disasCache.erase(oldest);
+	}
+	
+	m_disasCache.push_back(std::move(entry));
+	m_disasCacheMutex.unlock();
+}
+
+void GDBMI::invalidateDisasCache()
+{
+	m_disasCacheMutex.lock();
+	if(m_disasCache.size() > 0)
+	{
+		m_disasCache.clear();
+		m_disasCacheInvalidations++;
+	}
+	m_disasCacheMutex.unlock();
 }
 
-vector<GDBMI::BreakpointInfo> GDBMI::getBpList()
+GDBMI::DisasCacheStats GDBMI::getDisasCacheStats()
 {
-	vector<BreakpointInfo> ret;
-	m_breakPointMutex.lock();
-	ret = m_breakPointList;
-	m_breakPointMutex.unlock();
+	DisasCacheStats ret;
+	m_disasCacheMutex.lock();
+	ret.hits = m_disasCacheHits;
+	ret.misses = m_disasCacheMisses;
+	ret.invalidations = m_disasCacheInvalidations;
+	ret.entries = m_disasCache.size();
+	m_disasCacheMutex.unlock();
 	
+	if(ret.hits + ret.misses > 0)
+		ret.hitRate = (double) ret.hits / (ret.hits + ret.misses);
+		
 	return ret;
 }
 
@@ -170,16 +391,6 @@ GDBMI::CurrentInstruction GDBMI::getCurrentExecutionPos()
 	return ret;
 }
 
-vector<GDBMI::DisassemblyInstruction> GDBMI::getDisassembly()
-{
-	vector<DisassemblyInstruction> ret;
-	m_disasLinesMutex.lock();
-	ret = m_disasLines;
-	m_disasLinesMutex.unlock();
-	
-	return ret;
-}
-
 GDBMI::StepFrame GDBMI::getStepFrame()
 {
 	StepFrame ret;
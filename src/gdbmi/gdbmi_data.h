@@ -10,34 +10,21 @@ class GDBMI
 #endif
 	public:
 	
-		enum class UpdateType : uint64_t
-		{
-			FuncSymbols 	= (1 << 0),
-			GVarSymbols 	= (1 << 1),
-			Disassembly 	= (1 << 2),
-			RegisterInfo	= (1 << 3),
-			Backtrace		= (1 << 4),
-			BreakPtList		= (1 << 5)
-		};
-		
-		typedef void (*NotifyCallback)(UpdateType updType, void *userData);
 		typedef pair<uint64_t, string> CurrentInstruction;
 		
-		// These are all the structures used to contain data available via the API
-		struct SymbolObject
-		{
-			bool isActive;
-			string fullPath;
-			string shortName;
-			string lineNumber;
-			string name;
-			string type;
-			string description;
-		};
+		// What the list getters below hand out: an immutable, versioned snapshot
+		// (see gdbmi_snapshot.h). Getting one is a pointer copy. The list in
+		// ->data never changes, and stays valid for as long as it's held.
+		template<typename T>
+		using Snapshot = typename SnapshotCell<vector<T>>::Ptr;
+		
+		// Symbols come in a SymbolTable (gdbmi_symtab.h) rather than a list
+		typedef SnapshotCell<SymbolTable>::Ptr SymbolSnapshot;
 		
+		// These are all the structures used to contain data available via the API
 		struct DisassemblyInstruction
 		{
-			uint64_t address;
+			uint64_t address = 0;
 			string addrStr;
 			string funcName;
 			string offset;
@@ -61,7 +48,8 @@ class GDBMI
 		{
 			string regName;
 			string regValue;
-			uint32_t regSize; // Size of register in bytes (rax = 8, eax = 4, etc)
+			uint32_t regNum = 0; // GDB's register number, also the index into getRegisters()
+			uint32_t regSize = 0; // Size of register in bytes (rax = 8, eax = 4, etc)
 			bool updated = false;
 		};
 		
@@ -91,46 +79,87 @@ class GDBMI
 			uint32_t number = 0;
 			string type; // Breakpoint or watchpoint
 			string disp; // Keep or nokeep
-			bool enabled;
+			bool enabled = false;
 			string addr;
 			string func;
 			string fullname;
 			string file;
-			uint32_t line;
-			uint32_t times; // Hit count
+			uint32_t line = 0;
+			uint32_t times = 0; // Hit count
 		};
 		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
 	private:
-	
-		vector<SymbolObject> m_functionSymbols;
-		vector<SymbolObject> m_globalVarSymbols;
-		mutex m_funcSymMutex;
-		mutex m_globalVarMutex;
+		#endif
+		
+		// Where the fields of the tuples in each kind of record go, for the
+		// callbacks in gdbmi_handlers_cb.cpp (see gdbmi_mibind.h)
+		static constexpr auto disassemblySchema = miSchema<DisassemblyInstruction>(
+					MIField(MIKey::Address, &DisassemblyInstruction::address),
+					MIField(MIKey::Address, &DisassemblyInstruction::addrStr),
+					MIField(MIKey::FuncName, &DisassemblyInstruction::funcName),
+					MIField(MIKey::Offset, &DisassemblyInstruction::offset),
+					MIField(MIKey::Inst, &DisassemblyInstruction::instruction));
+					
+		static constexpr auto breakpointSchema = miSchema<BreakpointInfo>(
+					MIField(MIKey::Number, &BreakpointInfo::number),
+					MIField(MIKey::Type, &BreakpointInfo::type),
+					MIField(MIKey::Disp, &BreakpointInfo::disp),
+					MIField(MIKey::Enabled, &BreakpointInfo::enabled),
+					MIField(MIKey::Addr, &BreakpointInfo::addr),
+					MIField(MIKey::Func, &BreakpointInfo::func),
+					MIField(MIKey::Fullname, &BreakpointInfo::fullname),
+					MIField(MIKey::File, &BreakpointInfo::file),
+					MIField(MIKey::Line, &BreakpointInfo::line),
+					MIField(MIKey::Times, &BreakpointInfo::times));
+					
+		// {number="1",value="0x1c"}
+		static constexpr auto registerValueSchema = miSchema<RegisterInfo>(
+					MIField(MIKey::Number, &RegisterInfo::regNum),
+					MIField(MIKey::Value, &RegisterInfo::regValue));
+					
+		static constexpr auto frameSchema = miSchema<FrameInfo>(
+					MIField(MIKey::Level, &FrameInfo::level),
+					MIField(MIKey::Addr, &FrameInfo::addr),
+					MIField(MIKey::Func, &FrameInfo::func),
+					MIField(MIKey::File, &FrameInfo::file),
+					MIField(MIKey::Fullname, &FrameInfo::fullname),
+					MIField(MIKey::Line, &FrameInfo::line),
+					MIField(MIKey::Arch, &FrameInfo::arch));
+					
+		static constexpr auto frameVariableSchema = miSchema<FrameVariable>(
+					MIField(MIKey::Name, &FrameVariable::name),
+					MIField(MIKey::Arg, &FrameVariable::isArg),
+					MIField(MIKey::Type, &FrameVariable::type),
+					MIField(MIKey::Value, &FrameVariable::value));
+					
+		// Written by replacing the whole list, never in place
+		SnapshotCell<SymbolTable> m_functionSymbols;
+		SnapshotCell<SymbolTable> m_globalVarSymbols;
 		
 		// pair<$pc addr, func name>
 		CurrentInstruction m_currentExecPos;
 		mutex m_curExecPosMutex;
 		
-		vector<DisassemblyInstruction> m_disasLines;
-		mutex m_disasLinesMutex;
+		SnapshotCell<vector<DisassemblyInstruction>> m_disasLines;
 		
 		StepFrame m_stepFrame;
 		mutex m_stepFrameMutex;
 		
-		NotifyCallback m_notifyCallback = 0;
-		void *m_notifyUserData = 0;
-		
 		mutex m_regNameListMutex;
 		vector<string> m_regNameList;
 		
-		mutex m_regValListMutex;
-		vector<RegisterInfo> m_regValList;
-		
-		mutex m_backtraceMutex;
-		vector<FrameInfo> m_backtrace;
+		// Indexed by register number, like m_regValList. Set for registers GDB
+		// reported as changed whose new value hasn't come in yet, so a fetch
+		// dropped for belonging to an older stop gets retried on the next one.
+		vector<bool> m_regStale;
 		
-		mutex m_breakPointMutex;
-		vector<BreakpointInfo> m_breakPointList;
+		// Indexed by register number; registers without a name are left empty
+		SnapshotCell<vector<RegisterInfo>> m_regValList;
+		SnapshotCell<vector<FrameInfo>> m_backtrace;
+		SnapshotCell<vector<BreakpointInfo>> m_breakPointList;
 		
 		void requestFunctionSymbols();
 		void requestGlobalVarSymbols();
@@ -140,11 +169,106 @@ class GDBMI
 		
 		void requestCurrentExecPos();
 		
+		// Disassembly around where the inferior stopped. Unlike requestDisassembleAddr(),
+		// the result is dropped if the inferior has moved on by the time it arrives.
+		// If 'pc' is known and inside a function in the disassembly cache, GDB
+		// isn't asked at all.
+		void requestStopDisassembly(string addr, uint64_t pc = 0);
+		
+		// One function's disassembly, as returned by -data-disassemble
+		struct DisasCacheEntry
+		{
+			uint64_t startAddr;
+			uint64_t endAddr; // Address of the last instruction
+			vector<DisassemblyInstruction> lines;
+			uint64_t shownVersion;	// m_disasLines version when it was last published
+			uint64_t lastUse;
+		};
+		
+		// Publishes the cached function containing 'pc', unless it's already
+		// the one in m_disasLines. Returns false if no cached function has it.
+		bool showCachedDisassembly(uint64_t pc);
+		
+		// Fills 'insts' from a -data-disassemble result (in
+		// gdbmi_handlers_cb.cpp). Returns false if the result isn't a listing.
+		bool parseDisassembly(std::string_view rawData, vector<DisassemblyInstruction> &insts);
+		
+		// Called with each disassembly published from a GDB result
+		void cacheDisassembly(vector<DisassemblyInstruction> lines, uint64_t version);
+		
+		// The code may have changed (libraries, memory writes, breakpoints)
+		void invalidateDisasCache();
+		
+		vector<DisasCacheEntry> m_disasCache;
+		mutex m_disasCacheMutex;
+		uint64_t m_disasCacheClock = 0;
+		uint64_t m_disasCacheHits = 0;
+		uint64_t m_disasCacheMisses = 0;
+		uint64_t m_disasCacheInvalidations = 0;
+		
+		struct InFlightRequest
+		{
+			CmdCallback callback = 0;
+			OrderDomain domain = OrderDomain::None;
+			uint32_t timeoutMs = 0;
+			bool tiedToStop = false;	// Sent with the stop generation (see getStopGeneration())
+			bool trailing = false;		// Someone asked again while this one was in flight
+			SymbolListKind symbolList = SymbolListKind::None;
+		};
+		
+		// Coalescing of data requests. Sends 'cmd' unless the same command is
+		// still waiting for its result, in which case the caller joins it. The
+		// data may have changed after the request in flight was sent, so once
+		// it completes one more (trailing) fetch goes out, however many callers
+		// joined in the meantime.
+		// If tiedToStop is set, a result that arrives after the inferior has
+		// started or stopped again is dropped unparsed (see completeCommand()).
+		void sendCoalesced(string cmd, CmdCallback cb, OrderDomain domain, bool tiedToStop,
+						   uint32_t timeoutMs = GDB_COMMAND_TIMEOUT_MS, SymbolListKind symbolList = SymbolListKind::None);
+						   
+		// Sends the request for 'cmd' that's marked in flight
+		void sendInFlight(const string &cmd, const InFlightRequest &req);
+		
+		// Called when the request for 'cmd' completes, however it completes
+		void coalescedRequestDone(const string &cmd);
+		
+		// Keyed by the command text (without the token)
+		std::map<string, InFlightRequest> m_inFlightRequests;
+		mutex m_inFlightMutex;
+		uint64_t m_coalescedRequests = 0;
+		uint64_t m_trailingFetches = 0;
+		
+		// Called by the read thread with a line that hasn't been finished yet
+		// in m_framer. Once it's a -symbol-info-functions or
+		// -symbol-info-variables result over GDB_SYMBOL_STREAM_BYTES long,
+		// it's taken out of the framer and parsed as it comes in (see
+		// gdbmi_symstream.h), and the table is published as it grows.
+		void streamSymbols();
+		
+		// The rest of the streamed line, once its newline has been read.
+		// The command is answered with a result record without the data.
+		// A list that doesn't parse to the end is dropped, and the table
+		// from before it is published again.
+		void finishSymbolStream(std::string_view rest);
+		
+		// Publishes a table read by streamSymbols(). The search index is only
+		// rebuilt for the whole list.
+		void publishStreamedSymbols(bool functions, SymbolTable symbols, bool complete);
+		
+		// Only touched by the read thread
+		struct SymbolStream
+		{
+			std::unique_ptr<MISymbolStream> parser;
+			uint32_t token = 0;
+			bool functions = true;
+			size_t published = 0;	// Symbols in the last table published
+			SymbolSnapshot before;	// Put back if the list is cut short
+		};
+		
+		SymbolStream m_symbolStream;
+		
 	public:
 	
-		void setNotifyCallback(NotifyCallback cbFunc, void *userData = 0)
-		{ m_notifyCallback = cbFunc; m_notifyUserData = userData; }
-		
 		void evaluateExpr(string expr);
 		
 		void requestDisassembleAddr(string addr);
@@ -153,14 +277,25 @@ class GDBMI
 		
 		void refreshData();
 		
-		vector<SymbolObject> getFunctionSymbols();
-		vector<SymbolObject> getGlobalVarSymbols();
-		vector<RegisterInfo> getRegisters();
-		vector<FrameInfo> getBacktrace();
-		vector<BreakpointInfo> getBpList();
+		SymbolSnapshot getFunctionSymbols()					{ return m_functionSymbols.get(); }
+		SymbolSnapshot getGlobalVarSymbols()				{ return m_globalVarSymbols.get(); }
+		Snapshot<RegisterInfo> getRegisters()				{ return m_regValList.get(); }
+		Snapshot<FrameInfo> getBacktrace()					{ return m_backtrace.get(); }
+		Snapshot<BreakpointInfo> getBpList()				{ return m_breakPointList.get(); }
+		Snapshot<DisassemblyInstruction> getDisassembly()	{ return m_disasLines.get(); }
 		
 		CurrentInstruction getCurrentExecutionPos();
-		vector<DisassemblyInstruction> getDisassembly();
+		
+		struct DisasCacheStats
+		{
+			uint64_t hits = 0;			// Stops whose disassembly came from the cache
+			uint64_t misses = 0;		// Stops that had to ask GDB
+			uint64_t invalidations = 0;
+			uint32_t entries = 0;
+			double hitRate = 0;			// hits / (hits + misses)
+		};
+		
+		DisasCacheStats getDisasCacheStats();
 		
 		StepFrame getStepFrame();
 		
@@ -0,0 +1,155 @@
+#include "gdbmi_private.h"
+
+#include "gdbmi.h"
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+// #include "gdbmi_events.h"
+#endif
+
+// Adds the entries of 'from' that 'to' doesn't have yet
+static void mergeNumbers(vector<uint32_t> &to, const vector<uint32_t> &from)
+{
+	for(uint32_t num : from)
+	{
+		if(std::find(to.begin(), to.end(), num) == to.end())
+			to.push_back(num);
+	}
+}
+
+void GDBMI::initEvents()
+{
+
+}
+
+void GDBMI::destroyEvents()
+{
+	m_eventMutex.lock();
+	m_eventSubscribers.clear();
+	m_pendingEvents.clear();
+	m_eventMutex.unlock();
+}
+
+uint32_t GDBMI::subscribe(uint32_t typeMask, EventCallback cb)
+{
+	EventSubscriber sub;
+	sub.typeMask = typeMask;
+	sub.callback = cb;
+	
+	m_eventMutex.lock();
+	sub.id = m_nextSubscriberID++;
+	m_eventSubscribers.push_back(sub);
+	m_eventMutex.unlock();
+	
+	return sub.id;
+}
+
+void GDBMI::unsubscribe(uint32_t id)
+{
+	m_eventMutex.lock();
+	for(auto it = m_eventSubscribers.begin(); it != m_eventSubscribers.end(); it++)
+	{
+		if(it->id == id)
+		{
+			m_eventSubscribers.erase(it);
+			break;
+		}
+	}
+	
+	// From inside a callback the batch can't be waited for, but the loop
+	// in deliverEvents() skips the subscriber from here on
+	bool fromCallback = (m_eventDeliveryThread == std::this_thread::get_id());
+	m_eventMutex.unlock();
+	
+	// Waits for a batch that's being delivered to finish
+	if(fromCallback == false)
+	{
+		m_eventDeliveryMutex.lock();
+		m_eventDeliveryMutex.unlock();
+	}
+}
+
+void GDBMI::publishEvent(Event ev)
+{
+	if(ev.stopGeneration == 0)
+		ev.stopGeneration = getStopGeneration();
+		
+	m_eventMutex.lock();
+	
+	if(m_eventSubscribers.size() == 0 || m_exitThreads)
+	{
+		m_eventMutex.unlock();
+		return;
+	}
+	
+	// Subscribers re-read the data when they get the event, so one
+	// event per type and stop is enough; just keep the details
+	Event *pending = 0;
+	for(auto &queued : m_pendingEvents)
+	{
+		if(queued.type == ev.type && queued.stopGeneration == ev.stopGeneration)
+		{
+			pending = &queued;
+			break;
+		}
+	}
+	
+	if(pending != 0)
+	{
+		mergeNumbers(pending->registers, ev.registers);
+		mergeNumbers(pending->bpAdded, ev.bpAdded);
+		mergeNumbers(pending->bpRemoved, ev.bpRemoved);
+		mergeNumbers(pending->bpModified, ev.bpModified);
+		pending->startAddr = ev.startAddr;
+		pending->endAddr = ev.endAddr;
+	}
+	else m_pendingEvents.push_back(std::move(ev));
+	
+	bool schedule = (m_eventDeliveryScheduled == false);
+	m_eventDeliveryScheduled = true;
+	m_eventMutex.unlock();
+	
+	// Everything published until the task runs goes out in the same batch
+	if(schedule)
+		postTask(OrderDomain::Events, [this]() { deliverEvents(); });
+}
+
+void GDBMI::deliverEvents()
+{
+	vector<Event> batch;
+	vector<EventSubscriber> subscribers;
+	
+	// Held while the callbacks run, so unsubscribe() can wait for them
+	std::lock_guard<mutex> delivery(m_eventDeliveryMutex);
+	
+	m_eventMutex.lock();
+	batch.swap(m_pendingEvents);
+	subscribers = m_eventSubscribers;
+	m_eventDeliveryScheduled = false;
+	m_eventDeliveryThread = std::this_thread::get_id();
+	m_eventMutex.unlock();
+	
+	for(auto &sub : subscribers)
+	{
+		vector<Event> wanted;
+		for(auto &ev : batch)
+		{
+			if((sub.typeMask & (uint32_t) ev.type) != 0)
+				wanted.push_back(ev);
+		}
+		
+		if(wanted.size() == 0)
+			continue;
+			
+		// An earlier callback in this batch may have unsubscribed it
+		m_eventMutex.lock();
+		bool subscribed = std::any_of(m_eventSubscribers.begin(), m_eventSubscribers.end(),
+									  [&](const EventSubscriber & s) { return s.id == sub.id; });
+		m_eventMutex.unlock();
+		
+		if(subscribed)
+			sub.callback(this, wanted);
+	}
+	
+	m_eventMutex.lock();
+	m_eventDeliveryThread = std::thread::id();
+	m_eventMutex.unlock();
+}
@@ -0,0 +1,116 @@
+#ifndef UNIQUE_GDBMI_EVENTS_H
+#define UNIQUE_GDBMI_EVENTS_H
+
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_private.h"
+
+class GDBMI
+{
+
+#define SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_handlers.h"
+#undef SOMETHING_UNIQUE_GDBMI_H
+
+#endif
+
+	public:
+	
+		// Bit flags, so subscribers can ask for several types at once
+		enum class EventType : uint32_t
+		{
+			FunctionsChanged	= (1 << 0),	// getFunctionSymbols()
+			GlobalsChanged		= (1 << 1),	// getGlobalVarSymbols()
+			DisassemblyChanged	= (1 << 2),	// getDisassembly()
+			RegistersChanged	= (1 << 3),	// getRegisters()
+			BacktraceChanged	= (1 << 4),	// getBacktrace()
+			BreakpointsChanged	= (1 << 5),	// getBpList()
+			SearchResultsReady	= (1 << 6),	// getSearchResults()
+			
+			All					= 0xFFFFFFFF
+		};
+		
+		struct Event
+		{
+			EventType type;
+			uint32_t stopGeneration = 0; // getStopGeneration() when the data was updated
+			
+			// RegistersChanged: numbers (also indices into getRegisters()) of
+			// the registers whose value differs from the previous list
+			vector<uint32_t> registers;
+			
+			// DisassemblyChanged: first and last instruction address now held,
+			// both 0 if the disassembly was cleared
+			uint64_t startAddr = 0;
+			uint64_t endAddr = 0;
+			
+			// BreakpointsChanged: breakpoint numbers, compared to the previous list
+			vector<uint32_t> bpAdded;
+			vector<uint32_t> bpRemoved;
+			vector<uint32_t> bpModified;
+		};
+		
+		// Events are delivered in batches. A batch holds everything published
+		// while the previous one was being delivered, with at most one event
+		// per type and stop generation; see publishEvent().
+		typedef function<void(GDBMI *, const vector<Event> &)> EventCallback;
+		
+		// Calls 'cb' with the events whose type is in 'typeMask' (EventType flags
+		// OR'd together). Callbacks run on the worker pool, one batch at a time and
+		// in publishing order, so they should hand off anything slow.
+		// Returns an ID for unsubscribe().
+		uint32_t subscribe(uint32_t typeMask, EventCallback cb);
+		uint32_t subscribe(EventType type, EventCallback cb) { return subscribe((uint32_t) type, cb); }
+		
+		// If a batch is being delivered, waits for it to finish, so the
+		// callback isn't running and won't run again once this returns. From
+		// inside a callback it returns straight away; the rest of the batch
+		// skips the subscriber.
+		void unsubscribe(uint32_t id);
+		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		// Called by the GDBMI constructor
+		void initEvents();
+		
+		// Called by the GDBMI destructor
+		void destroyEvents();
+		
+		// Queues an event for the subscribers. If the batch waiting to go out
+		// already has one of this type for the same stop, the two are merged.
+		void publishEvent(Event ev);
+		void publishEvent(EventType type) { Event ev; ev.type = type; publishEvent(std::move(ev)); }
+		
+		// Hands the pending batch to the subscribers. Runs on the worker pool.
+		void deliverEvents();
+		
+		struct EventSubscriber
+		{
+			uint32_t id;
+			uint32_t typeMask;
+			EventCallback callback;
+		};
+		
+		vector<EventSubscriber> m_eventSubscribers;
+		uint32_t m_nextSubscriberID = 1;
+		
+		vector<Event> m_pendingEvents;
+		bool m_eventDeliveryScheduled = false;
+		std::thread::id m_eventDeliveryThread;	// Running deliverEvents(), if any
+		mutex m_eventMutex;
+		
+		// Held by deliverEvents() while it calls the subscribers
+		mutex m_eventDeliveryMutex;
+		
+		
+		
+// *INDENT-OFF*
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+};
+#endif
+// *INDENT-ON*
+
+#endif
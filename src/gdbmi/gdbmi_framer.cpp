@@ -0,0 +1,88 @@
+#include "gdbmi_framer.h"
+
+#include <cstring>
+#include <algorithm>
+
+MILineFramer::MILineFramer(size_t initialSize)
+{
+	m_buffer.resize(initialSize > 0 ? initialSize : 4096);
+}
+
+char *MILineFramer::writePtr(size_t minFree)
+{
+	if(freeSpace() >= minFree)
+		return m_buffer.data() + m_writePos;
+		
+	// Move the unconsumed tail to the front of the buffer. This only
+	// happens when we run out of room, and it only copies the partial line.
+	if(m_readPos > 0)
+	{
+		size_t tail = m_writePos - m_readPos;
+		memmove(m_buffer.data(), m_buffer.data() + m_readPos, tail);
+		
+		m_scanPos -= m_readPos;
+		m_writePos = tail;
+		m_readPos = 0;
+	}
+	
+	if(freeSpace() < minFree)
+	{
+		size_t newSize = m_buffer.size() * 2;
+		while(newSize - m_writePos < minFree)
+			newSize *= 2;
+			
+		m_buffer.resize(newSize);
+	}
+	
+	return m_buffer.data() + m_writePos;
+}
+
+void MILineFramer::commit(size_t len)
+{
+	if(len > freeSpace())
+		len = freeSpace();
+		
+	m_writePos += len;
+}
+
+bool MILineFramer::nextLine(std::string_view &line)
+{
+	while(m_scanPos < m_writePos)
+	{
+		const char *base = m_buffer.data();
+		const char *nl = (const char *) memchr(base + m_scanPos, '\n', m_writePos - m_scanPos);
+		
+		if(nl == 0)
+		{
+			// Partial line. Remember where we stopped so these bytes
+			// aren't scanned again when more data arrives.
+			m_scanPos = m_writePos;
+			return false;
+		}
+		
+		size_t nlPos = nl - base;
+		size_t start = m_readPos;
+		
+		m_readPos = m_scanPos = nlPos + 1;
+		
+		if(nlPos == start) // Empty line
+			continue;
+			
+		line = std::string_view(base + start, nlPos - start);
+		return true;
+	}
+	
+	// Everything has been handed out, so the next write can start at the front
+	if(m_readPos == m_writePos)
+		reset();
+		
+	return false;
+}
+
+void MILineFramer::consumePartial(size_t len)
+{
+	m_readPos += std::min(len, pending());
+	
+	if(m_readPos == m_writePos)
+		reset();
+}
@@ -0,0 +1,66 @@
+#ifndef UNIQUE_GDBMI_FRAMER_H
+#define UNIQUE_GDBMI_FRAMER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string_view>
+
+/*
+	Splits the raw byte stream coming from GDB into MI records (lines).
+
+	Data is read straight into the framer's buffer using writePtr() and
+	commit(), and complete lines are handed out by nextLine() as views
+	into that same buffer, so nothing is copied on the way through.
+	Every byte is scanned for a newline exactly once, no matter how many
+	read() calls a line is split across.
+
+	A view returned by nextLine() stays valid until the next call to
+	writePtr(), which may compact or grow the buffer.
+*/
+
+class MILineFramer
+{
+	public:
+	
+		MILineFramer(size_t initialSize = 64 * 1024);
+		
+		// Returns a pointer to at least minFree bytes of free space at the
+		// end of the buffered data. Lines that have already been handed out
+		// are compacted away first, and the buffer grows if it has to.
+		char *writePtr(size_t minFree);
+		
+		// Bytes available at writePtr()
+		size_t freeSpace() const { return m_buffer.size() - m_writePos; }
+		
+		// Marks 'len' bytes written at writePtr() as valid data
+		void commit(size_t len);
+		
+		// Gets the next complete line without its trailing newline.
+		// Empty lines are skipped. Returns false if no complete line is buffered.
+		bool nextLine(std::string_view &line);
+		
+		// Number of bytes buffered that haven't been handed out as a line yet
+		size_t pending() const { return m_writePos - m_readPos; }
+		
+		// The start of a line that hasn't been finished yet, once nextLine()
+		// has returned false
+		std::string_view partialLine() const { return std::string_view(m_buffer.data() + m_readPos, m_writePos - m_readPos); }
+		
+		// Drops the first 'len' bytes of partialLine(), for a reader that
+		// takes a long line in pieces. nextLine() hands out the rest of it.
+		void consumePartial(size_t len);
+		
+		size_t capacity() const { return m_buffer.size(); }
+		
+		void reset() { m_readPos = m_scanPos = m_writePos = 0; }
+		
+	private:
+	
+		std::vector<char> m_buffer;
+		size_t m_readPos = 0;	// First byte not handed out yet
+		size_t m_scanPos = 0;	// Where the newline search resumes
+		size_t m_writePos = 0;	// End of the valid data
+};
+
+#endif
@@ -9,73 +9,72 @@
 
 void GDBMI::initHandlers()
 {
-	m_randOffset = 0;
-	fillRandPool();
+	registerClassCallback(RecordClass::Running, GDBMI::runningCallbackThunk, OrderDomain::ExecState);
+	registerClassCallback(RecordClass::Stopped, GDBMI::stoppedCallbackThunk, OrderDomain::ExecState);
+	registerClassCallback(RecordClass::EndSteppingRange, GDBMI::stoppedCallbackThunk, OrderDomain::ExecState);
 	
-	registerCallback("running", GDBMI::runningCallbackThunk);
-	registerCallback("stopped", GDBMI::stoppedCallbackThunk);
-	registerCallback("end-stepping-range", GDBMI::stoppedCallbackThunk);
+	registerClassCallback(RecordClass::LibraryLoaded, GDBMI::libLoadedCallbackThunk);
+	registerClassCallback(RecordClass::LibraryUnloaded, GDBMI::libUnloadedCallbackThunk);
+	registerClassCallback(RecordClass::MemoryChanged, GDBMI::memChangedCallbackThunk);
 	
-	registerCallback("library-loaded", GDBMI::libLoadedCallbackThunk);
-	registerCallback("library-unloaded", GDBMI::libUnloadedCallbackThunk);
+	registerClassCallback(RecordClass::BreakpointCreated, GDBMI::bpCreatedCallbackThunk, OrderDomain::Breakpoints);
+	registerClassCallback(RecordClass::BreakpointModified, GDBMI::bpModifiedCallbackThunk, OrderDomain::Breakpoints);
+	registerClassCallback(RecordClass::BreakpointDeleted, GDBMI::bpDeletedCallbackThunk, OrderDomain::Breakpoints);
+	registerClassCallback(RecordClass::BreakpointHit, GDBMI::bpHitCallbackThunk, OrderDomain::Breakpoints);
 	
-	registerCallback("breakpoint-created", GDBMI::bpCreatedCallbackThunk);
-	registerCallback("breakpoint-modified", GDBMI::bpModifiedCallbackThunk);
-	registerCallback("breakpoint-deleted", GDBMI::bpDeletedCallbackThunk);
-	registerCallback("breakpoint-hit", GDBMI::bpHitCallbackThunk);
+	registerClassCallback(RecordClass::ThreadCreated, GDBMI::threadCreatedCallbackThunk);
+	registerClassCallback(RecordClass::ThreadSelected, GDBMI::threadSelectedCallbackThunk);
+	registerClassCallback(RecordClass::ThreadExited, GDBMI::threadExitedCallbackThunk);
 	
-	registerCallback("thread-created", GDBMI::threadCreatedCallbackThunk);
-	registerCallback("thread-selected", GDBMI::threadSelectedCallbackThunk);
-	registerCallback("thread-exited", GDBMI::threadExitedCallbackThunk);
 	
+	uint32_t workerCount = m_launchOptions.handlerThreads;
+	if(workerCount == 0)
+		workerCount = 1;
+		
+	m_dispatchStats.workerCount = workerCount;
 	
-	m_dispatchThread = thread(GDBMI::handlerDispatchThreadThunk, this);
+	for(uint32_t i = 0; i < workerCount; i++)
+		m_workerThreads.push_back(thread(GDBMI::handlerWorkerThreadThunk, this));
 }
 
 void GDBMI::destroyHandlers()
 {
-	m_dispatchThread.join();
-}
-
-void GDBMI::sendCommand(string cmd)
-{
-	if(*(cmd.end() - 1) != '\n')
-		cmd += "\n";
-		
-	string logCmd("Sending: ");
-	logCmd += cmd;
-	logPrintf(LogLevel::Verbose, logCmd.c_str());
+	// m_exitThreads is already set, so the workers exit once they're woken up
+	m_responseQueueMutex.lock();
+	m_responseQueueMutex.unlock();
+	m_responseQueueCond.notify_all();
 	
-	m_sendCmdMutex.lock();
-	writePipe(cmd);
-	m_sendCmdMutex.unlock();
+	for(auto &worker : m_workerThreads)
+		worker.join();
+		
+	m_workerThreads.clear();
 }
 
-void GDBMI::handleResponse(string &responseStr)
+void GDBMI::handleResponse(std::string_view responseStr)
 {
 	static bool allowGDBConsole = false;
 	if(responseStr.length() == 0)
 		return;
 		
-	int32_t tokenEnd = -1;
-	for(int32_t i = 0; i < (int32_t) responseStr.length(); i++)
+	GDBResponse resp;
+	
+	// Parse the token straight into an integer. Tokens longer than
+	// ours can't match a pending command, so they just wrap around.
+	size_t tokenEnd = 0;
+	uint32_t token = 0;
+	while(tokenEnd < responseStr.length() && responseStr[tokenEnd] >= '0' && responseStr[tokenEnd] <= '9')
 	{
-		if(responseStr[i] >= '0' && responseStr[i] <= '9')
-			continue;
-			
-		tokenEnd = i;
-		break;
+		token = (token * 10) + (responseStr[tokenEnd] - '0');
+		tokenEnd++;
 	}
 	
-	GDBResponse resp;
-	
-	if(tokenEnd > 0)
+	if(tokenEnd < responseStr.length())
 	{
-		resp.recordToken = responseStr.substr(0, tokenEnd);
-		responseStr = responseStr.substr(tokenEnd);
+		resp.recordToken = token;
+		responseStr.remove_prefix(tokenEnd);
 	}
 	
-	char recordTypeIndicator = responseStr[0];
+	char recordTypeIndicator = (responseStr.length() > 0 ? responseStr[0] : 0);
 	resp.recordType = GDBRecordType::INVALID;
 	switch(recordTypeIndicator)
 	{
@@ -94,13 +93,13 @@ void GDBMI::handleResponse(string &responseStr)
 	// 	return;
 	
 	if(resp.recordType != GDBRecordType::INVALID)
-		responseStr = responseStr.substr(1);
+		responseStr.remove_prefix(1);
 		
 	if(resp.recordType == GDBRecordType::ConsoleStream ||
 			resp.recordType == GDBRecordType::TargetStream ||
 			resp.recordType == GDBRecordType::LogStream)
 	{
-		resp.recordData = responseStr;
+		resp.recordData = string(responseStr);
 		//
 	}
 	else
@@ -119,11 +118,13 @@ void GDBMI::handleResponse(string &responseStr)
 			
 		if(comma > 0)
 		{
-			resp.recordClass = responseStr.substr(0, comma);
-			resp.recordData = responseStr.substr(comma + 1);
+			resp.recordClass = string(responseStr.substr(0, comma));
+			resp.recordData = string(responseStr.substr(comma + 1));
 		}
 		else
-			resp.recordClass = responseStr;
+			resp.recordClass = string(responseStr);
+			
+		resp.classID = getRecordClass(resp.recordClass);
 	}
 	
 		// *INDENT-OFF*
@@ -150,18 +151,30 @@ void GDBMI::handleResponse(string &responseStr)
 	
 	if(resp.recordType != GDBRecordType::INVALID)
 	{
-		m_responseQueueMutex.lock();
-		m_responseQueue.push_back(resp);
-		m_responseQueueMutex.unlock();
+		// This runs on the read thread, so records are queued in the order GDB sent them
+		QueuedResponse item;
+		OrderDomain domain = getOrderDomain(resp);
+		
+		// GDB is done with this command and reading the next one
+		if(resp.recordType == GDBRecordType::Result && resp.recordToken != 0)
+			commandAnswered(resp.recordToken);
+			
+		item.response = std::move(resp);
 		
+		queueResponse(domain, std::move(item));
 	}
 	else
 	{
 		if(responseStr == "(gdb) ")
+		{
+			// The first prompt tells us GDB is up and reading commands
+			setReady(false);
 			return;
+		}
 			
 		// fprintf(stderr, "Inf: %s\n", responseStr.c_str());
-		logInferiorOutput(responseStr);
+		string infOutput(responseStr);
+		logInferiorOutput(infOutput);
 		// logPrintf(LogLevel::Warn, "Read invalid record: '%s'", responseStr.c_str());
 	}
 }
@@ -170,23 +183,22 @@ void GDBMI::handleResultRecord(GDBResponse response)
 {
 	if(response.recordClass == "error")
 	{
-		KVPair kvp = parserGetKVPair(response.recordData);
+		string errData = response.recordData; // The parser consumes its input
+		KVPair kvp = parserGetKVPair(errData);
 		logPrintf(LogLevel::Error, "Error: %s\n", kvp.second.c_str());
 		// return;
 	}
 	
-	CallbackIter cbIter;
-	if(findCallback(response.recordToken, cbIter) == true)
-	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
+	// This runs the command's callback (if it has one) and takes it off the pending table
+	if(completeCommand(response) == true)
 		return;
-	}
-	
-	if(findCallback(response.recordClass, cbIter) == true)
+		
+	PendingCommand cb;
+	if(findClassCallback(response.classID, cb) == true)
 	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
+		if(cb.callback != 0)
+			cb.callback(this, response);
+			
 		return;
 	}
 	
@@ -196,73 +208,55 @@ void GDBMI::handleResultRecord(GDBResponse response)
 		return;
 	}
 	
-	logPrintf(LogLevel::Warn, "Unhandled Result record: Token: %s Class: %s; Data: %s\n",
-			  response.recordToken.c_str(),
+	logPrintf(LogLevel::Warn, "Unhandled Result record: Token: %u Class: %s; Data: %s\n",
+			  response.recordToken,
 			  response.recordClass.c_str(),
 			  response.recordData.c_str());
 }
 
 void GDBMI::handleExecAsyncRecord(GDBResponse response)
 {
-	CallbackIter cbIter;
-	if(findCallback(response.recordToken, cbIter) == true)
-	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
-		return;
-	}
-	
-	if(findCallback(response.recordClass, cbIter) == true)
+	PendingCommand cb;
+	if(findResponseCallback(response, cb) == true)
 	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
+		if(cb.callback != 0)
+			cb.callback(this, response);
+			
 		return;
 	}
 	
-	logPrintf(LogLevel::Warn, "Unhandled ExecAsync record: Token: %s; Class: %s; Data: %s\n",
-			  response.recordToken.c_str(), response.recordClass.c_str(), response.recordData.c_str());
+	logPrintf(LogLevel::Warn, "Unhandled ExecAsync record: Token: %u; Class: %s; Data: %s\n",
+			  response.recordToken, response.recordClass.c_str(), response.recordData.c_str());
 }
 
 void GDBMI::handleStatusAsyncRecord(GDBResponse response)
 {
-	CallbackIter cbIter;
-	if(findCallback(response.recordToken, cbIter) == true)
+	PendingCommand cb;
+	if(findResponseCallback(response, cb) == true)
 	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
-		return;
-	}
-	
-	if(findCallback(response.recordClass, cbIter) == true)
-	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
+		if(cb.callback != 0)
+			cb.callback(this, response);
+			
 		return;
 	}
 	
-	logPrintf(LogLevel::Warn, "Unhandled StatusAsync record: Token: %s; Class: %s; Data: %s\n",
-			  response.recordToken.c_str(), response.recordClass.c_str(), response.recordData.c_str());
+	logPrintf(LogLevel::Warn, "Unhandled StatusAsync record: Token: %u; Class: %s; Data: %s\n",
+			  response.recordToken, response.recordClass.c_str(), response.recordData.c_str());
 }
 
 void GDBMI::handleNotifyAsyncRecord(GDBResponse response)
 {
-	CallbackIter cbIter;
-	if(findCallback(response.recordToken, cbIter) == true)
+	PendingCommand cb;
+	if(findResponseCallback(response, cb) == true)
 	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
-		return;
-	}
-	
-	if(findCallback(response.recordClass, cbIter) == true)
-	{
-		CmdCallback cbFunc = cbIter->second.second;
-		cbFunc(this, response);
+		if(cb.callback != 0)
+			cb.callback(this, response);
+			
 		return;
 	}
 	
-	logPrintf(LogLevel::Warn, "Unhandled NotifyAsync record: Token: %s; Class: %s; Data: %s\n",
-			  response.recordToken.c_str(), response.recordClass.c_str(), response.recordData.c_str());
+	logPrintf(LogLevel::Warn, "Unhandled NotifyAsync record: Token: %u; Class: %s; Data: %s\n",
+			  response.recordToken, response.recordClass.c_str(), response.recordData.c_str());
 }
 
 void GDBMI::handleStreamRecords(GDBResponse response)
@@ -271,22 +265,27 @@ void GDBMI::handleStreamRecords(GDBResponse response)
 	logPrintf(LogLevel::Info, "Stream record: Data: %s\n", response.recordData.c_str());
 }
 
-void GDBMI::registerCallback(string token, CmdCallback cb, void *userData)
+void GDBMI::registerCallback(uint32_t token, CmdCallback cb, OrderDomain domain, void *userData)
 {
+	PendingCommand pc;
+	pc.callback = cb;
+	pc.domain = domain;
+	pc.userData = userData;
+	
 	m_pendingCmdMutex.lock();
-	m_pendingCommands[token] = {userData, cb};
+	m_pendingCommands.insert(token, std::move(pc));
 	m_pendingCmdMutex.unlock();
 }
 
-bool GDBMI::findCallback(string token, CallbackIter &out)
+bool GDBMI::findCallback(uint32_t token, PendingCommand &out)
 {
 	bool ret = false;
 	m_pendingCmdMutex.lock();
-	auto findRet = m_pendingCommands.find(token);
+	PendingCommand *findRet = m_pendingCommands.find(token);
 	
-	if(findRet != m_pendingCommands.end())
+	if(findRet != 0)
 	{
-		out = findRet;
+		out = *findRet;
 		ret = true;
 	}
 	m_pendingCmdMutex.unlock();
@@ -294,83 +293,196 @@ bool GDBMI::findCallback(string token, CallbackIter &out)
 	return ret;
 }
 
-void GDBMI::eraseCallback(CallbackIter &iter)
+void GDBMI::eraseCallback(uint32_t token)
 {
 	m_pendingCmdMutex.lock();
-	m_pendingCommands.erase(iter);
+	m_pendingCommands.erase(token);
 	m_pendingCmdMutex.unlock();
 }
 
-void GDBMI::handlerDispatchThread()
+void GDBMI::registerClassCallback(RecordClass recClass, CmdCallback cb, OrderDomain domain)
 {
-	uint32_t threadCount = 0;
-	deque<GDBResponse> responseList;
-	mutex rlMutex;
+	PendingCommand &pc = m_classCallbacks[(size_t) recClass];
+	pc.callback = cb;
+	pc.domain = domain;
+}
+
+bool GDBMI::findClassCallback(RecordClass recClass, PendingCommand &out)
+{
+	if(recClass == RecordClass::Unknown || m_classCallbacks[(size_t) recClass].callback == 0)
+		return false;
+		
+	out = m_classCallbacks[(size_t) recClass];
+	return true;
+}
+
+bool GDBMI::findResponseCallback(const GDBResponse &resp, PendingCommand &out)
+{
+	if(resp.recordToken != 0 && findCallback(resp.recordToken, out))
+		return true;
+		
+	return findClassCallback(resp.classID, out);
+}
+
+GDBMI::RecordClass GDBMI::getRecordClass(std::string_view className)
+{
+	static const std::pair<std::string_view, RecordClass> classNames[] =
+	{
+		{"running",				RecordClass::Running},
+		{"stopped",				RecordClass::Stopped},
+		{"end-stepping-range",	RecordClass::EndSteppingRange},
+		{"library-loaded",		RecordClass::LibraryLoaded},
+		{"library-unloaded",	RecordClass::LibraryUnloaded},
+		{"memory-changed",		RecordClass::MemoryChanged},
+		{"breakpoint-created",	RecordClass::BreakpointCreated},
+		{"breakpoint-modified",	RecordClass::BreakpointModified},
+		{"breakpoint-deleted",	RecordClass::BreakpointDeleted},
+		{"breakpoint-hit",		RecordClass::BreakpointHit},
+		{"thread-created",		RecordClass::ThreadCreated},
+		{"thread-selected",		RecordClass::ThreadSelected},
+		{"thread-exited",		RecordClass::ThreadExited}
+	};
 	
-	auto taskThread = [&]() -> void
+	for(auto &cn : classNames)
 	{
-		rlMutex.lock();
-		threadCount++;
-		GDBResponse resp = responseList.front();
-		responseList.pop_front();
-		rlMutex.unlock();
+		if(cn.first == className)
+			return cn.second;
+	}
+	
+	return RecordClass::Unknown;
+}
+
+GDBMI::OrderDomain GDBMI::getOrderDomain(const GDBResponse &resp)
+{
+	if(resp.recordType == GDBRecordType::ConsoleStream ||
+			resp.recordType == GDBRecordType::TargetStream ||
+			resp.recordType == GDBRecordType::LogStream)
+		return OrderDomain::Streams;
 		
-		switch(resp.recordType)
-		{
-			// *INDENT-OFF*
-			case GDBRecordType::Result:			handleResultRecord(resp);		break;
-			case GDBRecordType::ExecAsync:		handleExecAsyncRecord(resp);	break;
-			case GDBRecordType::StatusAsync:	handleStatusAsyncRecord(resp);	break;
-			case GDBRecordType::NotifyAsync:	handleNotifyAsyncRecord(resp); 	break;
-			case GDBRecordType::ConsoleStream:	handleStreamRecords(resp);		break;
-			case GDBRecordType::TargetStream:	handleStreamRecords(resp);		break;
-			case GDBRecordType::LogStream:		handleStreamRecords(resp);		break;
-			case GDBRecordType::INVALID: 										break;
-			// *INDENT-ON*
-		}
+	PendingCommand cb;
+	if(findResponseCallback(resp, cb) == true)
+		return cb.domain;
 		
-		rlMutex.lock();
-		threadCount--;
-		rlMutex.unlock();
-	};
+	return OrderDomain::None;
+}
+
+void GDBMI::queueResponse(OrderDomain domain, QueuedResponse item)
+{
+	size_t d = (size_t) domain;
+	item.queuedAt = std::chrono::steady_clock::now();
+	
+	m_responseQueueMutex.lock();
+	m_responseQueues[d].push_back(std::move(item));
+	m_queuedResponses++;
+	
+	if(domain == OrderDomain::None)
+		m_readyDomains.push_back(domain);
+	else if(m_strandScheduled[d] == false)
+	{
+		m_strandScheduled[d] = true;
+		m_readyDomains.push_back(domain);
+	}
+	
+	m_dispatchStats.maxQueueDepth = std::max(m_dispatchStats.maxQueueDepth, m_queuedResponses);
+	m_responseQueueMutex.unlock();
+	
+	m_responseQueueCond.notify_one();
+}
+
+void GDBMI::postTask(OrderDomain domain, function<void()> task)
+{
+	QueuedResponse item;
+	item.response.recordType = GDBRecordType::INVALID;
+	item.task = std::move(task);
+	
+	queueResponse(domain, std::move(item));
+}
+
+void GDBMI::dispatchResponse(GDBResponse &resp)
+{
+	switch(resp.recordType)
+	{
+		// *INDENT-OFF*
+		case GDBRecordType::Result:			handleResultRecord(resp);		break;
+		case GDBRecordType::ExecAsync:		handleExecAsyncRecord(resp);	break;
+		case GDBRecordType::StatusAsync:	handleStatusAsyncRecord(resp);	break;
+		case GDBRecordType::NotifyAsync:	handleNotifyAsyncRecord(resp); 	break;
+		case GDBRecordType::ConsoleStream:	handleStreamRecords(resp);		break;
+		case GDBRecordType::TargetStream:	handleStreamRecords(resp);		break;
+		case GDBRecordType::LogStream:		handleStreamRecords(resp);		break;
+		case GDBRecordType::INVALID: 										break;
+		// *INDENT-ON*
+	}
+}
+
+void GDBMI::handlerWorkerThread()
+{
+	using Clock = std::chrono::steady_clock;
+	using Micros = std::chrono::duration<double, std::micro>;
+	
+	std::unique_lock<mutex> lock(m_responseQueueMutex);
 	
 	while(!m_exitThreads)
 	{
-		m_responseQueueMutex.lock();
+		m_responseQueueCond.wait(lock, [this] { return m_exitThreads || m_readyDomains.size() > 0; });
 		
-		if(m_responseQueue.size() <= 0)
-		{
-			m_responseQueueMutex.unlock();
-			usleep(1000 * 50);
-			continue;
-		}
+		if(m_exitThreads)
+			break;
+			
+		OrderDomain domain = m_readyDomains.front();
+		m_readyDomains.pop_front();
+		
+		size_t d = (size_t) domain;
+		QueuedResponse item = std::move(m_responseQueues[d].front());
+		m_responseQueues[d].pop_front();
+		m_queuedResponses--;
 		
-		GDBResponse r = m_responseQueue.front();
-		m_responseQueue.pop_front();
-		m_responseQueueMutex.unlock();
+		Clock::time_point startTime = Clock::now();
+		m_totalQueueWaitUs += Micros(startTime - item.queuedAt).count();
+		m_dispatchStats.busyWorkers++;
+		lock.unlock();
 		
-		rlMutex.lock();
-		while(threadCount >= GDB_HANDLER_THREAD_COUNT)
+		if(item.task != 0)
+			item.task();
+		else
+			dispatchResponse(item.response);
+		
+		double serviceUs = Micros(Clock::now() - startTime).count();
+		
+		lock.lock();
+		
+		// The strand stays scheduled while it has records, so nothing else
+		// from this domain could have run while we were handling this one
+		if(domain != OrderDomain::None)
 		{
-			rlMutex.unlock();
-			usleep(1000 * 10);
-			rlMutex.lock();
+			if(m_responseQueues[d].size() > 0)
+			{
+				m_readyDomains.push_back(domain);
+				m_responseQueueCond.notify_one();
+			}
+			else m_strandScheduled[d] = false;
 		}
 		
-		responseList.push_back(r);
-		rlMutex.unlock();
-		
-		thread task = thread(taskThread);
-		task.detach();
+		m_dispatchStats.busyWorkers--;
+		m_dispatchStats.recordsHandled++;
+		m_dispatchStats.maxServiceUs = std::max(m_dispatchStats.maxServiceUs, serviceUs);
+		m_totalServiceUs += serviceUs;
 	}
+}
+
+GDBMI::DispatchStats GDBMI::getDispatchStats()
+{
+	DispatchStats ret;
+	m_responseQueueMutex.lock();
+	ret = m_dispatchStats;
+	ret.queueDepth = m_queuedResponses;
 	
-	// Wait for the worker threads to terminate
-	rlMutex.lock();
-	while(threadCount > 0)
+	if(ret.recordsHandled > 0)
 	{
-		rlMutex.unlock();
-		usleep(1000 * 100);
-		rlMutex.lock();
+		ret.avgQueueWaitUs = m_totalQueueWaitUs / ret.recordsHandled;
+		ret.avgServiceUs = m_totalServiceUs / ret.recordsHandled;
 	}
-	rlMutex.unlock();
+	m_responseQueueMutex.unlock();
+	
+	return ret;
 }
@@ -21,7 +21,26 @@ class GDBMI
 	
 		struct GDBResponse;
 		typedef std::function<void(GDBMI *, GDBResponse)> CmdCallback;
-		typedef std::map<string, pair<void *, CmdCallback>>::iterator CallbackIter;
+		
+		// Records in the same ordering domain are handled one at a time, in the
+		// order GDB sent them (each domain is a serial executor, or strand).
+		// Records in different domains, and records in the 'None' domain, are
+		// handled in parallel by the worker pool.
+		enum class OrderDomain : uint8_t
+		{
+			None = 0,
+			ExecState,		// *running/*stopped and anything touching the execution position
+			Breakpoints,
+			Disassembly,
+			Registers,
+			Backtrace,
+			Symbols,
+			Streams,		// Console/target/log output
+			Events,			// Delivery of events to subscribers (see subscribe())
+			Search,			// Symbol search queries (see searchSymbols())
+			
+			Count
+		};
 		
 		enum class GDBRecordType : uint8_t
 		{
@@ -35,10 +54,34 @@ class GDBMI
 			LogStream
 		};
 		
+		// The record classes we have default handlers for
+		enum class RecordClass : uint8_t
+		{
+			Unknown = 0,
+			Running,
+			Stopped,
+			EndSteppingRange,
+			LibraryLoaded,
+			LibraryUnloaded,
+			MemoryChanged,
+			BreakpointCreated,
+			BreakpointModified,
+			BreakpointDeleted,
+			BreakpointHit,
+			ThreadCreated,
+			ThreadSelected,
+			ThreadExited,
+			
+			Count
+		};
+		
+		static RecordClass getRecordClass(std::string_view className);
+		
 		struct GDBResponse
 		{
 			GDBRecordType recordType;
-			std::string recordToken; // Record token-id
+			uint32_t recordToken = 0; // Record token-id, 0 if the record has none
+			RecordClass classID = RecordClass::Unknown;
 			std::string recordClass; // Like result-class, async-class
 			std::string recordData;	// Contains record-dependent information
 		};
@@ -56,7 +99,7 @@ class GDBMI
 		// recordData.
 		// handleResponse() Then hands off the GDBResponse object to the
 		// handler for the given record type.
-		void handleResponse(string &responseStr);
+		void handleResponse(std::string_view responseStr);
 		
 		void handleResultRecord(GDBResponse response);
 		void handleExecAsyncRecord(GDBResponse response);
@@ -71,33 +114,139 @@ class GDBMI
 		
 		// Response queue handling stuff
 		
-		thread m_dispatchThread;
+	public:
+	
+		struct DispatchStats
+		{
+			uint32_t workerCount = 0;
+			uint32_t busyWorkers = 0;
+			uint32_t queueDepth = 0;		// Records waiting for a worker right now
+			uint32_t maxQueueDepth = 0;		// High-water mark since startup
+			uint64_t recordsHandled = 0;
+			double avgQueueWaitUs = 0;		// Time from the read thread queueing a record to a worker picking it up
+			double avgServiceUs = 0;		// Time spent in the record handlers
+			double maxServiceUs = 0;
+		};
+		
+		DispatchStats getDispatchStats();
+		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		struct QueuedResponse
+		{
+			GDBResponse response;
+			function<void()> task; // Run instead of handling 'response' if set (see postTask())
+			std::chrono::steady_clock::time_point queuedAt;
+		};
+		
+		// A fixed pool of worker threads handles the records read from GDB.
+		// handleResponse() puts each record on the queue for its ordering domain
+		// and, unless that domain's strand is already scheduled, puts the domain
+		// on m_readyDomains and wakes a worker. A worker handles one record from
+		// the domain, then reschedules the domain if it has more records waiting.
+		vector<thread> m_workerThreads;
 		mutex m_responseQueueMutex;
-		deque<GDBResponse> m_responseQueue;
+		std::condition_variable m_responseQueueCond;
+		deque<QueuedResponse> m_responseQueues[(size_t) OrderDomain::Count];
+		bool m_strandScheduled[(size_t) OrderDomain::Count] = {false};
+		deque<OrderDomain> m_readyDomains;
+		uint32_t m_queuedResponses = 0;
+		
+		// Works out which domain a record belongs to, from the domain its
+		// token or record class callback was registered with
+		OrderDomain getOrderDomain(const GDBResponse &resp);
+		
+		// Puts an item on its domain's queue and schedules the domain if needed
+		void queueResponse(OrderDomain domain, QueuedResponse item);
+		
+		// Runs 'task' on the worker pool, in order with the records of 'domain'
+		void postTask(OrderDomain domain, function<void()> task);
+		
+		// Guarded by m_responseQueueMutex
+		DispatchStats m_dispatchStats;
+		double m_totalQueueWaitUs = 0;
+		double m_totalServiceUs = 0;
 		
-		static void handlerDispatchThreadThunk(GDBMI *obj) { obj->handlerDispatchThread(); }
-		void handlerDispatchThread();
+		static void handlerWorkerThreadThunk(GDBMI *obj) { obj->handlerWorkerThread(); }
+		void handlerWorkerThread();
+		
+		// Calls the handler for the record's type
+		void dispatchResponse(GDBResponse &resp);
 		
 		
 		
 		
 		// Callback handling stuff
 		
-		void registerCallback(string token, CmdCallback cb, void *userData = 0);
-		bool findCallback(string token, CallbackIter &out);
-		void eraseCallback(CallbackIter &iter);
+	public:
+		struct MIResult; // gdbmi_commands.h
+		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		// Marks a -symbol-info-functions or -symbol-info-variables command,
+		// whose result is parsed as it's read (see streamSymbols())
+		enum class SymbolListKind : uint8_t
+		{
+			None = 0,
+			Functions,
+			Globals
+		};
+		
+		struct PendingCommand
+		{
+			CmdCallback callback = 0;
+			OrderDomain domain = OrderDomain::None;
+			void *userData = 0;
+			SymbolListKind symbolList = SymbolListKind::None;
+			
+			// Only set for commands sent with sendCommand()
+			std::shared_ptr<std::promise<MIResult>> result;
+			
+			// Only set for commands awaited by a coroutine (see command())
+			function<void(MIResult &)> continuation;
+			
+			// The stop generation the command was sent in, for requests whose
+			// data is only good for that stop; 0 if it isn't tied to a stop
+			uint32_t stopGeneration = 0;
+			std::chrono::steady_clock::time_point sentAt;
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+		};
+		
+		void registerCallback(uint32_t token, CmdCallback cb, OrderDomain domain = OrderDomain::None, void *userData = 0);
+		bool findCallback(uint32_t token, PendingCommand &out);
+		void eraseCallback(uint32_t token);
+		
+		void registerClassCallback(RecordClass recClass, CmdCallback cb, OrderDomain domain = OrderDomain::None);
+		bool findClassCallback(RecordClass recClass, PendingCommand &out);
+		
+		// Finds the callback for a record: the one registered for its token
+		// if there is one, otherwise the handler for its record class
+		bool findResponseCallback(const GDBResponse &resp, PendingCommand &out);
+		
 		mutex m_pendingCmdMutex;
 		
-		// This map is used to register callbacks when we receive a response
+		// This table is used to register callbacks when we receive a response
 		// to a command we sent. We use the token in the response to index
-		// into this map and find the correct callback.
-		std::map<string, pair<void *, CmdCallback>> m_pendingCommands; // map<token, callback>
+		// into this table and find the correct callback. Entries are removed
+		// when the command's result record arrives (see completeCommand()).
+		TokenMap<PendingCommand> m_pendingCommands;
+		
+		// Default handlers, indexed by RecordClass. Only written during initHandlers().
+		PendingCommand m_classCallbacks[(size_t) RecordClass::Count];
 		
 		
 		// Here we set up some default handlers for certain events.
-		// For these callbacks, we register them under the record class name
+		// For these callbacks, we register them under the record class
 		// that we want the callback to execute for. The "handle_*_Records()" functions
-		// look for a callback under the class name if no token callback is found.
+		// look for a callback for the class if no token callback is found.
 		
 		// Note: These callbacks are implemented in 'gdbmi_handlers_cb.cpp'
 		
@@ -124,6 +273,20 @@ class GDBMI
 	private:
 		void endStepCallback(GDBResponse resp);
 		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		// Address in the frame={...} of a *stopped record, 0 if it has none
+		uint64_t getStopFramePC(MIRecordView &stop);
+		
+		// Moves the current position to the stop record's frame, as
+		// endStepCallback() does, so the highlight doesn't wait on GDB. Only
+		// asks GDB for $pc if the record has no frame ('pc' is 0).
+		void setStopExecPos(MIRecordView &stop, uint64_t pc);
+		
 		
 		
 		// ** breakpoint callbacks ** //
@@ -181,6 +344,13 @@ class GDBMI
 	private:
 		void libUnloadedCallback(GDBResponse resp);
 		
+	public:
+		static void memChangedCallbackThunk(GDBMI *obj, GDBResponse resp)
+		{ obj->memChangedCallback(resp); }
+		
+	private:
+		void memChangedCallback(GDBResponse resp);
+		
 		
 		
 		// ** thread event callbacks ** //
@@ -226,6 +396,10 @@ class GDBMI
 	private:
 		void getGlobalVarSymbolsCallback(GDBResponse resp);
 		
+		// Fills 'symbols' from a -symbol-info-functions or -symbol-info-variables
+		// result. Returns false if the result isn't a symbol list.
+		bool parseSymbolList(std::string_view rawData, SymbolTable &symbols);
+		
 		// Disassembly
 	public:
 		static void getDisassemblyCallbackThunk(GDBMI *obj, GDBResponse resp)
@@ -249,6 +423,13 @@ class GDBMI
 	private:
 		void getregValsCallback(GDBResponse resp);
 		
+	public:
+		static void getChangedRegsCallbackThunk(GDBMI *obj, GDBResponse resp)
+		{ obj->getChangedRegsCallback(resp); }
+		
+	private:
+		void getChangedRegsCallback(GDBResponse resp);
+		
 		// Stack frames and variables
 	public:
 		static void getStackFramesCallbackThunk(GDBMI *obj, GDBResponse resp)
@@ -270,63 +451,24 @@ class GDBMI
 		
 		// Output handling stuff
 		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
 	private:
+		#endif
 	
-		void sendCommand(string cmd);
-		mutex m_sendCmdMutex;
-		
-		
+		// Tokens are sequential and never 0
 		uint32_t getToken()
 		{
-			m_randMutex.lock();
-			uint32_t ret = 0;
+			uint32_t ret = ++m_nextToken;
 			
 			while(ret == 0)
-			{
-				if(m_randOffset >= (2048 - 3))
-				{
-					fillRandPool();
-					m_randOffset = 0;
-				}
+				ret = ++m_nextToken;
 				
-				memcpy(&ret, (m_randPool + m_randOffset), 3);
-				m_randOffset += 3;
-			}
-			
-			m_randMutex.unlock();
-			
-			// ret >>= 8;
 			return ret;
 		}
 		
-		string getTokenStr()
-		{
-			uint32_t tk = getToken();
-			char intStr[128] = {0};
-			sprintf(intStr, "%u", tk);
-			
-			return string(intStr);
-		}
-		
-		bool fillRandPool()
-		{
-			FILE *fp = fopen("/dev/urandom", "rb");
-			
-			if(fp != 0)
-			{
-				fread(m_randPool, 2048, 1, fp);
-				fclose(fp);
-				
-				return true;
-			}
-			else fprintf(stderr, "fopen(/dev/urandom, rb) failed!\n");
-			
-			return false;
-		}
-		
-		uint8_t m_randPool[2048];
-		uint32_t m_randOffset;
-		mutex m_randMutex;
+		std::atomic<uint32_t> m_nextToken = {0};
 		
 		
 		
@@ -5,12 +5,17 @@
 
 void GDBMI::runningCallback(GDBResponse resp)
 {
+	bumpStopGeneration();
+	
 	setState(GDBState::Running, "Inferior is running");
 	logPrintf(LogLevel::Info, "Inferior is running\n");
 }
 
 void GDBMI::stoppedCallback(GDBResponse resp)
 {
+	// Results still on their way for requests sent before this stop get dropped
+	bumpStopGeneration();
+	
 	m_stepFrameMutex.lock();
 	m_stepFrame.reset();
 	m_stepFrameMutex.unlock();
@@ -21,82 +26,84 @@ void GDBMI::stoppedCallback(GDBResponse resp)
 	if(resp.recordClass == "error")
 		logPrintf(LogLevel::Debug, "stoppedCallback() error\n");
 		
-		
+	// Lets the disassembly come from the cache when we stop in a function we've seen
+	MIRecordView stop(resp.recordData);
+	uint64_t pc = getStopFramePC(stop);
+	
 	requestRegisterInfo();
 	requestBacktrace();
 	
-	string respData = resp.recordData;
-	KVPair rootPair = parserGetKVPair(respData);
+	string reason(stop.get("reason"));
 	
-	if(rootPair.first == "reason")
+	if(reason.length() > 0)
 	{
-		if(rootPair.second == "breakpoint-hit")
+		if(reason == "breakpoint-hit")
 		{
 			setState(GDBState::Stopped, "Inferior stopped: breakpoint hit");
 			
-			requestCurrentExecPos();
-			requestDisassembleAddr("$pc");
+			setStopExecPos(stop, pc);
+			requestStopDisassembly("$pc", pc);
 			
 			// Here we're calling a callback for breakpoint-hit events
-			CallbackIter cbIter;
-			if(findCallback(rootPair.second, cbIter) == true)
+			PendingCommand bpHitCB;
+			if(findClassCallback(RecordClass::BreakpointHit, bpHitCB) == true)
 			{
-				cbIter->second.second(this, resp);
+				if(bpHitCB.callback != 0)
+					bpHitCB.callback(this, resp);
+					
 				return;
 			}
 		}
 		
-		if(rootPair.second == "exited-normally")
+		if(reason == "exited-normally")
 		{
 			setState(GDBState::Exited, "Inferior exited: Exited normally");
 			//
 			return;
 		}
 		
-		if(rootPair.second == "exited-signalled")
+		if(reason == "exited-signalled")
 		{
-			KVPair sigName = parserGetKVPair(respData);
-			setState(GDBState::Exited, string("Inferior exited: Received '") + sigName.second + "' signal");
+			setState(GDBState::Exited, string("Inferior exited: Received '") + string(stop.get("signal-name")) + "' signal");
 			
 			return;
 		}
 		
-		if(rootPair.second == "signal-received")
+		if(reason == "signal-received")
 		{
-			requestCurrentExecPos();
-			requestDisassembleAddr("$pc");
+			setStopExecPos(stop, pc);
+			requestStopDisassembly("$pc", pc);
 			
-			KVPair sigName = parserGetKVPair(respData);
-			setState(GDBState::Stopped, string("Inferior stopped: Received '") + sigName.second + "' signal");
+			setState(GDBState::Stopped, string("Inferior stopped: Received '") + string(stop.get("signal-name")) + "' signal");
 			
 			return;
 		}
 		
-		if(rootPair.second == "end-stepping-range")
+		if(reason == "end-stepping-range")
 		{
 			setState(GDBState::Stopped, "Inferior stopped: Finished stepping");
 			endStepCallback(resp);
 			
 			m_stepFrameMutex.lock();
 			if(m_stepFrame.isValid)
-				requestDisassembleAddr(m_stepFrame.address);
+				requestStopDisassembly(m_stepFrame.address, strtoull(m_stepFrame.address.c_str(), 0, 16));
 			else
-				requestDisassembleAddr("$pc");
+				requestStopDisassembly("$pc", pc);
 			m_stepFrameMutex.unlock();
 			
 			return;
 		}
 		
 		// Hopefully, this is a catch-all for all non-exit stop events
-		if(rootPair.second.find("exited-") == string::npos)
+		if(reason.find("exited-") == string::npos)
 		{
-			requestCurrentExecPos();
-			requestDisassembleAddr("$pc");
+			setStopExecPos(stop, pc);
+			requestStopDisassembly("$pc", pc);
 			//
 		}
 		
 		// Hopefully, this is a catch-all for all exit events
-		if(rootPair.second.find("exited-") != string::npos)
+		if(reason.find("exited-") != string::npos)
 		{
 			setState(GDBState::Exited, "Inferior exited: Reason unknown");
 			//
@@ -107,23 +114,43 @@ void GDBMI::stoppedCallback(GDBResponse resp)
 	}
 }
 
-void GDBMI::endStepCallback(GDBResponse resp)
+uint64_t GDBMI::getStopFramePC(MIRecordView &stop)
 {
-	StepFrame newStepFrame;
+	// reason="breakpoint-hit",disp="keep",bkptno="1",frame={addr="0x0000555555555131",func="main",...},...
 	
-	string recordData = resp.recordData;
-	KVPair framePair = parserGetKVPair(recordData); // Discard this one
+	string addr(stop.get("frame", "addr"));
+	return strtoull(addr.c_str(), 0, 16);
+}
+
+void GDBMI::setStopExecPos(MIRecordView &stop, uint64_t pc)
+{
+	if(pc == 0)
+	{
+		requestCurrentExecPos();
+		return;
+	}
 	
-	framePair = parserGetKVPair(recordData);
-	string frameData = framePair.second;
+	m_curExecPosMutex.lock();
+	m_currentExecPos.first = pc;
+	m_currentExecPos.second = stop.get("frame", "func");
+	m_curExecPosMutex.unlock();
+}
+
+void GDBMI::endStepCallback(GDBResponse resp)
+{
+	StepFrame newStepFrame;
 	
+	MIRecordView stop(resp.recordData);
 	
+	// reason="end-stepping-range",
 	// frame={addr="0x000055555555fa90",func="??",args=[],arch="i386:x86-64"},
 	// thread-id="1",
 	// stopped-threads="all",
 	// core="6"
 	
-	if(framePair.first != "frame")
+	newStepFrame.address = stop.get("frame", "addr");
+	
+	if(newStepFrame.address.length() == 0)
 	{
 		m_stepFrameMutex.lock();
 		m_stepFrame.reset();
@@ -132,25 +159,10 @@ void GDBMI::endStepCallback(GDBResponse resp)
 		return;
 	}
 	
-	string frameTuple = parserGetTuple(frameData);
-	KVPairVector frameKVP;
-	parserGetKVPairs(frameTuple, frameKVP);
+	newStepFrame.func = stop.get("frame", "func");
+	newStepFrame.args = stop.source("frame", "args");
+	newStepFrame.threadID = stop.get("thread-id");
 	
-	for(auto &kvp : frameKVP)
-	{
-		if(kvp.first == "addr")
-			newStepFrame.address = kvp.second;
-		else if(kvp.first == "func")
-			newStepFrame.func = kvp.second;
-		else if(kvp.first == "args")
-			newStepFrame.args = kvp.second;
-	}
-	
-	KVPair tidPair = parserGetKVPair(recordData);
-	
-	if(tidPair.first == "thread-id")
-		newStepFrame.threadID = tidPair.second;
-		
 	if(newStepFrame.address.length() > 0 &&
 			newStepFrame.func.length() > 0 &&
 			newStepFrame.args.length() > 0 &&
@@ -173,18 +185,23 @@ void GDBMI::endStepCallback(GDBResponse resp)
 void GDBMI::bpCreatedCallback(GDBResponse resp)
 {
 	// logPrintf(LogLevel::Verbose, "Breakpoint created\n");
+	invalidateDisasCache();
 	requestBreakpointList();
 }
 
 void GDBMI::bpDeletedCallback(GDBResponse resp)
 {
 	// logPrintf(LogLevel::Verbose, "Breakpoint deleted\n");
+	invalidateDisasCache();
 	requestBreakpointList();
 }
 
 void GDBMI::bpModifiedCallback(GDBResponse resp)
 {
 	// logPrintf(LogLevel::Verbose, "Breakpoint modified\n");
+	
+	// Not a reason to drop the disassembly cache; GDB sends this for
+	// every hit, just to update the hit count
 	requestBreakpointList();
 }
 
@@ -196,105 +213,83 @@ void GDBMI::bpHitCallback(GDBResponse resp)
 
 void GDBMI::bpListCallback(GDBResponse resp)
 {
+	Event ev;
+	ev.type = EventType::BreakpointsChanged;
+	
 	if(resp.recordData.length() > 0)
 	{
-		string bpTableStr = resp.recordData;
-		KVPair rootPair = parserGetKVPair(bpTableStr);
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		const MIValue *table = results->find(MIKey::BreakpointTable);
 		
-		if(rootPair.first == "BreakpointTable")
+		if(table != 0)
 		{
-			string tableTuple = parserGetTuple(rootPair.second);
-			
-			KVPairVector tablePairs;
-			parserGetKVPairs(tableTuple, tablePairs);
+			// Only this callback writes the list, and it runs in order in its domain
+			Snapshot<BreakpointInfo> oldSnapshot = m_breakPointList.get();
+			const vector<BreakpointInfo> &oldBpList = oldSnapshot->data;
+			vector<BreakpointInfo> bpList;
+			
+			/*	Breakpoint response format
+				body=[
+				bkpt={
+				number="1",			func="main",
+				type="breakpoint",	file="hello.c",
+				disp="keep",		line="5",
+				enabled="y",		thread-groups=["i1"],
+				addr="0x000100d0",	times="0"
+				},
+				bkpt={
+				number="2",			file="hello.c",
+				type="breakpoint",	fullname="/home/foo/hello.c",
+				disp="keep",		line="13",
+				enabled="y",		thread-groups=["i1"],
+				addr="0x00010114",	times="0",
+				func="foo",
+				}]
+			*/
+			
+			const MIValue *body = table->find(MIKey::Body);
+			
+			const MIValue noBreakpoints;
+			
+			for(const MIValue &bp : (body != 0) ? *body : noBreakpoints)
+			{
+				if(bp.id != MIKey::Bkpt)
+					continue;
+					
+				BreakpointInfo tmp = breakpointSchema.bind(bp);
+				
+				// logPrintf(LogLevel::Debug, "BP # = %u; Func = %s; Addr = %s", tmp.number, tmp.func.c_str(), tmp.addr.c_str());
+				bpList.push_back(tmp);
+			}
 			
-			m_breakPointMutex.lock();
-			m_breakPointList.clear();
+			// Work out what changed, so subscribers don't have to diff the lists
+			for(auto &bp : bpList)
+			{
+				auto old = std::find_if(oldBpList.begin(), oldBpList.end(),
+										[&](const BreakpointInfo & o) { return o.number == bp.number; });
+										
+				if(old == oldBpList.end())
+					ev.bpAdded.push_back(bp.number);
+				else if(old->enabled != bp.enabled || old->addr != bp.addr || old->times != bp.times ||
+						old->line != bp.line || old->fullname != bp.fullname)
+					ev.bpModified.push_back(bp.number);
+			}
 			
-			for(auto &tblPair : tablePairs)
+			for(auto &old : oldBpList)
 			{
-				if(tblPair.first == "body")
-				{
-					/*	Breakpoint response format
-						body=[
-						bkpt={
-						number="1",			func="main",
-						type="breakpoint",	file="hello.c",
-						disp="keep",		line="5",
-						enabled="y",		thread-groups=["i1"],
-						addr="0x000100d0",	times="0"
-						},
-						bkpt={
-						number="2",			file="hello.c",
-						type="breakpoint",	fullname="/home/foo/hello.c",
-						disp="keep",		line="13",
-						enabled="y",		thread-groups=["i1"],
-						addr="0x00010114",	times="0",
-						func="foo",
-						}]
-					*/
-					
-					string bpListStr = tblPair.second;
-					if(bpListStr[0] == '[')
-						bpListStr.erase(bpListStr.begin());
-						
-					if(bpListStr.back() == ']')
-						bpListStr.pop_back();
-						
-					while(bpListStr.length() > 1)
-					{
-						KVPair bpPair = parserGetKVPair(bpListStr);
-						
-						if(bpPair.first == "bkpt")
-						{
-							string bpAttrs = parserGetTuple(bpPair.second);
-							KVPairVector bpAttrList;
-							parserGetKVPairs(bpAttrs, bpAttrList);
-							
-							BreakpointInfo tmp;
-							
-							for(auto &bpattr : bpAttrList)
-							{
-								if(bpattr.first == "number")
-									tmp.number = strtoul(bpattr.second.c_str(), 0, 10);
-								if(bpattr.first == "file")
-									tmp.file = bpattr.second;
-								if(bpattr.first == "type")
-									tmp.type = bpattr.second;
-								if(bpattr.first == "fullname")
-									tmp.fullname = bpattr.second;
-								if(bpattr.first == "disp")
-									tmp.disp = bpattr.second;
-								if(bpattr.first == "line")
-									tmp.line = strtoul(bpattr.second.c_str(), 0, 10);
-								if(bpattr.first == "enabled")
-									tmp.enabled = (bpattr.second[0] == 'y' ? true : false);
-								if(bpattr.first == "addr")
-									tmp.addr = bpattr.second;
-								if(bpattr.first == "times")
-									tmp.times = strtoul(bpattr.second.c_str(), 0, 10);
-								if(bpattr.first == "func")
-									tmp.func = bpattr.second;
-							}
-							
-							// logPrintf(LogLevel::Debug, "BP # = %u; Func = %s; Addr = %s", tmp.number, tmp.func.c_str(), tmp.addr.c_str());
-							m_breakPointList.push_back(tmp);
-						}
-					}
-					
-				}
+				auto bp = std::find_if(bpList.begin(), bpList.end(),
+									   [&](const BreakpointInfo & b) { return b.number == old.number; });
+									   
+				if(bp == bpList.end())
+					ev.bpRemoved.push_back(old.number);
 			}
 			
-			m_breakPointMutex.unlock();
+			m_breakPointList.publish(std::move(bpList));
 		}
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::BreakPtList, m_notifyUserData);
+	publishEvent(std::move(ev));
 }
 
 
@@ -302,11 +297,18 @@ void GDBMI::bpListCallback(GDBResponse resp)
 void GDBMI::libLoadedCallback(GDBResponse resp)
 {
 	// printf("Library loaded\n");
+	invalidateDisasCache();
 }
 
 void GDBMI::libUnloadedCallback(GDBResponse resp)
 {
 	// printf("Library unloaded\n");
+	invalidateDisasCache();
+}
+
+void GDBMI::memChangedCallback(GDBResponse resp)
+{
+	invalidateDisasCache();
 }
 
 
@@ -328,219 +330,87 @@ void GDBMI::threadExitedCallback(GDBResponse resp)
 
 
 
+bool GDBMI::parseSymbolList(std::string_view rawData, SymbolTable &symbols)
+{
+	// symbols={debug=[{filename="a.c",fullname="/src/a.c",symbols=[{line="10",name="main",...},...]},...]}
+	
+	MIArena arena;
+	const MIValue *results = MIParser::parseResults(rawData, arena);
+	const MIValue *symbolTuple = results->find(MIKey::Symbols);
+	
+	if(symbolTuple == 0 || symbolTuple->kind != MIValue::Kind::Tuple)
+		return false;
+		
+	const MIValue *debugList = symbolTuple->find(MIKey::Debug);
+	
+	// No debug info, so no symbols
+	if(debugList == 0 || debugList->kind != MIValue::Kind::List)
+		return true;
+		
+	for(const MIValue &file : *debugList)
+		MISymbolStream::addFile(file, symbols);
+		
+	symbols.finish();
+	return true;
+}
+
 void GDBMI::getFuncSymbolsCallback(GDBResponse resp)
 {
 	if(resp.recordData.length() > 0)
 	{
-		string rawData = resp.recordData;
-		KVPair rootPair = parserGetKVPair(rawData);
+		// Built up here and published in one go, so readers never see half a table
+		SymbolTable symbols;
 		
-		if(rootPair.first != "symbols" || getItemType(rootPair.second[0]) != ParseItemType::Tuple)
+		if(parseSymbolList(resp.recordData, symbols) == false)
 			return;
 			
-		string symbolTuple = parserGetTuple(rootPair.second);
-		KVPair symKVP = parserGetKVPair(symbolTuple);
-		
-		m_funcSymMutex.lock();
-		m_functionSymbols.clear();
-		m_funcSymMutex.unlock();
+		m_functionSymbols.publish(std::move(symbols));
+		publishEvent(EventType::FunctionsChanged);
 		
-		if(symKVP.first != "debug" || getItemType(symKVP.second[0]) != ParseItemType::List)
-		{
-			if(m_notifyCallback != 0)
-				m_notifyCallback(UpdateType::FuncSymbols, m_notifyUserData);
-				
-			return;
-		}
-		
-		string symbolList = symKVP.second;
-		
-		// Strip '[' and ']' off the list
-		symbolList.erase(symbolList.begin());
-		symbolList.erase(symbolList.end() - 1);
-		
-		ListItemVector symFiles;
-		parserGetListItems(symbolList, symFiles);
-		
-		for(auto &file : symFiles)
-		{
-			string fileTuple = parserGetTuple(file);
-			KVPairVector sfVector;
-			parserGetKVPairs(fileTuple, sfVector);
-			
-			string fullPath;
-			string shortName;
-			
-			for(auto &fileItem : sfVector)
-			{
-				if(fileItem.first == "filename")
-				{
-					// printf("Filename: %s\n", fileItem.second.c_str());
-					shortName = fileItem.second;
-					continue;
-				}
-				
-				if(fileItem.first == "fullname")
-				{
-					// printf("Full name: %s\n", fileItem.second.c_str());
-					fullPath = fileItem.second;
-					continue;
-				}
-				
-				if(fileItem.first == "symbols")
-				{
-					string symList = fileItem.second;
-					symList.erase(symList.begin());
-					symList.erase(symList.end() - 1);
-					
-					ListItemVector symTuples;
-					parserGetListItems(symList, symTuples);
-					
-					for(auto &symTup : symTuples)
-					{
-						SymbolObject tmp;
-						tmp.fullPath = fullPath;
-						tmp.shortName = shortName;
-						tmp.isActive = false;
-						
-						string symbolInfo = parserGetTuple(symTup);
-						KVPairVector symParts;
-						parserGetKVPairs(symbolInfo, symParts);
-						
-						for(auto &sym : symParts)
-						{
-							if(sym.first == "line")
-								tmp.lineNumber = sym.second;
-							else if(sym.first == "name")
-								tmp.name = sym.second;
-							else if(sym.first == "type")
-								tmp.type = sym.second;
-							else if(sym.first == "description")
-								tmp.description = sym.second;
-								
-							// printf("\t%s: %s\n", sym.first.c_str(), sym.second.c_str());
-						}
-						
-						m_funcSymMutex.lock();
-						m_functionSymbols.push_back(tmp);
-						m_funcSymMutex.unlock();
-					}
-				}
-			}
-		}
+		// Searches keep using the old index until the new one is ready
+		rebuildSearchIndex(SymbolKind::Function, m_functionSymbols.get());
+		return;
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::FuncSymbols, m_notifyUserData);
+	publishEvent(EventType::FunctionsChanged);
 }
 
 void GDBMI::getGlobalVarSymbolsCallback(GDBResponse resp)
 {
 	if(resp.recordData.length() > 0)
 	{
-		string rawData = resp.recordData;
-		KVPair rootPair = parserGetKVPair(rawData);
+		SymbolTable symbols;
 		
-		if(rootPair.first != "symbols" || getItemType(rootPair.second[0]) != ParseItemType::Tuple)
+		if(parseSymbolList(resp.recordData, symbols) == false)
 			return;
 			
-		string symbolTuple = parserGetTuple(rootPair.second);
-		KVPair symKVP = parserGetKVPair(symbolTuple);
-		
-		if(symKVP.first != "debug" || getItemType(symKVP.second[0]) != ParseItemType::List)
-			return;
-			
-		m_globalVarMutex.lock();
-		m_globalVarSymbols.clear();
-		m_globalVarMutex.unlock();
-		
-		string symbolList = symKVP.second;
+		m_globalVarSymbols.publish(std::move(symbols));
+		publishEvent(EventType::GlobalsChanged);
 		
-		// Strip '[' and ']' off the list
-		symbolList.erase(symbolList.begin());
-		symbolList.erase(symbolList.end() - 1);
-		
-		ListItemVector symFiles;
-		parserGetListItems(symbolList, symFiles);
-		
-		for(auto &file : symFiles)
-		{
-			string fileTuple = parserGetTuple(file);
-			KVPairVector sfVector;
-			parserGetKVPairs(fileTuple, sfVector);
-			
-			string fullPath;
-			string shortName;
-			
-			for(auto &fileItem : sfVector)
-			{
-				if(fileItem.first == "filename")
-				{
-					// printf("Filename: %s\n", fileItem.second.c_str());
-					shortName = fileItem.second;
-					continue;
-				}
-				
-				if(fileItem.first == "fullname")
-				{
-					// printf("Full name: %s\n", fileItem.second.c_str());
-					fullPath = fileItem.second;
-					continue;
-				}
-				
-				if(fileItem.first == "symbols")
-				{
-					string symList = fileItem.second;
-					symList.erase(symList.begin());
-					symList.erase(symList.end() - 1);
-					
-					ListItemVector symTuples;
-					parserGetListItems(symList, symTuples);
-					
-					for(auto &symTup : symTuples)
-					{
-						SymbolObject tmp;
-						tmp.fullPath = fullPath;
-						tmp.shortName = shortName;
-						tmp.isActive = false;
-						
-						string symbolInfo = parserGetTuple(symTup);
-						KVPairVector symParts;
-						parserGetKVPairs(symbolInfo, symParts);
-						
-						for(auto &sym : symParts)
-						{
-							if(sym.first == "line")
-								tmp.lineNumber = sym.second;
-							else if(sym.first == "name")
-								tmp.name = sym.second;
-							else if(sym.first == "type")
-								tmp.type = sym.second;
-							else if(sym.first == "description")
-								tmp.description = sym.second;
-								
-							// printf("\t%s: %s\n", sym.first.c_str(), sym.second.c_str());
-						}
-						
-						m_globalVarMutex.lock();
-						m_globalVarSymbols.push_back(tmp);
-						m_globalVarMutex.unlock();
-					}
-				}
-			}
-		}
+		rebuildSearchIndex(SymbolKind::GlobalVar, m_globalVarSymbols.get());
+		return;
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
+	publishEvent(EventType::GlobalsChanged);
+}
+
+bool GDBMI::parseDisassembly(std::string_view rawData, vector<DisassemblyInstruction> &insts)
+{
+	// asm_insns=[{address="0x...",func-name="main",offset="4",inst="..."},...]
+	
+	MIArena arena;
+	const MIValue *results = MIParser::parseResults(rawData, arena);
+	const MIValue *asmList = results->find(MIKey::AsmInsns);
+	
+	if(asmList == 0)
+		return false;
+		
+	insts.reserve(insts.size() + asmList->count);
+	
+	for(const MIValue &asmTuple : *asmList)
+		insts.push_back(disassemblySchema.bind(asmTuple));
 		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::GVarSymbols, m_notifyUserData);
+	return true;
 }
 
 void GDBMI::getDisassemblyCallback(GDBResponse resp)
@@ -549,139 +419,194 @@ void GDBMI::getDisassemblyCallback(GDBResponse resp)
 	
 	if(resp.recordData.length() > 0)
 	{
-		m_disasLinesMutex.lock();
-		m_disasLines.clear();
-		m_disasLinesMutex.unlock();
+		// Anything else is an error message, and isn't worth caching
+		bool isListing = parseDisassembly(resp.recordData, tmpBuf);
 		
-		string rawDisas = resp.recordData;
-		KVPair rootPair = parserGetKVPair(rawDisas);
-		string rawList = rootPair.second;
+		uint64_t version = m_disasLines.publish(tmpBuf);
 		
-		if(rawList.front() == '[')
-			rawList.erase(rawList.begin());
-			
-		if(rawList.back() == ']')
-			rawList.pop_back();
-			
-		ListItemVector disasList;
-		parserGetListItems(rawList, disasList);
+		if(isListing)
+			cacheDisassembly(std::move(tmpBuf), version);
+	}
+	
+	Event ev;
+	ev.type = EventType::DisassemblyChanged;
+	
+	Snapshot<DisassemblyInstruction> disas = m_disasLines.get();
+	if(disas->data.size() > 0)
+	{
+		ev.startAddr = disas->data.front().address;
+		ev.endAddr = disas->data.back().address;
+	}
+	
+	publishEvent(std::move(ev));
+}
+
+void GDBMI::getregNamesCallback(GDBResponse resp)
+{
+	if(resp.recordData.length() > 0)
+	{
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		const MIValue *nameList = results->find(MIKey::RegisterNames);
 		
-		for(auto &asmTuple : disasList)
+		if(nameList != 0)
 		{
-			string tuple = parserGetTuple(asmTuple);
-			
-			KVPairVector kvpList;
-			parserGetKVPairs(tuple, kvpList);
+			vector<RegisterInfo> regList;
+			regList.reserve(nameList->count);
 			
-			DisassemblyInstruction inst;
+			m_regNameListMutex.lock();
+			m_regNameList.clear();
 			
-			for(auto &kvp : kvpList)
+			for(const MIValue &name : *nameList)
 			{
-				if(kvp.first == "address")
-				{
-					inst.addrStr = kvp.second;
-					inst.address = strtoull(kvp.second.c_str(), 0, 16);
-				}
-				else if(kvp.first == "func-name")
-					inst.funcName = kvp.second;
-				else if(kvp.first == "offset")
-					inst.offset = kvp.second;
-				else if(kvp.first == "inst")
-					inst.instruction = kvp.second;
+				m_regNameList.emplace_back(name.text());
+				
+				RegisterInfo tmp;
+				tmp.regName = name.text();
+				tmp.regNum = regList.size();
+				regList.push_back(tmp);
 			}
 			
-			tmpBuf.push_back(inst);
+			m_regStale.assign(m_regNameList.size(), false);
+			
+			// No values yet, so the next stop fetches all of them
+			m_regValList.publish(std::move(regList));
+			m_regNameListMutex.unlock();
 		}
-		
-		m_disasLinesMutex.lock();
-		m_disasLines.swap(tmpBuf);
-		m_disasLinesMutex.unlock();
 	}
-	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::Disassembly, m_notifyUserData);
 }
 
-void GDBMI::getregNamesCallback(GDBResponse resp)
+void GDBMI::getChangedRegsCallback(GDBResponse resp)
 {
-	if(resp.recordData.length() > 0)
+	if(resp.recordData.length() == 0)
+		return;
+		
+	MIArena arena;
+	const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+	const MIValue *numList = results->find(MIKey::ChangedRegisters);
+	
+	if(numList == 0)
+		return;
+		
+	Snapshot<RegisterInfo> regs = m_regValList.get();
+	
+	m_regNameListMutex.lock();
+	
+	if(m_regStale.size() != m_regNameList.size())
+		m_regStale.assign(m_regNameList.size(), false);
+		
+	for(const MIValue &num : *numList)
 	{
-		string regNames = resp.recordData;
-		KVPair rootKVP = parserGetKVPair(regNames);
+		uint32_t regNum = 0;
+		miConvert(num.text(), regNum);
 		
-		if(rootKVP.first == "register-names")
+		if(regNum < m_regStale.size())
+			m_regStale[regNum] = true;
+	}
+	
+	// Everything has to be fetched if we don't hold a value for every named register yet
+	bool fullFetch = (regs->data.size() != m_regNameList.size());
+	for(uint32_t i = 0; i < regs->data.size() && fullFetch == false; i++)
+	{
+		if(m_regNameList[i].length() > 0 && regs->data[i].regValue.length() == 0)
+			fullFetch = true;
+	}
+	
+	string cmd = "-data-list-register-values x";
+	bool anyStale = false;
+	
+	if(fullFetch == false)
+	{
+		for(uint32_t i = 0; i < m_regStale.size(); i++)
 		{
-			string nameList = rootKVP.second;
-			if(nameList[0] == '[')
-				nameList.erase(nameList.begin());
-				
-			if(*(nameList.end() - 1) == ']')
-				nameList.pop_back();
-				
-			m_regNameListMutex.lock();
-			m_regNameList.clear();
-			
-			while(nameList.length() > 1)
+			if(m_regStale[i] && m_regNameList[i].length() > 0)
 			{
-				string item = parserGetItem(nameList);
-				m_regNameList.push_back(item);
+				cmd += " " + std::to_string(i);
+				anyStale = true;
 			}
-			m_regNameListMutex.unlock();
 		}
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
+	m_regNameListMutex.unlock();
+	
+	if(fullFetch || anyStale)
+	{
+		sendCoalesced(cmd, GDBMI::getregValsCallbackThunk, OrderDomain::Registers, true);
+		return;
+	}
+	
+	// Nothing changed since the last stop; only the change marks go
+	bool anyUpdated = false;
+	for(auto &reg : regs->data)
+	{
+		if(reg.updated)
+			anyUpdated = true;
+	}
+	
+	if(anyUpdated)
+	{
+		m_regValList.update([](vector<RegisterInfo> &regList)
+		{
+			for(auto &reg : regList)
+				reg.updated = false;
+		});
+		
+		publishEvent(EventType::RegistersChanged);
+	}
 }
 
 void GDBMI::getregValsCallback(GDBResponse resp)
 {
+	Event ev;
+	ev.type = EventType::RegistersChanged;
+	
 	if(resp.recordData.length() > 0)
 	{
-		string regData = resp.recordData;
-		KVPair rootKVP = parserGetKVPair(regData);
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		const MIValue *regValList = results->find(MIKey::RegisterValues);
 		
-		if(rootKVP.first == "register-values")
+		if(regValList != 0)
 		{
-			string regValList = rootKVP.second;
+			// The reply holds either every register or just the ones that
+			// changed; either way only the registers in it are touched
+			vector<RegisterInfo> regList = m_regValList.get()->data;
 			
-			if(regValList[0] == '[')
-				regValList.erase(regValList.begin());
-				
-			if(regValList.back() == ']')
-				regValList.pop_back();
-				
 			m_regNameListMutex.lock();
-			m_regValListMutex.lock();
 			
-			auto oldRegList = m_regValList;
-			m_regValList.clear();
-			
-			while(regValList.length() > 1)
+			if(regList.size() != m_regNameList.size())
 			{
-				string rvTuple = parserGetTuple(regValList);
+				regList.resize(m_regNameList.size());
+				for(uint32_t i = 0; i < regList.size(); i++)
+				{
+					regList[i].regName = m_regNameList[i];
+					regList[i].regNum = i;
+				}
+			}
+			
+			if(m_regStale.size() != m_regNameList.size())
+				m_regStale.assign(m_regNameList.size(), false);
 				
-				KVPair num = parserGetKVPair(rvTuple);
-				KVPair val = parserGetKVPair(rvTuple);
+			for(auto &reg : regList)
+				reg.updated = false;
 				
-				uint32_t regNum = strtoul(num.second.c_str(), 0, 10);
-				string regVal = val.second;
+			for(const MIValue &rvTuple : *regValList)
+			{
+				RegisterInfo value = registerValueSchema.bind(rvTuple);
+				
+				uint32_t regNum = value.regNum;
+				const string &regVal = value.regValue;
 				
 				if(regNum >= m_regNameList.size())
 					continue;
 					
+				m_regStale[regNum] = false;
+				
 				if(m_regNameList[regNum].length() == 0)
 					continue;
 					
-				RegisterInfo tmp;
-				tmp.regName = m_regNameList[regNum];
-				tmp.regSize = 0;
-				tmp.regValue = regVal;
+				RegisterInfo &reg = regList[regNum];
+				reg.regSize = 0;
 				
 				if(regVal.length() > 1 && regVal[0] == '0' && regVal[1] == 'x') // If we have a hex number...
 				{
@@ -699,21 +624,12 @@ void GDBMI::getregValsCallback(GDBResponse resp)
 					if(digitCount % 2 != 0)
 						digitCount++;
 						
-					tmp.regSize = digitCount / 2; // Register size in bytes is (# of hex digits) / 2
+					reg.regSize = digitCount / 2; // Register size in bytes is (# of hex digits) / 2
 				}
 				
-				// Check if this register value has changed
-				tmp.updated = false;
-				for(auto &oldreg : oldRegList)
-				{
-					if(oldreg.regName == tmp.regName)
-					{
-						if(oldreg.regValue != tmp.regValue)
-							tmp.updated = true;
-							
-						break;
-					}
-				}
+				// A register we had no value for yet doesn't count as changed
+				reg.updated = (reg.regValue.length() > 0 && reg.regValue != regVal);
+				reg.regValue = regVal;
 				
 				// TODO: I still need to handle the SIMD registers here.
 				//
@@ -732,85 +648,50 @@ void GDBMI::getregValsCallback(GDBResponse resp)
 				// I'm thinking it would probably be a good idea to call a per-architecture handler
 				// after processing the registers that have simple numerical values.
 				
-				m_regValList.push_back(tmp);
+				if(reg.updated)
+					ev.registers.push_back(regNum);
 			}
 			m_regNameListMutex.unlock();
-			m_regValListMutex.unlock();
+			
+			m_regValList.publish(std::move(regList));
 		}
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::RegisterInfo, m_notifyUserData);
+	publishEvent(std::move(ev));
 }
 
 void GDBMI::getStackFramesCallback(GDBResponse resp)
 {
 	if(resp.recordData.length() > 0)
 	{
-		string frameList = resp.recordData;
-		KVPair rootKVP = parserGetKVPair(frameList);
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		const MIValue *frames = results->find(MIKey::Stack);
 		
-		if(rootKVP.first == "stack")
+		if(frames != 0)
 		{
-			string list = rootKVP.second;
-			if(list[0] == '[')
-				list.erase(list.begin());
-				
-			if(list.back() == ']')
-				list.pop_back();
-				
-			KVPairVector frames;
-			parserGetKVPairs(list, frames);
-			
-			m_backtraceMutex.lock();
-			// m_backtrace.clear();
 			vector<FrameInfo> newBacktrace;
+			newBacktrace.reserve(frames->count);
 			
-			for(auto &frame : frames)
+			for(const MIValue &frame : *frames)
 			{
-				if(frame.first != "frame")
+				if(frame.id != MIKey::Frame)
 				{
 					logPrintf(LogLevel::Error, "getStackFramesCallback():%u - Unrecognized key value '%s'",
-							  __LINE__, frame.first.c_str());
+							  __LINE__, string(frame.key).c_str());
 							  
 					continue;
 				}
 				
-				string attrList = parserGetTuple(frame.second);
-				FrameInfo tmp;
-				
-				while(attrList.length() > 1)
-				{
-					KVPair attr = parserGetKVPair(attrList);
-					
-					if(attr.first == "level")
-						tmp.level = strtoul(attr.second.c_str(), 0, 10);
-					else if(attr.first == "addr")
-						tmp.addr = attr.second;
-					else if(attr.first == "func")
-						tmp.func = attr.second;
-					else if(attr.first == "file")
-						tmp.file = attr.second;
-					else if(attr.first == "fullname")
-						tmp.fullname = attr.second;
-					else if(attr.first == "line")
-						tmp.line = strtoul(attr.second.c_str(), 0, 10);
-					else if(attr.first == "arch")
-						tmp.arch = attr.second;
-				}
-				
-				newBacktrace.push_back(tmp);
+				newBacktrace.push_back(frameSchema.bind(frame));
 			}
 			
 			
 			// Copy the frame variable data over to the new backtrace
+			Snapshot<FrameInfo> oldBacktrace = m_backtrace.get();
 			for(auto &bt : newBacktrace)
 			{
-				for(auto &oldbt : m_backtrace)
+				for(auto &oldbt : oldBacktrace->data)
 				{
 					if(bt.fullname == oldbt.fullname &&
 							bt.func == oldbt.func &&
@@ -822,90 +703,42 @@ void GDBMI::getStackFramesCallback(GDBResponse resp)
 				}
 			}
 			
-			m_backtrace.swap(newBacktrace);
+			m_backtrace.publish(std::move(newBacktrace));
 			
-			char cmdStr[1024] = {0};
-			string cmdToken = getTokenStr();
-			registerCallback(cmdToken, GDBMI::getStackVarsCallbackThunk);
-			sprintf(cmdStr, "%s-stack-list-variables 2", cmdToken.c_str());
-			sendCommand(cmdStr);
-			
-			m_backtraceMutex.unlock();
+			sendCoalesced("-stack-list-variables 2", GDBMI::getStackVarsCallbackThunk, OrderDomain::Backtrace, true);
 		}
 	}
-	else
-	{
-		m_backtraceMutex.lock();
-		m_backtrace.clear();
-		m_backtraceMutex.unlock();
-	}
+	else m_backtrace.publish({});
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::Backtrace, m_notifyUserData);
+	publishEvent(EventType::BacktraceChanged);
 }
 
 void GDBMI::getStackVarsCallback(GDBResponse resp)
 {
 	if(resp.recordData.length() > 0)
 	{
-		string stackVarList = resp.recordData;
-		KVPair rootKVP = parserGetKVPair(stackVarList);
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		const MIValue *varList = results->find(MIKey::Variables);
 		
 		// variables=[{name="argc",arg="1",type="int",value="1"},{name="argv",arg="1",type="char **",value="0x7fffffffe178"},{name="fileBuffer",type="uint8_t *",value="0x0"},{name="fileSize",type="uint32_t",value="21845"},{name="hm",type="Huffman"},{name="cSize",type="uint32_t",value="1431654928"},{name="cData",type="uint8_t *",value="0x555555558250 <__libc_csu_init> \"AWAVA\\211\\377AUATL\\215%F+ \""}]
 		
-		if(rootKVP.first == "variables")
+		if(varList != 0)
 		{
-			string varList = rootKVP.second;
+			vector<FrameVariable> vars;
+			vars.reserve(varList->count);
 			
-			if(varList[0] == '[')
-				varList.erase(varList.begin());
+			for(const MIValue &var : *varList)
+				vars.push_back(frameVariableSchema.bind(var));
 				
-			if(varList.back() == ']')
-				varList.pop_back();
-				
-			m_backtraceMutex.lock();
-			
-			if(m_backtrace.size() > 0)
-				m_backtrace[0].vars.clear();
-				
-			while(varList.length() > 1)
+			// The variables belong to the innermost frame
+			m_backtrace.update([&](vector<FrameInfo> &backtrace)
 			{
-				string var = parserGetTuple(varList);
-				
-				KVPairVector varAttrs;
-				parserGetKVPairs(var, varAttrs);
-				
-				FrameVariable tmp;
-				tmp.isArg = false;
-				
-				for(auto &attr : varAttrs)
-				{
-					if(attr.first == "name")
-						tmp.name = attr.second;
-					else if(attr.first == "arg")
-						tmp.isArg = true;
-					else if(attr.first == "type")
-						tmp.type = attr.second;
-					else if(attr.first == "value")
-						tmp.value = attr.second;
-				}
-				
-				if(m_backtrace.size() > 0)
-					m_backtrace[0].vars.push_back(tmp);
-			}
-			
-			m_backtraceMutex.unlock();
+				if(backtrace.size() > 0)
+					backtrace[0].vars = vars;
+			});
 		}
 	}
 	
-	CallbackIter cb;
-	if(findCallback(resp.recordToken, cb) == true)
-		eraseCallback(cb);
-		
-	if(m_notifyCallback != 0)
-		m_notifyCallback(UpdateType::Backtrace, m_notifyUserData);
+	publishEvent(EventType::BacktraceChanged);
 }
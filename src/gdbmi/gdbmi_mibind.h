@@ -0,0 +1,109 @@
+#ifndef UNIQUE_GDBMI_MIBIND_H
+#define UNIQUE_GDBMI_MIBIND_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <charconv>
+#include <type_traits>
+
+#include "gdbmi_mivalue.h"
+
+/*
+	Binds the results in an MI tuple straight into the members of a
+	struct, from a field map written out once:
+	
+		static constexpr auto frameSchema = miSchema<FrameInfo>(
+			MIField(MIKey::Level, &FrameInfo::level),
+			MIField(MIKey::Addr, &FrameInfo::addr),
+			MIField(MIKey::Line, &FrameInfo::line));
+			
+		FrameInfo frame;
+		frameSchema.bind(frameTuple, frame);
+		
+	bind() goes through the tuple's results once. The key IDs the parser
+	tagged them with are compared against the map's, in a sequence of
+	integer compares the compiler unrolls, and a match is converted
+	straight from the record's text into the member (see miConvert()).
+	Two members can share a key, like an address kept both as a number
+	and as text. Results the map doesn't name are skipped, and members
+	without a result are left as they were.
+*/
+
+template<typename T, typename M>
+struct MIField
+{
+	constexpr MIField(MIKey key, M T::*member) : key(key), member(member) {}
+	
+	MIKey key;
+	M T::*member;
+};
+
+// Strings are copied as they appear in the record, escapes and all
+inline void miConvert(std::string_view text, std::string &out) { out = text; }
+
+// Points into the record's text, which has to outlive it
+inline void miConvert(std::string_view text, std::string_view &out) { out = text; }
+
+// MI flags are "y"/"n" (enabled="y"), or a "1" that's there or not (arg="1")
+inline void miConvert(std::string_view text, bool &out) { out = (text == "y" || text == "1"); }
+
+// Decimal, or hex with a 0x prefix. As with strtoul(), anything after the
+// digits is ignored, and no digits at all gives 0.
+template<typename N>
+inline std::enable_if_t<std::is_integral_v<N> && !std::is_same_v<N, bool>> miConvert(std::string_view text, N &out)
+{
+	int base = 10;
+	if(text.length() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+	{
+		text.remove_prefix(2);
+		base = 16;
+	}
+	
+	if(std::from_chars(text.data(), text.data() + text.length(), out, base).ec != std::errc())
+		out = 0;
+}
+
+template<typename T, typename... Fields>
+class MISchema
+{
+	public:
+	
+		constexpr MISchema(Fields... fields) : m_fields(fields...) {}
+		
+		// Fills in the members the map names from the results of 'tuple'
+		void bind(const MIValue &tuple, T &out) const
+		{
+			for(const MIValue &result : tuple)
+			{
+				if(result.id == MIKey::Unknown)
+					continue;
+					
+				std::apply([&](const Fields &... field)
+				{
+					((field.key == result.id ? miConvert(result.text(), out.*field.member) : void()), ...);
+				}, m_fields);
+			}
+		}
+		
+		T bind(const MIValue &tuple) const
+		{
+			T out;
+			bind(tuple, out);
+			
+			return out;
+		}
+		
+	private:
+	
+		std::tuple<Fields...> m_fields;
+};
+
+template<typename T, typename... Members>
+constexpr MISchema<T, MIField<T, Members>...> miSchema(MIField<T, Members>... fields)
+{
+	return MISchema<T, MIField<T, Members>...>(fields...);
+}
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef UNIQUE_GDBMI_MIKEY_H
+#define UNIQUE_GDBMI_MIKEY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string_view>
+
+/*
+	IDs for the result names the handlers look for, so MIParser can tag
+	each key once as it reads it and a callback can switch on the tag
+	instead of comparing strings field by field:
+	
+		for(const MIValue &field : asmTuple)
+		{
+			switch(field.id)
+			{
+				case MIKey::Address: ...
+				case MIKey::FuncName: ...
+			}
+		}
+		
+	The lookup is a perfect hash built at compile time. A key's length
+	and a few of its characters are multiplied by a constant, and the top
+	bits of the product pick one of 256 slots; the constant is searched
+	for (at compile time) until no two names share a slot. So a key costs
+	one multiply and one compare against the name in its slot, which
+	tells a known key from one that only hashes like it. Anything not in
+	the list is MIKey::Unknown, and is still there by name in
+	MIValue::key.
+	
+	To add a name, add it to both MIKey and MIKeyTable::names, in the
+	same place.
+*/
+
+enum class MIKey : uint8_t
+{
+	Unknown,
+	
+	// Lists and tuples
+	AsmInsns,
+	BreakpointTable,
+	Body,
+	Bkpt,
+	Stack,
+	Frame,
+	Args,
+	Locals,
+	Variables,
+	Symbols,
+	Debug,
+	Nondebug,
+	RegisterNames,
+	RegisterValues,
+	ChangedRegisters,
+	ThreadGroups,
+	
+	// Disassembly
+	Address,
+	FuncName,
+	Offset,
+	Inst,
+	
+	// Breakpoints
+	Number,
+	Type,
+	Disp,
+	Enabled,
+	Addr,
+	Times,
+	Func,
+	OriginalLocation,
+	
+	// Locations and symbols
+	File,
+	Fullname,
+	Filename,
+	Line,
+	Name,
+	Description,
+	Level,
+	Value,
+	Arg,
+	Arch,
+	From,
+	
+	// Stops
+	Reason,
+	SignalName,
+	ThreadId,
+	Bkptno,
+	StoppedThreads,
+	Core,
+	Id,
+	
+	Count
+};
+
+class MIKeyTable
+{
+	public:
+	
+		// The ID of a key, or MIKey::Unknown
+		static constexpr MIKey lookup(std::string_view key);
+		
+		static constexpr std::string_view name(MIKey id)
+		{
+			return ((size_t) id < (size_t) MIKey::Count) ? names[(size_t) id] : std::string_view();
+		}
+		
+	private:
+	
+		static constexpr std::string_view names[] =
+		{
+			"",
+			
+			"asm_insns",
+			"BreakpointTable",
+			"body",
+			"bkpt",
+			"stack",
+			"frame",
+			"args",
+			"locals",
+			"variables",
+			"symbols",
+			"debug",
+			"nondebug",
+			"register-names",
+			"register-values",
+			"changed-registers",
+			"thread-groups",
+			
+			"address",
+			"func-name",
+			"offset",
+			"inst",
+			
+			"number",
+			"type",
+			"disp",
+			"enabled",
+			"addr",
+			"times",
+			"func",
+			"original-location",
+			
+			"file",
+			"fullname",
+			"filename",
+			"line",
+			"name",
+			"description",
+			"level",
+			"value",
+			"arg",
+			"arch",
+			"from",
+			
+			"reason",
+			"signal-name",
+			"thread-id",
+			"bkptno",
+			"stopped-threads",
+			"core",
+			"id"
+		};
+		
+		static_assert(sizeof(names) / sizeof(names[0]) == (size_t) MIKey::Count, "MIKey and MIKeyTable::names don't match");
+		
+		static constexpr uint32_t SlotBits = 8;
+		static constexpr uint32_t MaxTries = 1000;
+		
+		struct Table
+		{
+			uint32_t multiplier;
+			std::array<MIKey, 1 << SlotBits> slots;
+		};
+		
+		// Only the length, the first two characters and the last one are
+		// hashed; that's enough to tell all the names apart, and costs the
+		// same for any key
+		static constexpr uint32_t slot(std::string_view key, uint32_t multiplier)
+		{
+			if(key.length() == 0)
+				return 0;
+				
+			uint32_t hash = (uint32_t) key.length() ^ ((uint32_t)(uint8_t) key[0] << 8) ^
+							((uint32_t)(uint8_t) key[key.length() > 1] << 16) ^ ((uint32_t)(uint8_t) key.back() << 24);
+							
+			return (hash * multiplier) >> (32 - SlotBits);
+		}
+		
+		static constexpr Table build()
+		{
+			// Odd multipliers, starting from the golden ratio one. Two names
+			// that hash the same whatever the multiplier is end the search,
+			// and the build.
+			for(uint32_t multiplier = 0x9E3779B1; multiplier != 0x9E3779B1 + 2 * MaxTries; multiplier += 2)
+			{
+				Table candidate = { multiplier, {} };
+				bool collision = false;
+				
+				for(size_t id = 1; id < (size_t) MIKey::Count && collision == false; id++)
+				{
+					MIKey &entry = candidate.slots[slot(names[id], multiplier)];
+					
+					collision = (entry != MIKey::Unknown);
+					entry = (MIKey) id;
+				}
+				
+				if(collision == false)
+					return candidate;
+			}
+			
+			noMultiplierFits();
+			return Table { 0, {} };
+		}
+		
+		// Not constexpr, so calling it stops the build
+		static void noMultiplierFits();
+		
+		static const Table table;
+};
+
+constexpr MIKeyTable::Table MIKeyTable::table = MIKeyTable::build();
+
+constexpr MIKey MIKeyTable::lookup(std::string_view key)
+{
+	MIKey id = table.slots[slot(key, table.multiplier)];
+	return (names[(size_t) id] == key) ? id : MIKey::Unknown;
+}
+
+#endif
@@ -0,0 +1,475 @@
+#include "gdbmi_mivalue.h"
+
+#include <algorithm>
+
+std::string_view MIValue::text() const
+{
+	// The root of parseResults() is a tuple without brackets
+	if(source.length() >= 2 && (source.front() == '"' || source.front() == '{' || source.front() == '['))
+		return source.substr(1, source.length() - 2);
+		
+	return source;
+}
+
+std::string_view MIValue::item() const
+{
+	if(key.length() == 0)
+		return source;
+		
+	return std::string_view(key.data(), (source.data() + source.length()) - key.data());
+}
+
+const MIValue *MIValue::find(std::string_view name) const
+{
+	for(const MIValue *c = child; c != 0; c = c->next)
+	{
+		if(c->key == name)
+			return c;
+	}
+	
+	return 0;
+}
+
+std::string_view MIValue::get(std::string_view name) const
+{
+	const MIValue *found = find(name);
+	if(found == 0)
+		return std::string_view();
+		
+	return found->text();
+}
+
+const MIValue *MIValue::find(MIKey key) const
+{
+	for(const MIValue *c = child; c != 0; c = c->next)
+	{
+		if(c->id == key)
+			return c;
+	}
+	
+	return 0;
+}
+
+std::string_view MIValue::get(MIKey key) const
+{
+	const MIValue *found = find(key);
+	if(found == 0)
+		return std::string_view();
+		
+	return found->text();
+}
+
+MIValue *MIArena::newValue()
+{
+	if(m_blocks.size() == 0 || m_used == m_blocks.back().size)
+	{
+		size_t size = (m_blocks.size() == 0) ? FirstBlockSize : std::min(m_blocks.back().size * 2, MaxBlockSize);
+		m_blocks.push_back({ std::make_unique<MIValue[]>(size), size });
+		m_used = 0;
+	}
+	
+	m_count++;
+	
+	// Blocks are reused after clear(), so this may hold an old value
+	MIValue *value = &m_blocks.back().values[m_used++];
+	*value = MIValue();
+	
+	return value;
+}
+
+void MIArena::clear()
+{
+	if(m_blocks.size() > 1)
+	{
+		size_t total = 0;
+		for(auto &block : m_blocks)
+			total += block.size;
+			
+		size_t size = std::min(total, MaxBlockSize);
+		
+		m_blocks.clear();
+		m_blocks.push_back({ std::make_unique<MIValue[]>(size), size });
+	}
+	
+	m_used = 0;
+	m_count = 0;
+}
+
+size_t MIArena::memoryUsage() const
+{
+	size_t bytes = sizeof(*this) + m_blocks.capacity() * sizeof(Block);
+	for(auto &block : m_blocks)
+		bytes += block.size * sizeof(MIValue);
+		
+	return bytes;
+}
+
+static bool isKeyChar(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+}
+
+const MIValue *MIParser::parseResults(std::string_view text, MIArena &arena, size_t *consumed)
+{
+	MIParser parser(text, arena);
+	
+	MIValue *root = arena.newValue();
+	root->kind = MIValue::Kind::Tuple;
+	root->source = text;
+	
+	parser.parseChildren(root, 0);
+	
+	if(consumed != 0)
+		*consumed = parser.m_pos;
+		
+	return root;
+}
+
+const MIValue *MIParser::parseItem(std::string_view text, MIArena &arena, size_t &consumed)
+{
+	MIParser parser(text, arena);
+	consumed = 0;
+	
+	MIValue *item = parser.parseItem();
+	if(item == 0)
+		return 0;
+		
+	if(parser.peek() == ',')
+		parser.m_pos++;
+		
+	consumed = parser.m_pos;
+	return item;
+}
+
+size_t MIParser::nextStructural()
+{
+	while(true)
+	{
+		while(m_next < m_structurals.size() && m_structurals[m_next] < m_pos)
+			m_next++;
+			
+		if(m_next < m_structurals.size())
+			return m_structurals[m_next];
+			
+		// Everything scanned so far is behind us
+		m_structurals.clear();
+		m_next = 0;
+		
+		if(m_scanner.scanMore(ScanAhead, m_structurals) == false)
+			return m_text.length();
+	}
+}
+
+MIValue *MIParser::parseItem()
+{
+	MIValue *item = m_arena.newValue();
+	
+	// A result starts with its name and an '='
+	size_t equals = nextStructural();
+	if(equals > m_pos && equals < m_text.length() && m_text[equals] == '=' &&
+			std::all_of(m_text.begin() + m_pos, m_text.begin() + equals, isKeyChar))
+	{
+		item->key = m_text.substr(m_pos, equals - m_pos);
+		item->id = tagKey(item->key);
+		m_pos = equals + 1;
+	}
+	
+	if(parseValue(item) == false)
+		return 0;
+		
+	return item;
+}
+
+bool MIParser::parseValue(MIValue *value)
+{
+	size_t start = m_pos;
+	char c = peek();
+	
+	if(c == '{' || c == '[')
+	{
+		value->kind = (c == '{') ? MIValue::Kind::Tuple : MIValue::Kind::List;
+		
+		// Left at its opening bracket for nextItem()
+		if(m_shallow)
+		{
+			value->source = m_text.substr(start, 0);
+			return true;
+		}
+		
+		m_pos++;
+		
+		if(parseChildren(value, (c == '{') ? '}' : ']') == false)
+			return false;
+			
+		m_pos++;
+	}
+	else if(c == '"')
+	{
+		// Nothing inside a string is structural, so the next one closes it
+		m_pos++;
+		size_t endQuote = nextStructural();
+		
+		// Unterminated
+		if(endQuote >= m_text.length() || m_text[endQuote] != '"')
+			return false;
+			
+		m_pos = endQuote + 1;
+	}
+	else
+	{
+		uint32_t depth = 0;
+		while(true)
+		{
+			m_pos = nextStructural();
+			if(m_pos >= m_text.length())
+				break;
+				
+			char ch = m_text[m_pos];
+			
+			if(ch == '{' || ch == '[')
+				depth++;
+			else if(ch == '}' || ch == ']')
+			{
+				if(depth == 0)
+					break;
+					
+				depth--;
+			}
+			else if(ch == ',' && depth == 0)
+				break;
+				
+			m_pos++;
+		}
+	}
+	
+	value->source = m_text.substr(start, m_pos - start);
+	return true;
+}
+
+bool MIParser::parseChildren(MIValue *parent, char close)
+{
+	MIValue *last = 0;
+	
+	while(peek() != close)
+	{
+		// Ran out of text before the closing bracket
+		if(m_pos >= m_text.length())
+			return false;
+			
+		size_t itemStart = m_pos;
+		
+		MIValue *item = parseItem();
+		if(item == 0 || (peek() != ',' && peek() != close))
+		{
+			m_pos = itemStart;
+			return false;
+		}
+		
+		if(last != 0)
+			last->next = item;
+		else parent->child = item;
+		
+		last = item;
+		parent->count++;
+		
+		if(peek() == ',')
+			m_pos++;
+	}
+	
+	return true;
+}
+
+bool MIParser::skipNested()
+{
+	// Quotes are the only structural characters inside strings, and they
+	// come in pairs, so counting brackets is enough
+	uint32_t depth = 0;
+	while(true)
+	{
+		m_pos = nextStructural();
+		if(m_pos >= m_text.length())
+			return false;
+			
+		char ch = m_text[m_pos++];
+		
+		if(ch == '{' || ch == '[')
+			depth++;
+		else if((ch == '}' || ch == ']') && --depth == 0)
+			return true;
+	}
+}
+
+bool MIParser::endItem(char close)
+{
+	if(peek() == ',')
+		m_pos++;
+	else if(peek() != close)
+	{
+		m_pos = m_text.length();
+		return false;
+	}
+	
+	return true;
+}
+
+MIValue *MIParser::nextItem(char close)
+{
+	if(finishOpen(close) == false || m_pos >= m_text.length() || peek() == close)
+		return 0;
+		
+	MIValue *item = parseItem();
+	if(item == 0)
+	{
+		m_pos = m_text.length();
+		return 0;
+	}
+	
+	if(item->kind != MIValue::Kind::Const)
+		m_open = item;
+	else if(endItem(close) == false)
+		return 0;
+		
+	return item;
+}
+
+bool MIParser::finishOpen(char close)
+{
+	if(m_open == 0)
+		return true;
+		
+	MIValue *open = m_open;
+	m_open = 0;
+	
+	size_t start = m_pos;
+	if(skipNested() == false)
+	{
+		m_pos = m_text.length();
+		return false;
+	}
+	
+	open->source = m_text.substr(start, m_pos - start);
+	return endItem(close);
+}
+
+std::string_view MIRecordView::get(std::string_view key)
+{
+	const MIValue *value = finish(lookup(*top(), key));
+	if(value == 0)
+		return std::string_view();
+		
+	return value->text();
+}
+
+std::string_view MIRecordView::get(std::string_view key, std::string_view name)
+{
+	const MIValue *value = finish(lookup(key, name));
+	if(value == 0)
+		return std::string_view();
+		
+	return value->text();
+}
+
+std::string_view MIRecordView::source(std::string_view key, std::string_view name)
+{
+	const MIValue *value = finish(lookup(key, name));
+	if(value == 0)
+		return std::string_view();
+		
+	return value->source;
+}
+
+const MIValue *MIRecordView::find(std::string_view key)
+{
+	Item *item = lookup(*top(), key);
+	if(finish(item) == 0)
+		return 0;
+		
+	MIValue *value = item->value;
+	
+	if(item->parsed == false && value->kind != MIValue::Kind::Const)
+	{
+		size_t consumed = 0;
+		const MIValue *full = MIParser::parseItem(value->item(), m_arena, consumed);
+		
+		// Its end has been found already, so its brackets match
+		if(full != 0)
+		{
+			value->count = full->count;
+			value->child = full->child;
+		}
+	}
+	
+	item->parsed = true;
+	return value;
+}
+
+MIRecordView::Item *MIRecordView::lookup(Level &level, std::string_view key)
+{
+	for(Item &item : level.items)
+	{
+		if(item.value->key == key)
+			return &item;
+	}
+	
+	while(level.done == false)
+	{
+		MIValue *value = level.parser.nextItem(level.close);
+		if(value == 0)
+		{
+			level.done = true;
+			break;
+		}
+		
+		level.items.push_back({ value, &level });
+		
+		if(value->key == key)
+			return &level.items.back();
+	}
+	
+	return 0;
+}
+
+MIRecordView::Item *MIRecordView::lookup(std::string_view key, std::string_view name)
+{
+	Item *item = lookup(*top(), key);
+	if(item == 0 || item->value->kind != MIValue::Kind::Tuple)
+		return 0;
+		
+	// From just inside its opening bracket to the end of the record, so
+	// its end doesn't have to be found first
+	if(item->level == 0)
+	{
+		const char *inside = item->value->source.data() + 1;
+		std::string_view rest(inside, (m_text.data() + m_text.length()) - inside);
+		
+		m_levels.push_back(std::make_unique<Level>(rest, m_arena, '}'));
+		item->level = m_levels.back().get();
+	}
+	
+	return lookup(*item->level, name);
+}
+
+const MIValue *MIRecordView::finish(Item *item)
+{
+	if(item == 0)
+		return 0;
+		
+	MIParser &parser = item->owner->parser;
+	
+	if(parser.m_open == item->value && parser.finishOpen(item->owner->close) == false)
+		item->owner->done = true;
+		
+	// A tuple or list always has its brackets in its source
+	if(item->value->kind != MIValue::Kind::Const && item->value->source.length() == 0)
+		return 0;
+		
+	return item->value;
+}
+
+MIRecordView::Level *MIRecordView::top()
+{
+	if(m_levels.size() == 0)
+		m_levels.push_back(std::make_unique<Level>(m_text, m_arena, '\0'));
+		
+	return m_levels.front().get();
+}
@@ -0,0 +1,289 @@
+#ifndef UNIQUE_GDBMI_MIVALUE_H
+#define UNIQUE_GDBMI_MIVALUE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <memory>
+#include <string_view>
+
+#include "gdbmi_scan.h"
+#include "gdbmi_mikey.h"
+
+/*
+	A parsed MI value: a constant (a C string, or a bare word), a tuple
+	of name=value results, or a list of values or results.
+	
+	MIParser builds the whole tree for a record in one pass over its text.
+	Nothing is copied: keys and values are string_views into the text,
+	with quotes and brackets trimmed but escapes left as GDB sent them
+	(which is what the parserGet* helpers have always returned). The
+	values come out of an MIArena in blocks, so a record with a hundred
+	thousand values costs a handful of allocations, and they're all freed
+	together. The text and the arena have to outlive the tree.
+	
+	Walking a tuple or list:
+	
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults(resp.recordData, arena);
+		
+		for(const MIValue &frame : *results->find("stack"))
+			printf("%s\n", string(frame.get("addr")).c_str());
+			
+	Keys are tagged with their MIKey as they're parsed, so a handler going
+	through the fields of a tuple can switch on 'id'.
+*/
+
+struct MIValue
+{
+	enum class Kind : uint8_t
+	{
+		Const,
+		Tuple,
+		List
+	};
+	
+	Kind kind = Kind::Const;
+	MIKey id = MIKey::Unknown;	// The key's ID, if it's one MIKeyTable knows
+	uint32_t count = 0;			// Children of a tuple or list
+	
+	std::string_view key;		// Empty for values in a list
+	std::string_view source;	// As it appears in the text, quotes and brackets included
+	
+	const MIValue *child = 0;	// First child of a tuple or list
+	const MIValue *next = 0;	// Next in the parent tuple or list
+	
+	// A constant without its quotes, or a tuple or list without its brackets
+	std::string_view text() const;
+	
+	// "key=value" as it appears in the text; just the value if it has no key
+	std::string_view item() const;
+	
+	// First child with the given key, or 0
+	const MIValue *find(std::string_view name) const;
+	
+	// text() of the first child with the given key, or an empty view
+	std::string_view get(std::string_view name) const;
+	
+	// The same, by ID, which saves the string compares
+	const MIValue *find(MIKey key) const;
+	std::string_view get(MIKey key) const;
+	
+	struct Iterator
+	{
+		const MIValue *value;
+		
+		const MIValue &operator*() const { return *value; }
+		const MIValue *operator->() const { return value; }
+		Iterator &operator++() { value = value->next; return *this; }
+		bool operator!=(const Iterator &other) const { return value != other.value; }
+	};
+	
+	// The children of a tuple or list, in order
+	Iterator begin() const { return { child }; }
+	Iterator end() const { return { 0 }; }
+};
+
+class MIArena
+{
+	public:
+	
+		MIValue *newValue();
+		
+		// Frees every value handed out. What's left is one block as big as
+		// the ones freed (up to MaxBlockSize), so parsing another record
+		// like the last one doesn't allocate.
+		void clear();
+		
+		size_t valueCount() const { return m_count; }
+		
+		// Bytes held by the blocks
+		size_t memoryUsage() const;
+		
+	private:
+	
+		// Blocks double in size, so small records stay small
+		static constexpr size_t FirstBlockSize = 16;
+		static constexpr size_t MaxBlockSize = 4096;
+		
+		struct Block
+		{
+			std::unique_ptr<MIValue[]> values;
+			size_t size;
+		};
+		
+		std::vector<Block> m_blocks;
+		size_t m_used = 0;	// In the last block
+		size_t m_count = 0;
+};
+
+/*
+	Recursive descent over the MI output grammar, in one pass over the
+	text with no copies. It's forgiving in the same ways the old parsers
+	were: a bare word runs up to the next comma or closing bracket (and may
+	hold balanced brackets of its own, but not quotes), and tuples may
+	hold plain values as well as results.
+	
+	The parser doesn't look at every character. An MIScanner finds the
+	quotes, brackets, commas and equals signs a few kilobytes ahead, and
+	the parser jumps between those: from an opening quote straight to the
+	closing one, from a key to its '='. Only the offsets still ahead are
+	kept, so a huge record doesn't need an index as big as itself.
+*/
+
+class MIParser
+{
+	public:
+	
+		// Parses a record's results ("key=value,key=value,..." after the
+		// record class) into a tuple whose source is the whole text.
+		// Parsing stops at the first malformed item; the ones before it are
+		// kept, and 'consumed' (if given) says how far it got.
+		static const MIValue *parseResults(std::string_view text, MIArena &arena, size_t *consumed = 0);
+		
+		// Parses the single item ("key=value" or a value) text starts with.
+		// 'consumed' is its length, plus the comma after it if there is one.
+		// Returns 0, with nothing consumed, if it's malformed.
+		static const MIValue *parseItem(std::string_view text, MIArena &arena, size_t &consumed);
+		
+		#ifdef BUILD_GDBMI_TESTS
+		// Benchmarks turn this off to time a parse without the key IDs
+		static inline bool tagKeys = true;
+		
+	private:
+	
+		static MIKey tagKey(std::string_view key) { return tagKeys ? MIKeyTable::lookup(key) : MIKey::Unknown; }
+		#else
+	private:
+	
+		static MIKey tagKey(std::string_view key) { return MIKeyTable::lookup(key); }
+		#endif
+		
+		friend class MIRecordView;
+		
+		MIParser(std::string_view text, MIArena &arena) : m_text(text), m_arena(arena), m_scanner(text) {}
+		
+		// Bytes scanned for structural characters at a time
+		static constexpr size_t ScanAhead = 4096;
+		
+		char peek() const { return (m_pos < m_text.length()) ? m_text[m_pos] : 0; }
+		
+		// Offset of the first structural character at or after m_pos, or
+		// the length of the text if there are none
+		size_t nextStructural();
+		
+		MIValue *parseItem();
+		bool parseValue(MIValue *value);
+		
+		// Items up to the closing character ('\0' for the end of the text)
+		bool parseChildren(MIValue *parent, char close);
+		
+		// Moves past the tuple or list starting at m_pos without parsing it
+		bool skipNested();
+		
+		// After an item: past the comma, or at 'close'. Ends the parse if
+		// it's anything else.
+		bool endItem(char close);
+		
+		// The next item of a shallow parse, or 0 at 'close', the end of the
+		// text, or a malformed item (which ends it). A tuple or list is
+		// handed out before its end is found, with an empty source.
+		MIValue *nextItem(char close);
+		
+		// Finds the end of the tuple or list nextItem() handed out last, if
+		// it hasn't been, and sets its source
+		bool finishOpen(char close);
+		
+		std::string_view m_text;
+		size_t m_pos = 0;
+		MIArena &m_arena;
+		
+		// Tuples and lists aren't parsed, and come back without children
+		bool m_shallow = false;
+		MIValue *m_open = 0;	// The one whose end hasn't been found yet
+		
+		MIScanner m_scanner;
+		std::vector<uint32_t> m_structurals;	// From the last scan
+		size_t m_next = 0;						// First one in m_structurals not behind m_pos
+};
+
+/*
+	Lazy access to the results of a record, for the handlers that only want
+	a few fields out of it. Nothing is looked at until the first lookup,
+	and then only as far as the field asked for: the top level is split
+	into items one at a time, and a tuple or list is only skipped over
+	(bracket to bracket, without building anything) when a lookup has to
+	get past it. Looking inside a tuple starts at its opening bracket and
+	works the same way, so in
+	
+		reason="breakpoint-hit",frame={addr="0x...",func="main",args=[...]},...
+		
+	get("reason") and get("frame", "addr") never go past the start of args,
+	however many arguments there are. find() is there for handlers that
+	want a whole value as an MIValue tree; it parses just that value.
+	
+	The text has to outlive the view.
+*/
+
+class MIRecordView
+{
+	public:
+	
+		explicit MIRecordView(std::string_view text) : m_text(text) {}
+		
+		MIRecordView(const MIRecordView &) = delete;
+		MIRecordView &operator=(const MIRecordView &) = delete;
+		
+		// text() of the top level value with the given key, or an empty view
+		std::string_view get(std::string_view key);
+		
+		// text() of a value in a top level tuple ("frame", "addr"), or an empty view
+		std::string_view get(std::string_view key, std::string_view name);
+		
+		// Same, but the source, brackets and quotes included
+		std::string_view source(std::string_view key, std::string_view name);
+		
+		// The top level value with the given key, parsed in full, or 0
+		const MIValue *find(std::string_view key);
+		
+	private:
+	
+		struct Level;
+		
+		struct Item
+		{
+			MIValue *value;			// Without children until 'parsed' is set
+			Level *owner;
+			Level *level = 0;		// Its items, if a lookup has gone inside it
+			bool parsed = false;
+		};
+		
+		// The items of one tuple, found as they're asked for
+		struct Level
+		{
+			Level(std::string_view text, MIArena &arena, char close) : parser(text, arena), close(close)
+			{
+				parser.m_shallow = true;
+			}
+			
+			MIParser parser;
+			char close;
+			std::vector<Item> items;
+			bool done = false;
+		};
+		
+		// First item with the given key, splitting off more as needed
+		Item *lookup(Level &level, std::string_view key);
+		Item *lookup(std::string_view key, std::string_view name);
+		
+		// The item's value with its source set, or 0 if its end can't be found
+		const MIValue *finish(Item *item);
+		
+		Level *top();
+		
+		std::string_view m_text;
+		MIArena m_arena;
+		std::vector<std::unique_ptr<Level>> m_levels;
+};
+
+#endif
@@ -21,212 +21,106 @@ GDBMI::ParseItemType GDBMI::getItemType(char x)
 	return ret;
 }
 
-string GDBMI::parserGetItem(string &str)
+// The helpers below are kept for the callbacks written against them. Each
+// parses with MIParser and copies out what it has always returned.
+
+// Strings without their quotes; tuples and lists as they appear
+static string valueString(const MIValue *value)
 {
-	char startChar = 0;
-	if(str[0] == '[')
-		startChar = '[';
-	else if(str[0] == '{')
-		startChar = '{';
-	else if(str[0] == '"')
-		startChar = '"';
-		
-	switch(startChar)
-	{
-		case '[':
-		{
-			int32_t tokenCnt = 1;
-			int32_t endPos = -1;
-			for(int32_t i = 1; i < (int32_t) str.length(); i++)
-			{
-				if(str[i] == '[') tokenCnt++;
-				if(str[i] == ']') tokenCnt--;
-				
-				if(tokenCnt <= 0)
-				{
-					endPos = i;
-					break;
-				}
-			}
-			
-			if(endPos == -1) // Invalid list item. Return empty string
-				return "";
-				
-			string ret = str.substr(0, endPos + 1);
-			str = str.substr(endPos + 1);
-			
-			if(str.length() > 0 && str[0] == ',')
-				str.erase(str.begin());
-				
-			return ret;
-		}
-		break;
+	if(value->kind == MIValue::Kind::Const)
+		return string(value->text());
 		
-		case '{':
-		{
-			int32_t tokenCnt = 1;
-			int32_t endPos = -1;
-			for(int32_t i = 1; i < (int32_t) str.length(); i++)
-			{
-				if(str[i] == '{') tokenCnt++;
-				if(str[i] == '}') tokenCnt--;
-				
-				if(tokenCnt <= 0)
-				{
-					endPos = i;
-					break;
-				}
-			}
-			
-			if(endPos == -1) // Invalid list item. Return empty string
-				return "";
-				
-			string ret = str.substr(0, endPos + 1);
-			str = str.substr(endPos + 1);
-			
-			if(str.length() > 0 && str[0] == ',')
-				str.erase(str.begin());
-				
-			return ret;
-		}
-		break;
+	return string(value->source);
+}
+
+// A list item. One with a key ("name=value") comes back as it appears.
+static string itemString(const MIValue *item)
+{
+	if(item->key.length() > 0)
+		return string(item->item());
 		
-		case '"':
-		{
-			// fprintf(stderr, "Parsing string ('%s')\n", str.c_str());
-			int32_t endPos = -1;
-			for(int32_t i = 1; i < (int32_t) str.length(); i++)
-			{
-				if(str[i] == '"')
-				{
-					if(str[i - 1] == '\\')
-						continue;
-						
-					if(i == (int32_t)(str.length() - 1) || str[i + 1] == ',' || str[i + 1] == '}' || str[i + 1] == ']')
-					{
-						endPos = i;
-						break;
-					}
-				}
-			}
-			
-			if(endPos == -1) // Invalid list item. Return empty string
-				return "";
-				
-			string ret = str.substr(0, endPos + 1);
-			str = str.substr(endPos + 1);
-			
-			if(ret[0]  == '"')
-				ret.erase(ret.begin());
-				
-			if(*(ret.end() - 1) == '"')
-				ret.erase(ret.end() - 1);
-				
-			if(str.length() > 0 && str[0] == ',')
-				str.erase(str.begin());
-				
-			return ret;
-		}
-		break;
+	return valueString(item);
+}
+
+string GDBMI::parserGetItem(string &str)
+{
+	MIArena arena;
+	size_t consumed = 0;
+	
+	const MIValue *item = MIParser::parseItem(str, arena, consumed);
+	if(item == 0) // Invalid item. Return empty string
+		return "";
 		
-		default:
-		{
-			// fprintf(stderr, "Parsing default ('%s')\n", str.c_str());
-			int32_t endPos = -1;
-			for(int32_t i = 0; i < (int32_t) str.length(); i++)
-			{
-				if(str[i] == ',' || str[i] == '}' || str[i] == ']' || i == (int32_t)(str.length() - 1))
-				{
-					endPos = i;
-					break;
-				}
-			}
-			
-			if(endPos == -1) // Should never happen...
-				return "";
-				
-			string ret = str.substr(0, endPos);
-			str = str.substr(endPos + 1);
-			
-			if(str.length() > 0 && str[0] == ',')
-				str.erase(str.begin());
-				
-			return ret;
-		}
-	}
+	string ret = itemString(item);
+	str.erase(0, consumed);
 	
-	return "";
+	return ret;
 }
 
 void GDBMI::parserGetListItems(string &str, ListItemVector &liVector)
 {
-	while(str.length() > 0)
+	MIArena arena;
+	size_t consumed = 0;
+	
+	const MIValue *items = MIParser::parseResults(str, arena, &consumed);
+	for(const MIValue &item : *items)
 	{
-		ListItem item = parserGetItem(str);
+		ListItem li = itemString(&item);
 		
-		if(item.length() > 0)
-			liVector.push_back(item);
+		if(li.length() > 0)
+			liVector.push_back(li);
 	}
+	
+	str.erase(0, consumed);
 }
 
 KVPair GDBMI::parserGetKVPair(string &str)
 {
-	size_t findEq = str.find_first_of('=');
+	MIArena arena;
+	size_t consumed = 0;
 	
-	if(findEq == string::npos)
+	const MIValue *item = MIParser::parseItem(str, arena, consumed);
+	if(item == 0 || item->key.length() == 0)
 		return {"", ""};
 		
-	string key = str.substr(0, findEq);
-	str = str.substr(findEq + 1);
+	KVPair kvp = { string(item->key), valueString(item) };
+	str.erase(0, consumed);
 	
-	if(key[0]  == '"')
-		key.erase(key.begin());
-		
-	if(*(key.end() - 1) == '"')
-		key.erase(key.end() - 1);
-		
-	string val = parserGetItem(str);
-	
-	return {key, val};
+	return kvp;
 }
 
 void GDBMI::parserGetKVPairs(string &str, KVPairVector &kvpVector)
 {
-	size_t lastLen = 0;
-	while(str.length() > 0 && str.length() != lastLen)
+	MIArena arena;
+	size_t consumed = 0;
+	
+	const MIValue *items = MIParser::parseResults(str, arena, &consumed);
+	for(const MIValue &item : *items)
 	{
-		lastLen = str.length();
-		KVPair kvp = parserGetKVPair(str);
+		// Stops at the first item that isn't a pair
+		if(item.key.length() == 0)
+		{
+			consumed = item.source.data() - str.data();
+			break;
+		}
 		
-		if(str.length() != lastLen)
-			kvpVector.push_back(kvp);
+		kvpVector.push_back({ string(item.key), valueString(&item) });
 	}
+	
+	str.erase(0, consumed);
 }
 
 string GDBMI::parserGetTuple(string &str)
 {
-	int32_t tokenCnt = 1;
-	int32_t endPos = -1;
-	for(int32_t i = 1; i < (int32_t) str.length(); i++)
-	{
-		if(str[i] == '{') tokenCnt++;
-		if(str[i] == '}') tokenCnt--;
-		
-		if(tokenCnt <= 0)
-		{
-			endPos = i;
-			break;
-		}
-	}
+	MIArena arena;
+	size_t consumed = 0;
 	
-	if(endPos == -1) // Invalid list item. Return empty string
+	const MIValue *item = MIParser::parseItem(str, arena, consumed);
+	if(item == 0 || item->kind != MIValue::Kind::Tuple) // Invalid tuple. Return empty string
 		return "";
 		
-	string ret = str.substr(1, endPos - 1);
-	str = str.substr(endPos + 1);
+	string ret(item->text());
+	str.erase(0, consumed);
 	
-	if(str.length() > 0 && str[0] == ',')
-		str.erase(str.begin());
-		
 	return ret;
 }
@@ -34,7 +34,10 @@ class GDBMI
 			then the parser would parse "[some text]," leaving
 			"[some more text"] remaining in the input string.
 			Note the comma has also been removed.
-		
+			
+			They're adapters over MIParser (see gdbmi_mivalue.h), which
+			new code should use directly: it parses a whole record in one
+			pass, where these copy out each piece they return.
 		*/
 		
 		string parserGetItem(string &str);
@@ -1,169 +1,341 @@
 #include "gdbmi_private.h"
 
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <csignal>
+#include <algorithm>
+#include <spawn.h>
+#include <sys/wait.h>
+
 #include "gdbmi.h"
 #ifndef SOMETHING_UNIQUE_GDBMI_H
 // #include "gdbmi_pipe.h"
 #endif
 
-void GDBMI::initPipe()
+void GDBMI::initPipe(const LaunchOptions &options)
 {
 	m_gdbPipeIn[0] = 0;
 	m_gdbPipeIn[1] = 0;
 	m_gdbPipeOut[0] = 0;
 	m_gdbPipeOut[1] = 0;
 	m_gdbPID = 0;
+	m_commandWindow = std::max<uint32_t>(options.commandWindow, 1);
+	
+	m_epollFD = epoll_create1(EPOLL_CLOEXEC);
+	m_wakeFD = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	
+	if(m_epollFD < 0 || m_wakeFD < 0)
+		logPrintf(LogLevel::Error, "Failed to create the epoll/eventfd descriptors (errno = %d)\n", errno);
+		
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = m_wakeFD;
+	epoll_ctl(m_epollFD, EPOLL_CTL_ADD, m_wakeFD, &ev);
+	
+	if(runGDB(options))
+	{
+		ev.events = EPOLLIN;
+		ev.data.fd = m_gdbPipeOut[0];
+		epoll_ctl(m_epollFD, EPOLL_CTL_ADD, m_gdbPipeOut[0], &ev);
+	}
+	else setReady(true); // Don't make waitReady() sit out its timeout
 	
-	runGDB("/home/aj/code/official-gdb/gdb_bin/bin/gdb");
 	m_readThreadHandle = thread(GDBMI::readThreadThunk, this);
 }
 
 void GDBMI::destroyPipe()
 {
+	wakeReadThread();
 	m_readThreadHandle.join();
+	
+	stopGDB();
+	
+	if(m_epollFD >= 0)
+		close(m_epollFD);
+		
+	if(m_wakeFD >= 0)
+		close(m_wakeFD);
+}
+
+void GDBMI::wakeReadThread()
+{
+	uint64_t one = 1;
+	if(write(m_wakeFD, &one, sizeof(one)) < 0 && errno != EAGAIN)
+		fprintf(stderr, "[%s:%u] write() to eventfd failed (errno = %d)\n", __FILE__, __LINE__, errno);
 }
 
 void GDBMI::readThread()
 {
-	std::string gdbResponseBuf;
+	// If GDB goes away, writev() should fail with EPIPE
+	// rather than raising SIGPIPE on this thread
+	sigset_t sigpipeMask;
+	sigemptyset(&sigpipeMask);
+	sigaddset(&sigpipeMask, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &sigpipeMask, 0);
+	
+	epoll_event events[4];
+	
 	while(!m_exitThreads)
 	{
-		if(readPipe(gdbResponseBuf))
+		// Wake up in time to fail the next command that runs out of time
+		int32_t evCount = epoll_wait(m_epollFD, events, 4, nextCommandTimeout());
+		
+		if(evCount < 0)
 		{
-			while(gdbResponseBuf.length() > 0)
-			{
-				// Strip any newlines off the beginning of the string
-				while(gdbResponseBuf.length() > 0 && gdbResponseBuf[0] == '\n')
-					gdbResponseBuf.erase(gdbResponseBuf.begin());
-					
-				// Search for the next newline in the string
-				size_t nlPos = gdbResponseBuf.find_first_of('\n');
-				if(nlPos == string::npos)
-					break;
-					
-				// GDB sends MI responses separated by newlines.
-				// We want to parse only one command at a time,
-				// So we just grab the text up to the first newline.
-				
-				string respStr = gdbResponseBuf.substr(0, nlPos);
-				gdbResponseBuf = gdbResponseBuf.substr(nlPos + 1);
+			if(errno == EINTR)
+				continue;
 				
-				// printf("Raw input: \t%s\n", respStr.substr(0, 400).c_str());
+			fprintf(stderr, "[%s:%u] epoll_wait() failed (errno = %d)\n", __FILE__, __LINE__, errno);
+			break;
+		}
+		
+		for(int32_t e = 0; e < evCount; e++)
+		{
+			if(events[e].data.fd == m_wakeFD)
+			{
+				uint64_t counter = 0;
+				while(read(m_wakeFD, &counter, sizeof(counter)) > 0);
 				
-				// Pass the response string off to the response handlers
-				handleResponse(respStr);
+				// Woken up by queueCommand()
+				if(m_gdbPipeIn[1] > 0)
+					setWriteWatch(writePipe() == false);
+					
+				continue;
 			}
 			
-			usleep(1000 * 10);
+			if(events[e].data.fd == m_gdbPipeIn[1])
+			{
+				// The pipe has room again
+				setWriteWatch(writePipe() == false);
+				continue;
+			}
+			
+			if(readPipe())
+			{
+				dispatchFramed();
+				
+				// Answers free up room in the window for queued commands
+				if(m_gdbPipeIn[1] > 0)
+					setWriteWatch(writePipe() == false);
+			}
+			else if(events[e].events & (EPOLLHUP | EPOLLERR))
+			{
+				// The write end of the pipe is gone (GDB exited). Stop watching
+				// it, otherwise epoll_wait() would keep reporting the hangup.
+				epoll_ctl(m_epollFD, EPOLL_CTL_DEL, m_gdbPipeOut[0], 0);
+				logPrintf(LogLevel::Error, "GDB closed its output pipe\n");
+				setReady(true);
+				failPendingCommands(MIResult::Status::GDBExited);
+			}
 		}
-		else usleep(1000 * 100);
+		
+		expireCommands();
 	}
 	
 	fprintf(stderr, "readThread() is exiting!\n");
 }
 
-bool GDBMI::readPipe(string &out)
+void GDBMI::dispatchFramed()
 {
-	char readBuf[4096];
-	memset(readBuf, 0, 4096);
-	
-	bool noDataRead = true;
-	int32_t readRes = 0;
-	int32_t readFailCount = 0;
-	
-	std::string tmpStr;
-	
-	while((readRes = read(m_gdbPipeOut[0], readBuf, 4095)) > 0)
+	// GDB sends MI responses separated by newlines.
+	// The framer hands us one record at a time as a view
+	// into its buffer, so nothing is copied here.
+	std::string_view respStr;
+	while(m_framer.nextLine(respStr))
 	{
-		if(readRes == -1 && errno == EAGAIN)
-		{
-			if(readFailCount >= 3)
-				break;
-				
-			readFailCount++; // So we don't wait forever
-			usleep(1000 * 10);
-			continue;
-		}
+		// printf("Raw input: \t%.*s\n", (int) respStr.length(), respStr.data());
 		
-		if(readRes == -1 && errno != EAGAIN)
+		// The end of a symbol list that's been parsed as it came in
+		if(m_symbolStream.parser != 0)
 		{
-			if(readFailCount >= 3)
-				break;
-				
-			fprintf(stderr, "[%s:%u] read() failed (errno = %d)\n", __FILE__, __LINE__, errno);
-			perror("Error");
-			
-			readFailCount++;
-			usleep(1000 * 100);
+			finishSymbolStream(respStr);
 			continue;
 		}
 		
-		if(readRes > 0)
-			noDataRead = false;
-			
-		readFailCount = 0;
-		
-		tmpStr.append(readBuf);
-		memset(readBuf, 0, 4096);
+		// Pass the response string off to the response handlers
+		handleResponse(respStr);
 	}
 	
-	out.append(tmpStr);
-	return !(noDataRead);
+	streamSymbols();
 }
 
-bool GDBMI::writePipe(string cmd)
+bool GDBMI::readPipe()
 {
-	const char *sendBuf = cmd.c_str();
-	// printf("Raw write: %s\n", sendBuf);
-	int32_t sentBytes = 0;
-	int32_t writeRes = 0;
+	bool noDataRead = true;
+	ssize_t readRes = 0;
+	size_t readBytes = 0;
 	
-	errno = 0;
-	while((writeRes = write(m_gdbPipeIn[1], sendBuf, (cmd.length() - sentBytes))) > 0)
+	// The pipe is non-blocking, so this reads whatever is available and
+	// stops at EAGAIN (or EOF), or after a burst. epoll_wait() reports the
+	// pipe again if there's more. Data goes straight into the framer.
+	while(readBytes < GDB_READ_BURST_BYTES)
 	{
-		sentBytes += writeRes;
-		sendBuf += writeRes;
-		usleep(1000 * 10);
+		char *readBuf = m_framer.writePtr(16 * 1024);
+		readRes = read(m_gdbPipeOut[0], readBuf, m_framer.freeSpace());
+		
+		if(readRes <= 0)
+			break;
+			
+		noDataRead = false;
+		readBytes += readRes;
+		m_framer.commit(readRes);
 	}
 	
-	if(writeRes < 0 && errno != EAGAIN)
+	if(readRes < 0 && errno != EAGAIN && errno != EINTR)
 	{
-		fprintf(stderr, "[%s:%u] write() failed (errno = %d)\n", __FILE__, __LINE__, errno);
+		fprintf(stderr, "[%s:%u] read() failed (errno = %d)\n", __FILE__, __LINE__, errno);
 		perror("Error");
 	}
 	
-	if(writeRes < 0 && errno == EAGAIN)
-		writeRes = 0;
+	return !(noDataRead);
+}
+
+void GDBMI::queueCommand(string cmd, uint32_t token, CmdPriority priority)
+{
+	m_outQueueMutex.lock();
+	m_outQueues[(size_t) priority].push_back({std::move(cmd), token});
+	m_outQueueMutex.unlock();
+	
+	wakeReadThread();
+}
+
+void GDBMI::scheduleCommands()
+{
+	while(m_unanswered.size() < m_commandWindow)
+	{
+		size_t lane = 0;
+		for(; lane < (size_t) CmdPriority::Count; lane++)
+		{
+			if(lane == (size_t) CmdPriority::Bulk && m_unansweredBulk > 0)
+				continue;
+				
+			if(m_outQueues[lane].size() > 0)
+				break;
+		}
 		
-	return (writeRes >= 0);
+		if(lane == (size_t) CmdPriority::Count)
+			return;
+			
+		OutboundCommand &cmd = m_outQueues[lane].front();
+		m_unanswered.emplace_back(cmd.token, (CmdPriority) lane);
+		
+		if(lane == (size_t) CmdPriority::Bulk)
+			m_unansweredBulk++;
+			
+		m_writeQueue.push_back(std::move(cmd.text));
+		m_outQueues[lane].pop_front();
+	}
 }
 
-bool GDBMI::runGDB(std::string gdbPath)
+void GDBMI::commandAnswered(uint32_t token)
 {
+	m_outQueueMutex.lock();
+	
+	// GDB answers in order, so this is almost always the front entry
+	for(auto it = m_unanswered.begin(); it != m_unanswered.end(); it++)
+	{
+		if(it->first != token)
+			continue;
+			
+		if(it->second == CmdPriority::Bulk)
+			m_unansweredBulk--;
+			
+		m_unanswered.erase(it);
+		break;
+	}
+	
+	m_outQueueMutex.unlock();
+}
 
-	int pipeRes1 = pipe(m_gdbPipeIn);
-	int pipeRes2 = pipe(m_gdbPipeOut);
+bool GDBMI::writePipe()
+{
+	m_outQueueMutex.lock();
+	scheduleCommands();
+	m_outQueueMutex.unlock();
 	
-	if(pipeRes1 < 0 || pipeRes2 < 0)
+	while(m_writeQueue.size() > 0)
 	{
-		if(pipeRes1 >= 0)
+		iovec iov[64];
+		int32_t iovCount = 0;
+		
+		for(auto &cmd : m_writeQueue)
 		{
-			close(m_gdbPipeIn[0]);
-			close(m_gdbPipeIn[1]);
+			if(iovCount >= 64)
+				break;
+				
+			size_t skip = (iovCount == 0 ? m_writeOffset : 0);
+			iov[iovCount].iov_base = (void *)(cmd.data() + skip);
+			iov[iovCount].iov_len = cmd.length() - skip;
+			iovCount++;
 		}
 		
-		if(pipeRes2 >= 0)
+		// printf("Raw write: %u commands\n", iovCount);
+		ssize_t writeRes = writev(m_gdbPipeIn[1], iov, iovCount);
+		
+		if(writeRes < 0)
 		{
-			close(m_gdbPipeOut[0]);
-			close(m_gdbPipeOut[1]);
+			if(errno == EINTR)
+				continue;
+				
+			if(errno == EAGAIN)
+				return false; // Pipe is full, wait for EPOLLOUT
+				
+			fprintf(stderr, "[%s:%u] writev() failed (errno = %d)\n", __FILE__, __LINE__, errno);
+			perror("Error");
+			
+			// There's no recovering from a broken pipe, drop what's queued
+			m_writeQueue.clear();
+			m_writeOffset = 0;
+			return true;
 		}
 		
-		logPrintf(LogLevel::Error, "Failed to allocate pipes for GDB child process\n");
-		return false;
+		// Pop whatever was written completely, and remember how
+		// far we got into a command that was only partially written
+		size_t written = writeRes;
+		while(written > 0 && m_writeQueue.size() > 0)
+		{
+			size_t remain = m_writeQueue.front().length() - m_writeOffset;
+			
+			if(written < remain)
+			{
+				m_writeOffset += written;
+				break;
+			}
+			
+			written -= remain;
+			m_writeOffset = 0;
+			m_writeQueue.pop_front();
+		}
 	}
 	
-	pid_t forkRet = fork();
+	return true;
+}
+
+void GDBMI::setWriteWatch(bool enable)
+{
+	if(enable == m_writeWatched)
+		return;
+		
+	epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLOUT;
+	ev.data.fd = m_gdbPipeIn[1];
+	
+	epoll_ctl(m_epollFD, (enable ? EPOLL_CTL_ADD : EPOLL_CTL_DEL), m_gdbPipeIn[1], &ev);
+	m_writeWatched = enable;
+}
+
+bool GDBMI::runGDB(const LaunchOptions &options)
+{
+	// O_CLOEXEC keeps the pipes from leaking into GDB (and any other child
+	// process). The file actions below dup2() the child's ends onto stdio,
+	// which clears the flag on the duplicates.
+	int pipeRes1 = pipe2(m_gdbPipeIn, O_CLOEXEC);
+	int pipeRes2 = pipe2(m_gdbPipeOut, O_CLOEXEC);
 	
-	if(forkRet == -1)
+	auto closePipes = [&]() -> void
 	{
 		if(pipeRes1 >= 0)
 		{
@@ -177,46 +349,146 @@ bool GDBMI::runGDB(std::string gdbPath)
 			close(m_gdbPipeOut[1]);
 		}
 		
-		logPrintf(LogLevel::Error, "The fork() call failed when trying to launch GDB\n");
+		m_gdbPipeIn[0] = m_gdbPipeIn[1] = 0;
+		m_gdbPipeOut[0] = m_gdbPipeOut[1] = 0;
+	};
+	
+	if(pipeRes1 < 0 || pipeRes2 < 0)
+	{
+		closePipes();
+		logPrintf(LogLevel::Error, "Failed to allocate pipes for GDB child process\n");
 		return false;
 	}
 	
-	if(forkRet == 0) // Child process
+	// Build argv: the GDB binary, the MI arguments we depend on, then any extra arguments
+	vector<string> argStrs;
+	argStrs.push_back(options.gdbPath);
+	argStrs.push_back("--interpreter=mi");
+	argStrs.push_back("--nx");
+	argStrs.insert(argStrs.end(), options.extraArgs.begin(), options.extraArgs.end());
+	
+	vector<char *> argv;
+	for(auto &arg : argStrs)
+		argv.push_back((char *) arg.c_str());
+	argv.push_back(0);
+	
+	// Build the environment: our own (unless told not to), with the
+	// "NAME=value" entries from the options added or replacing ours
+	vector<string> envStrs;
+	if(options.inheritEnv)
 	{
-		dup2(m_gdbPipeIn[0], STDIN_FILENO);
-		dup2(m_gdbPipeOut[1], STDOUT_FILENO);
-		dup2(m_gdbPipeOut[1], STDERR_FILENO);
-		
-		close(m_gdbPipeIn[0]);
-		close(m_gdbPipeIn[1]);
-		close(m_gdbPipeOut[0]);
-		close(m_gdbPipeOut[1]);
-		
-		int32_t execRet = execl(gdbPath.c_str(), gdbPath.c_str(), "--interpreter=mi", "--nx", (char *) 0);
+		for(char **env = environ; *env != 0; env++)
+			envStrs.push_back(*env);
+	}
+	
+	for(auto &var : options.env)
+	{
+		size_t nameLen = var.find_first_of('=');
+		auto sameName = [&](const string & e) -> bool
+		{
+			return e.compare(0, nameLen + 1, var, 0, nameLen + 1) == 0;
+		};
 		
-		exit(execRet);
+		auto existing = std::find_if(envStrs.begin(), envStrs.end(), sameName);
+		if(nameLen != string::npos && existing != envStrs.end())
+			*existing = var;
+		else
+			envStrs.push_back(var);
 	}
-	else // Parent process - us :)
+	
+	vector<char *> envp;
+	for(auto &var : envStrs)
+		envp.push_back((char *) var.c_str());
+	envp.push_back(0);
+	
+	posix_spawn_file_actions_t fileActions;
+	posix_spawn_file_actions_init(&fileActions);
+	posix_spawn_file_actions_adddup2(&fileActions, m_gdbPipeIn[0], STDIN_FILENO);
+	posix_spawn_file_actions_adddup2(&fileActions, m_gdbPipeOut[1], STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&fileActions, m_gdbPipeOut[1], STDERR_FILENO);
+	
+	// Don't let GDB inherit a blocked or ignored SIGPIPE from us
+	sigset_t emptyMask;
+	sigset_t defaultSigs;
+	sigemptyset(&emptyMask);
+	sigemptyset(&defaultSigs);
+	sigaddset(&defaultSigs, SIGPIPE);
+	
+	posix_spawnattr_t spawnAttr;
+	posix_spawnattr_init(&spawnAttr);
+	posix_spawnattr_setsigmask(&spawnAttr, &emptyMask);
+	posix_spawnattr_setsigdefault(&spawnAttr, &defaultSigs);
+	
+	int16_t spawnFlags = POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+	#ifdef POSIX_SPAWN_USEVFORK
+	// Recent glibc always spawns with vfork semantics, older versions need to be asked
+	spawnFlags |= POSIX_SPAWN_USEVFORK;
+	#endif
+	posix_spawnattr_setflags(&spawnAttr, spawnFlags);
+	
+	pid_t gdbPID = 0;
+	int32_t spawnRet = 0;
+	
+	// Search $PATH for a bare binary name, like the shell would
+	if(options.gdbPath.find_first_of('/') == string::npos)
+		spawnRet = posix_spawnp(&gdbPID, options.gdbPath.c_str(), &fileActions, &spawnAttr, argv.data(), envp.data());
+	else
+		spawnRet = posix_spawn(&gdbPID, options.gdbPath.c_str(), &fileActions, &spawnAttr, argv.data(), envp.data());
+		
+	posix_spawnattr_destroy(&spawnAttr);
+	posix_spawn_file_actions_destroy(&fileActions);
+	
+	if(spawnRet != 0)
 	{
-		close(m_gdbPipeIn[0]);
-		close(m_gdbPipeOut[1]);
-		m_gdbPID = forkRet;
+		closePipes();
+		logPrintf(LogLevel::Error, "Failed to launch GDB '%s' (%s)\n", options.gdbPath.c_str(), strerror(spawnRet));
+		return false;
+	}
+	
+	// The child's ends of the pipes belong to GDB now
+	close(m_gdbPipeIn[0]);
+	close(m_gdbPipeOut[1]);
+	m_gdbPID = gdbPID;
+	
+	int nbFlags = fcntl(m_gdbPipeOut[0], F_GETFL, 0);
+	nbFlags |= O_NONBLOCK;
+	fcntl(m_gdbPipeOut[0], F_SETFL, nbFlags);
+	
+	// Writes are driven by readThread(), so they mustn't block either
+	nbFlags = fcntl(m_gdbPipeIn[1], F_GETFL, 0);
+	nbFlags |= O_NONBLOCK;
+	fcntl(m_gdbPipeIn[1], F_SETFL, nbFlags);
+	
+	return true;
+}
+
+void GDBMI::stopGDB()
+{
+	if(m_gdbPipeIn[1] > 0)
+		close(m_gdbPipeIn[1]);
 		
-		int flags[2] = {0};
-		flags[0] = fcntl(m_gdbPipeIn[1], F_GETFD);
-		flags[1] = fcntl(m_gdbPipeOut[0], F_GETFD);
+	if(m_gdbPipeOut[0] > 0)
+		close(m_gdbPipeOut[0]);
 		
-		flags[0] |= FD_CLOEXEC;
-		flags[1] |= FD_CLOEXEC;
+	m_gdbPipeIn[1] = 0;
+	m_gdbPipeOut[0] = 0;
+	
+	if(m_gdbPID <= 0)
+		return;
 		
-		fcntl(m_gdbPipeIn[1], F_SETFD, flags[0]);
-		fcntl(m_gdbPipeOut[0], F_SETFD, flags[1]);
+	// GDB exits when it reads EOF on stdin. Give it a moment, then make sure.
+	for(uint32_t i = 0; i < 50; i++)
+	{
+		if(waitpid(m_gdbPID, 0, WNOHANG) != 0)
+		{
+			m_gdbPID = 0;
+			return;
+		}
 		
-		int nbFlags = fcntl(m_gdbPipeOut[0], F_GETFL, 0);
-		nbFlags |= O_NONBLOCK;
-		fcntl(m_gdbPipeOut[0], F_SETFL, nbFlags);
+		usleep(1000 * 10);
 	}
 	
-	
-	return true;
+	kill(m_gdbPID, SIGKILL);
+	waitpid(m_gdbPID, 0, 0);
+	m_gdbPID = 0;
 }
@@ -20,7 +20,7 @@ class GDBMI
 		#endif
 	
 		// Called by the GDBMI constructor
-		void initPipe();
+		void initPipe(const LaunchOptions &options);
 		
 		// Called by the GDBMI destructor
 		void destroyPipe();
@@ -29,17 +29,84 @@ class GDBMI
 		
 		static void readThreadThunk(GDBMI *param) { param->readThread(); }
 		
+		// Waits in epoll_wait() on GDB's output pipe and the wake-up eventfd,
+		// and hands each complete line to handleResponse() as soon as it arrives.
+		// Also times out pending commands (see expireCommands()).
 		void readThread();
 		
-		bool readPipe(string &out);
-		bool writePipe(string cmd);
-		bool runGDB(std::string gdbPath);
+		// Interrupts the epoll_wait() in readThread(). Used to shut the
+		// thread down and to get it to flush the outbound command queue.
+		void wakeReadThread();
+		
+		// Reads what's available on GDB's output pipe into m_framer, up to
+		// GDB_READ_BURST_BYTES, so a long line is handed on in pieces
+		bool readPipe();
+		
+		// Hands the complete lines in m_framer to handleResponse(), and the
+		// unfinished one to streamSymbols()
+		void dispatchFramed();
+		
+		// Adds a command to its priority lane and wakes the read thread to send it.
+		// Never blocks on the pipe.
+		void queueCommand(string cmd, uint32_t token, CmdPriority priority);
+		
+		// Moves commands from the lanes to m_writeQueue, highest priority first,
+		// while fewer than m_commandWindow are unanswered. Only one bulk command
+		// is let out at a time, so a run of them can't fill the window.
+		// Called with m_outQueueMutex held.
+		void scheduleCommands();
+		
+		// Frees the command's slot in the window. Called by handleResponse()
+		// for every result record; unknown tokens are ignored.
+		void commandAnswered(uint32_t token);
+		
+		// Writes as much of the outbound queue as the pipe will take, using
+		// a single writev() per batch. Only called from readThread().
+		// Returns false if data is still waiting for the pipe to become writable.
+		bool writePipe();
+		
+		// Watch (or stop watching) GDB's input pipe for EPOLLOUT
+		void setWriteWatch(bool enable);
+		
+		
+		// Starts GDB with posix_spawn(), wired up to m_gdbPipeIn/m_gdbPipeOut
+		bool runGDB(const LaunchOptions &options);
+		
+		// Closes our ends of the pipes and reaps the GDB process
+		void stopGDB();
 		
 		thread 		m_readThreadHandle;
 		int32_t 	m_gdbPipeIn[2];
 		int32_t 	m_gdbPipeOut[2];
 		pid_t		m_gdbPID;
 		
+		int32_t		m_epollFD;
+		int32_t		m_wakeFD; // eventfd
+		
+		MILineFramer m_framer;
+		
+		struct OutboundCommand
+		{
+			string text;
+			uint32_t token;
+		};
+		
+		// Commands waiting to be written to GDB, one lane per priority.
+		// Callers append to m_outQueues; the read thread moves them to
+		// m_writeQueue, which only it touches, and writes from there.
+		deque<OutboundCommand> m_outQueues[(size_t) CmdPriority::Count];
+		mutex m_outQueueMutex;
+		
+		// Written (or about to be) but not answered yet, oldest first.
+		// Guarded by m_outQueueMutex.
+		deque<pair<uint32_t, CmdPriority>> m_unanswered;
+		uint32_t m_unansweredBulk = 0;
+		uint32_t m_commandWindow = GDB_COMMAND_WINDOW;
+		
+		deque<string> m_writeQueue;
+		size_t m_writeOffset = 0; // Bytes of m_writeQueue.front() already written
+		bool m_writeWatched = false;
+		
 		
 // *INDENT-OFF*
 #ifndef SOMETHING_UNIQUE_GDBMI_H
@@ -11,14 +11,38 @@
 #include <deque>
 #include <map>
 #include <string>
+#include <string_view>
 #include <functional>
+#include <algorithm>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <future>
+#include <coroutine>
+#include <memory>
 
 #include <unistd.h>
 #include <fcntl.h>
 
-#define GDB_HANDLER_THREAD_COUNT	32
+#include "gdbmi_framer.h"
+#include "gdbmi_tokenmap.h"
+#include "gdbmi_snapshot.h"
+#include "gdbmi_symtab.h"
+#include "gdbmi_symindex.h"
+#include "gdbmi_mikey.h"
+#include "gdbmi_mivalue.h"
+#include "gdbmi_mibind.h"
+#include "gdbmi_symstream.h"
+
+#define GDB_HANDLER_THREAD_COUNT	4 // Default size of the record handler pool
+#define GDB_READY_TIMEOUT_MS		5000
+#define GDB_COMMAND_TIMEOUT_MS		30000 // Default for sendCommand(); 0 means no timeout
+#define GDB_COMMAND_WINDOW			2 // Default number of commands written to GDB but not answered yet
+#define GDB_DISAS_CACHE_ENTRIES		32 // Functions kept by the disassembly cache
+#define GDB_SEARCH_MAX_RESULTS		200 // Default for searchSymbols()
+#define GDB_DEFAULT_PATH			"gdb"
 // #define printf(a, ...) logPrintf(LogLevel::NeedsFix, a,## __VA_ARGS__)
 
 
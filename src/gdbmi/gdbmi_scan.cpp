@@ -0,0 +1,273 @@
+#include "gdbmi_scan.h"
+
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define GDBMI_SCAN_X86
+#endif
+
+// One bit per byte of a 64 byte block
+struct BlockMasks
+{
+	uint64_t quote = 0;
+	uint64_t backslash = 0;
+	uint64_t structural = 0;	// { } [ ] , =
+};
+
+// Bit i is the XOR of bits 0 to i
+static uint64_t prefixXor(uint64_t x)
+{
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+	
+	return x;
+}
+
+template<typename State>
+static void finishBlock(const BlockMasks &m, State &state, size_t base, std::vector<uint32_t> &out)
+{
+	// Characters escaped by a backslash. Backslashes are rare in MI output
+	// (strings with quotes or control characters in them), so they're
+	// worked through one at a time.
+	uint64_t escaped = state.escapeCarry;
+	state.escapeCarry = 0;
+	
+	for(uint64_t bs = m.backslash; bs != 0; bs &= bs - 1)
+	{
+		uint32_t bit = __builtin_ctzll(bs);
+		
+		// Itself escaped, as in "\\"
+		if((escaped >> bit) & 1)
+			continue;
+			
+		if(bit == 63)
+			state.escapeCarry = 1;
+		else escaped |= 1ULL << (bit + 1);
+	}
+	
+	uint64_t quotes = m.quote & ~escaped;
+	
+	// Set from an opening quote up to its closing quote (not included)
+	uint64_t inString = prefixXor(quotes) ^ state.inString;
+	state.inString = (uint64_t)((int64_t) inString >> 63);
+	
+	uint64_t structurals = (m.structural & ~inString) | quotes;
+	
+	size_t count = out.size();
+	out.resize(count + __builtin_popcountll(structurals));
+	
+	uint32_t *write = out.data() + count;
+	for(; structurals != 0; structurals &= structurals - 1)
+		*write++ = base + __builtin_ctzll(structurals);
+}
+
+static BlockMasks classifyScalar(const char *p)
+{
+	BlockMasks m;
+	
+	for(uint32_t i = 0; i < 64; i++)
+	{
+		uint64_t bit = 1ULL << i;
+		
+		// *INDENT-OFF*
+		switch(p[i])
+		{
+			case '"':	m.quote |= bit;			break;
+			case '\\':	m.backslash |= bit;		break;
+			case '{':
+			case '}':
+			case '[':
+			case ']':
+			case ',':
+			case '=':	m.structural |= bit;	break;
+		}
+		// *INDENT-ON*
+	}
+	
+	return m;
+}
+
+template<typename State>
+static size_t scanScalar(const char *p, size_t length, size_t base, State &state, std::vector<uint32_t> &out)
+{
+	size_t i = 0;
+	for(; i + 64 <= length; i += 64)
+		finishBlock(classifyScalar(p + i), state, base + i, out);
+		
+	return i;
+}
+
+#ifdef GDBMI_SCAN_X86
+
+// '[' and ']' are '{' and '}' without the 0x20 bit, and no other
+// characters become '{' or '}' when it's set, so OR-ing it in lets two
+// compares find all four brackets.
+
+template<typename State>
+static size_t scanSSE2(const char *p, size_t length, size_t base, State &state, std::vector<uint32_t> &out)
+{
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i open = _mm_set1_epi8('{');
+	const __m128i close = _mm_set1_epi8('}');
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i equals = _mm_set1_epi8('=');
+	const __m128i caseBit = _mm_set1_epi8(0x20);
+	
+	size_t i = 0;
+	for(; i + 64 <= length; i += 64)
+	{
+		BlockMasks m;
+		
+		for(uint32_t part = 0; part < 4; part++)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(p + i + part * 16));
+			__m128i folded = _mm_or_si128(v, caseBit);
+			
+			__m128i structural = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(folded, open), _mm_cmpeq_epi8(folded, close)),
+											  _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, equals)));
+											  
+			uint32_t shift = part * 16;
+			m.quote |= (uint64_t)(uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)) << shift;
+			m.backslash |= (uint64_t)(uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)) << shift;
+			m.structural |= (uint64_t)(uint16_t) _mm_movemask_epi8(structural) << shift;
+		}
+		
+		finishBlock(m, state, base + i, out);
+	}
+	
+	return i;
+}
+
+template<typename State>
+__attribute__((target("avx2")))
+static size_t scanAVX2(const char *p, size_t length, size_t base, State &state, std::vector<uint32_t> &out)
+{
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i open = _mm256_set1_epi8('{');
+	const __m256i close = _mm256_set1_epi8('}');
+	const __m256i comma = _mm256_set1_epi8(',');
+	const __m256i equals = _mm256_set1_epi8('=');
+	const __m256i caseBit = _mm256_set1_epi8(0x20);
+	
+	size_t i = 0;
+	for(; i + 64 <= length; i += 64)
+	{
+		BlockMasks m;
+		
+		for(uint32_t part = 0; part < 2; part++)
+		{
+			__m256i v = _mm256_loadu_si256((const __m256i *)(p + i + part * 32));
+			__m256i folded = _mm256_or_si256(v, caseBit);
+			
+			__m256i structural = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(folded, open), _mm256_cmpeq_epi8(folded, close)),
+												 _mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, equals)));
+												 
+			uint32_t shift = part * 32;
+			m.quote |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)) << shift;
+			m.backslash |= (uint64_t)(uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)) << shift;
+			m.structural |= (uint64_t)(uint32_t) _mm256_movemask_epi8(structural) << shift;
+		}
+		
+		finishBlock(m, state, base + i, out);
+	}
+	
+	return i;
+}
+
+#endif
+
+MIScanner::MIScanner(std::string_view text, Kernel kernel) : m_text(text), m_kernel(kernel)
+{
+	if(kernelSupported(m_kernel) == false)
+		m_kernel = Kernel::Scalar;
+}
+
+bool MIScanner::scanMore(size_t bytes, std::vector<uint32_t> &out)
+{
+	if(m_scanned >= m_text.length())
+		return false;
+		
+	size_t remaining = m_text.length() - m_scanned;
+	size_t length = std::min(remaining, (bytes + 63) & ~(size_t) 63);
+	
+	const char *p = m_text.data() + m_scanned;
+	size_t done = scanKernel(p, length, m_scanned, out);
+	
+	// The end of the text, padded out to a block with spaces
+	if(done < length)
+	{
+		char block[64];
+		memset(block, ' ', sizeof(block));
+		memcpy(block, p + done, length - done);
+		
+		finishBlock(classifyScalar(block), m_state, m_scanned + done, out);
+	}
+	
+	m_scanned += length;
+	return true;
+}
+
+size_t MIScanner::scanBlocks(std::string_view text, std::vector<uint32_t> &out)
+{
+	return scanKernel(text.data(), text.length() & ~(size_t) 63, 0, out);
+}
+
+size_t MIScanner::scanKernel(const char *p, size_t length, size_t base, std::vector<uint32_t> &out)
+{
+	switch(m_kernel)
+	{
+		#ifdef GDBMI_SCAN_X86
+		case Kernel::AVX2: return scanAVX2(p, length, base, m_state, out);
+		case Kernel::SSE2: return scanSSE2(p, length, base, m_state, out);
+		#endif
+		default: return scanScalar(p, length, base, m_state, out);
+	}
+}
+
+void MIScanner::findStructurals(std::string_view text, std::vector<uint32_t> &out, Kernel kernel)
+{
+	MIScanner scanner(text, kernel);
+	while(scanner.scanMore(text.length(), out));
+}
+
+MIScanner::Kernel MIScanner::bestKernel()
+{
+	#ifdef GDBMI_SCAN_X86
+	static const Kernel best = __builtin_cpu_supports("avx2") ? Kernel::AVX2 : Kernel::SSE2;
+	return best;
+	#else
+	return Kernel::Scalar;
+	#endif
+}
+
+bool MIScanner::kernelSupported(Kernel kernel)
+{
+	#ifdef GDBMI_SCAN_X86
+	if(kernel == Kernel::AVX2)
+		return bestKernel() == Kernel::AVX2;
+		
+	return true;
+	#else
+	return kernel == Kernel::Scalar;
+	#endif
+}
+
+const char *MIScanner::kernelName(Kernel kernel)
+{
+	switch(kernel)
+	{
+		case Kernel::Scalar: return "scalar";
+		case Kernel::SSE2: return "SSE2";
+		case Kernel::AVX2: return "AVX2";
+	}
+	
+	return "";
+}
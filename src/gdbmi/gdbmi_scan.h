@@ -0,0 +1,85 @@
+#ifndef UNIQUE_GDBMI_SCAN_H
+#define UNIQUE_GDBMI_SCAN_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string_view>
+
+/*
+	Finds the structural characters in MI text: the quotes around strings,
+	and the { } [ ] , = outside of them. MIParser jumps from one to the
+	next instead of looking at every character, which matters for the big
+	records (-data-disassemble, -symbol-info-functions, -break-list) that
+	are mostly the insides of strings.
+	
+	The text is looked at 64 bytes at a time, the way simdjson does it.
+	A block is first turned into three bitmaps (quotes, backslashes and
+	the other structural characters) with vector compares. Plain integer
+	work on the bitmaps then drops escaped quotes, works out which bytes
+	are inside strings (a prefix XOR over the quote bits), and masks
+	their brackets and commas out. Whether a string or an escape carries
+	over into the next block is kept between blocks.
+	
+	The kernel that builds the bitmaps is picked at runtime: AVX2 where
+	the CPU has it, otherwise SSE2 (which every x86-64 has), and plain C++
+	on anything else. All of them give the same answer.
+	
+	Offsets are 32 bit, so a text can be up to 4 GB.
+*/
+
+class MIScanner
+{
+	public:
+	
+		enum class Kernel : uint8_t
+		{
+			Scalar,
+			SSE2,
+			AVX2
+		};
+		
+		// Scans 'text', which has to stay valid while the scanner is used
+		MIScanner(std::string_view text, Kernel kernel = bestKernel());
+		
+		// For text that arrives in pieces, see scanBlocks()
+		MIScanner(Kernel kernel = bestKernel()) : MIScanner(std::string_view(), kernel) {}
+		
+		// Appends the offsets of the structural characters in the next
+		// 'bytes' or so of the text (rounded up to whole blocks) to 'out',
+		// in order. Returns false once the whole text has been scanned.
+		bool scanMore(size_t bytes, std::vector<uint32_t> &out);
+		
+		// Scans the whole 64 byte blocks at the start of 'text', carrying on
+		// from the end of the last call, and appends their offsets (from the
+		// start of 'text') to 'out'. Returns how many bytes were scanned; the
+		// rest have to come first in the next call.
+		size_t scanBlocks(std::string_view text, std::vector<uint32_t> &out);
+		
+		// The whole text at once
+		static void findStructurals(std::string_view text, std::vector<uint32_t> &out, Kernel kernel = bestKernel());
+		
+		// The fastest kernel this CPU can run (checked once)
+		static Kernel bestKernel();
+		
+		static bool kernelSupported(Kernel kernel);
+		static const char *kernelName(Kernel kernel);
+		
+	private:
+	
+		// Carried from one block to the next
+		struct State
+		{
+			uint64_t escapeCarry = 0;	// 1 if the next block starts with an escaped character
+			uint64_t inString = 0;		// All ones if the last block ended inside a string
+		};
+		
+		size_t scanKernel(const char *p, size_t length, size_t base, std::vector<uint32_t> &out);
+		
+		std::string_view m_text;
+		Kernel m_kernel;
+		State m_state;
+		size_t m_scanned = 0;
+};
+
+#endif
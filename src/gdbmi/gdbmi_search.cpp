@@ -0,0 +1,66 @@
+#include "gdbmi_private.h"
+#include "gdbmi.h"
+
+using Clock = std::chrono::steady_clock;
+using Micros = std::chrono::duration<double, std::micro>;
+
+uint64_t GDBMI::searchSymbols(string query, uint32_t maxResults)
+{
+	uint64_t queryID = ++m_latestSearchID;
+	
+	postTask(OrderDomain::Search, [this, queryID, query, maxResults]()
+	{
+		// The user has typed more since; only the newest query is worth answering
+		if(queryID != m_latestSearchID)
+			return;
+			
+		runSearch(queryID, query, maxResults);
+	});
+	
+	return queryID;
+}
+
+void GDBMI::rebuildSearchIndex(SymbolKind kind, SymbolSnapshot symbols)
+{
+	SearchIndex index;
+	index.symbols = symbols;
+	index.index.build(symbols->data);
+	
+	if(kind == SymbolKind::Function)
+		m_functionIndex.publish(std::move(index));
+	else
+		m_globalIndex.publish(std::move(index));
+}
+
+void GDBMI::runSearch(uint64_t queryID, const string &query, uint32_t maxResults)
+{
+	auto start = Clock::now();
+	
+	SnapshotCell<SearchIndex>::Ptr functions = m_functionIndex.get();
+	SnapshotCell<SearchIndex>::Ptr globals = m_globalIndex.get();
+	
+	SearchResults results;
+	results.queryID = queryID;
+	results.query = query;
+	results.functions = functions->data.symbols;
+	results.globals = globals->data.symbols;
+	
+	for(auto &match : functions->data.index.search(query, maxResults))
+		results.hits.push_back({ SymbolKind::Function, match.symbol, match.score });
+		
+	for(auto &match : globals->data.index.search(query, maxResults))
+		results.hits.push_back({ SymbolKind::GlobalVar, match.symbol, match.score });
+		
+	std::stable_sort(results.hits.begin(), results.hits.end(), [](const SearchHit & a, const SearchHit & b)
+	{
+		return a.score > b.score;
+	});
+	
+	if(results.hits.size() > maxResults)
+		results.hits.resize(maxResults);
+		
+	results.elapsedMs = Micros(Clock::now() - start).count() / 1000.0;
+	
+	m_searchResults.publish(std::move(results));
+	publishEvent(EventType::SearchResultsReady);
+}
@@ -0,0 +1,88 @@
+#ifndef UNIQUE_GDBMI_SEARCH_H
+#define UNIQUE_GDBMI_SEARCH_H
+
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_private.h"
+
+class GDBMI
+{
+
+#define SOMETHING_UNIQUE_GDBMI_H
+#include "gdbmi_data.h"
+#undef SOMETHING_UNIQUE_GDBMI_H
+
+#endif
+
+	public:
+	
+		enum class SymbolKind : uint8_t
+		{
+			Function,
+			GlobalVar
+		};
+		
+		struct SearchHit
+		{
+			SymbolKind kind;
+			uint32_t index;	// Into 'functions' or 'globals' in the results
+			int32_t score;
+		};
+		
+		struct SearchResults
+		{
+			uint64_t queryID = 0;
+			string query;
+			vector<SearchHit> hits;	// Best first
+			
+			// The symbol tables the hits point into
+			SymbolSnapshot functions;
+			SymbolSnapshot globals;
+			
+			double elapsedMs = 0;
+		};
+		
+		typedef SnapshotCell<SearchResults>::Ptr SearchSnapshot;
+		
+		// Searches function and global variable names on the worker pool, and
+		// publishes the results to getSearchResults() with a SearchResultsReady
+		// event. Meant to be called on every keystroke: a query that hasn't
+		// started by the time a newer one comes in is skipped.
+		// Returns the query's ID (see SearchResults::queryID).
+		uint64_t searchSymbols(string query, uint32_t maxResults = GDB_SEARCH_MAX_RESULTS);
+		
+		SearchSnapshot getSearchResults() { return m_searchResults.get(); }
+		
+		#ifdef BUILD_GDBMI_TESTS
+	public:
+		#else
+	private:
+		#endif
+		
+		// A symbol table with its index. The index points into the table,
+		// so the two are published together.
+		struct SearchIndex
+		{
+			SymbolSnapshot symbols;
+			SymbolIndex index;
+		};
+		
+		// Called after a new symbol table is published; runs on the worker pool
+		void rebuildSearchIndex(SymbolKind kind, SymbolSnapshot symbols);
+		
+		void runSearch(uint64_t queryID, const string &query, uint32_t maxResults);
+		
+		SnapshotCell<SearchIndex> m_functionIndex;
+		SnapshotCell<SearchIndex> m_globalIndex;
+		
+		std::atomic<uint64_t> m_latestSearchID = 0;
+		SnapshotCell<SearchResults> m_searchResults;
+		
+		
+		
+// *INDENT-OFF*
+#ifndef SOMETHING_UNIQUE_GDBMI_H
+};
+#endif
+// *INDENT-ON*
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef UNIQUE_GDBMI_SNAPSHOT_H
+#define UNIQUE_GDBMI_SNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <utility>
+
+/*
+	Holds the current version of a piece of data as an immutable snapshot.
+	
+	Readers call get() and keep the returned pointer for as long as they
+	like; it's never modified, and it stays alive until the last reader
+	drops it. Writers never touch a published snapshot. They build a new
+	one and swap it in with a compare-and-swap, so readers never wait on a
+	writer and nothing is copied on the read side.
+	
+	Every snapshot carries a version number, bumped on each publish, so
+	readers can tell cheaply whether what they hold is still current.
+*/
+
+template<typename T>
+class SnapshotCell
+{
+	public:
+	
+		struct Snapshot
+		{
+			uint64_t version = 0;
+			T data;
+		};
+		
+		typedef std::shared_ptr<const Snapshot> Ptr;
+		
+		SnapshotCell() : m_current(std::make_shared<const Snapshot>()) {}
+		
+		// The current snapshot (version 0 holds a default-constructed T)
+		Ptr get() const { return m_current.load(std::memory_order_acquire); }
+		
+		uint64_t version() const { return get()->version; }
+		
+		// Replaces the data. Returns the new version.
+		uint64_t publish(T data)
+		{
+			auto next = std::make_shared<Snapshot>();
+			next->data = std::move(data);
+			
+			Ptr cur = get();
+			do
+				next->version = cur->version + 1;
+			while(!m_current.compare_exchange_weak(cur, next, std::memory_order_acq_rel, std::memory_order_acquire));
+			
+			return next->version;
+		}
+		
+		// Publishes a modified copy of the current data. 'fn' is called with
+		// the copy, and again with a fresh one if another writer got in first.
+		template<typename Fn>
+		uint64_t update(Fn &&fn)
+		{
+			Ptr cur = get();
+			while(true)
+			{
+				auto next = std::make_shared<Snapshot>(*cur);
+				next->version = cur->version + 1;
+				fn(next->data);
+				
+				if(m_current.compare_exchange_strong(cur, next, std::memory_order_acq_rel, std::memory_order_acquire))
+					return next->version;
+			}
+		}
+		
+	private:
+	
+		std::atomic<Ptr> m_current;
+};
+
+#endif
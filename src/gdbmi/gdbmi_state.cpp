@@ -1,6 +1,8 @@
 #include "gdbmi_private.h"
 #include "gdbmi.h"
 
+#include <chrono>
+
 void GDBMI::initState()
 {
 	m_gdbState = GDBState::Stopped;
@@ -18,11 +20,10 @@ void GDBMI::setState(GDBState state, const string msg)
 	{
 		logPrintf(LogLevel::Info, "Inferior exited (%s)", msg.c_str());
 		
-		m_disasLinesMutex.lock();
-		m_disasLines.clear();
-		m_disasLinesMutex.unlock();
+		m_disasLines.publish({});
+		invalidateDisasCache();
 		
-		m_notifyCallback(UpdateType::Disassembly, m_notifyUserData);
+		publishEvent(EventType::DisassemblyChanged);
 	}
 	
 	m_stateMutex.lock();
@@ -50,3 +51,63 @@ string GDBMI::getStatusMsg()
 	
 	return ret;
 }
+
+bool GDBMI::waitReady(uint32_t timeoutMs)
+{
+	std::unique_lock<mutex> lock(m_readyMutex);
+	m_readyCond.wait_for(lock, std::chrono::milliseconds(timeoutMs),
+						 [this] { return m_gdbReady || m_gdbExited; });
+						 
+	return m_gdbReady;
+}
+
+bool GDBMI::isReady()
+{
+	bool ret;
+	m_readyMutex.lock();
+	ret = m_gdbReady;
+	m_readyMutex.unlock();
+	
+	return ret;
+}
+
+bool GDBMI::hasExited()
+{
+	bool ret;
+	m_readyMutex.lock();
+	ret = m_gdbExited;
+	m_readyMutex.unlock();
+	
+	return ret;
+}
+
+void GDBMI::setReadyCallback(function<void(GDBMI *)> callback)
+{
+	m_readyMutex.lock();
+	m_readyCallback = callback;
+	bool callNow = m_gdbReady;
+	m_readyMutex.unlock();
+	
+	if(callNow && callback != 0)
+		callback(this);
+}
+
+void GDBMI::setReady(bool gdbExited)
+{
+	function<void(GDBMI *)> callback = 0;
+	
+	m_readyMutex.lock();
+	if(gdbExited)
+		m_gdbExited = true;
+	else if(m_gdbReady == false)
+	{
+		m_gdbReady = true;
+		callback = m_readyCallback;
+	}
+	m_readyMutex.unlock();
+	
+	m_readyCond.notify_all();
+	
+	if(callback != 0)
+		callback(this);
+}
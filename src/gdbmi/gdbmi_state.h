@@ -27,11 +27,47 @@ class GDBMI
 		GDBState getState();
 		string getStatusMsg();
 		
+		// GDB is ready once it has printed its first "(gdb)" prompt.
+		// waitReady() blocks until then, or until timeoutMs has passed.
+		// Returns false on timeout, or if GDB exited before becoming ready.
+		bool waitReady(uint32_t timeoutMs = GDB_READY_TIMEOUT_MS);
+		bool isReady();
+		
+		// True once GDB has closed its output pipe, or if it couldn't be launched
+		bool hasExited();
+		
+		// The callback is called once GDB is ready (right away if it already is)
+		void setReadyCallback(function<void(GDBMI *)> callback);
+		
+		// Bumped every time the inferior starts or stops. Data fetched for
+		// an older generation no longer matches what the inferior looks like.
+		uint32_t getStopGeneration() { return m_stopGeneration; }
+		
 	private:
+	
+		// Called from the read thread when the first prompt arrives
+		// (gdbExited = false) or when GDB's output pipe is closed
+		void setReady(bool gdbExited);
+		
+		// Called from runningCallback() and stoppedCallback()
+		void bumpStopGeneration() { m_stopGeneration++; }
+		
+		// Starts at 1; 0 means "not tied to a stop"
+		std::atomic<uint32_t> m_stopGeneration = {1};
+		
+
 		GDBState m_gdbState;
 		string m_stopMsg;
 		mutex m_stateMutex;
 		
+		// These are set from the read thread, which starts before
+		// initState() is called, so they're initialized here
+		bool m_gdbReady = false;
+		bool m_gdbExited = false;
+		mutex m_readyMutex;
+		std::condition_variable m_readyCond;
+		function<void(GDBMI *)> m_readyCallback = 0;
+		
 		
 		
 // *INDENT-OFF*
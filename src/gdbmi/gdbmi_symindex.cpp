@@ -0,0 +1,418 @@
+#include "gdbmi_symindex.h"
+
+#include <algorithm>
+
+// Six bits per character; letters are folded to lowercase
+static uint32_t foldChar(unsigned char c)
+{
+	if(c >= 'a' && c <= 'z')
+		return 1 + (c - 'a');
+		
+	if(c >= 'A' && c <= 'Z')
+		return 1 + (c - 'A');
+		
+	if(c >= '0' && c <= '9')
+		return 27 + (c - '0');
+		
+	switch(c)
+	{
+		case '_': return 37;
+		case ':': return 38;
+		case '<': return 39;
+		case '>': return 40;
+		case ' ': return 41;
+		case '~': return 42;
+		default: return 43 + (c % 21);
+	}
+}
+
+static bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+static bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+static bool isAlnum(char c) { return isLower(c) || isUpper(c) || (c >= '0' && c <= '9'); }
+
+static char lowerChar(char c)
+{
+	return (c >= 'A' && c <= 'Z') ? (c - 'A' + 'a') : c;
+}
+
+// Case-insensitive find
+static size_t findNoCase(std::string_view haystack, std::string_view needle)
+{
+	if(needle.length() > haystack.length())
+		return std::string_view::npos;
+		
+	char first = lowerChar(needle[0]);
+	for(size_t i = 0; i + needle.length() <= haystack.length(); i++)
+	{
+		if(lowerChar(haystack[i]) != first)
+			continue;
+			
+		size_t j = 1;
+		while(j < needle.length() && lowerChar(haystack[i + j]) == lowerChar(needle[j]))
+			j++;
+			
+		if(j == needle.length())
+			return i;
+	}
+	
+	return std::string_view::npos;
+}
+
+// Score of a name containing the query, or -1 if it doesn't
+static int32_t matchScore(std::string_view name, std::string_view query)
+{
+	size_t pos = findNoCase(name, query);
+	if(pos == std::string_view::npos)
+		return -1;
+		
+	int32_t score = 2000;
+	
+	if(name.length() == query.length())
+		score += 3000;
+	else if(pos == 0)
+		score += 2000;
+	else if(isAlnum(name[pos - 1]) == false || (isLower(name[pos - 1]) && isUpper(name[pos])))
+		score += 1000;
+		
+	score -= std::min<size_t>(pos, 200);
+	score -= std::min<size_t>(name.length(), 400) / 2;
+	
+	return score;
+}
+
+// Score of a name that only shares some of the query's trigrams. Always
+// below any matchScore(), and higher if the query's characters at least
+// appear in order.
+static int32_t fuzzyScore(std::string_view name, std::string_view query, uint32_t sharedTrigrams, uint32_t queryTrigrams)
+{
+	int32_t score = (200 * sharedTrigrams) / queryTrigrams;
+	
+	size_t q = 0;
+	uint32_t gaps = 0;
+	for(size_t i = 0; i < name.length() && q < query.length(); i++)
+	{
+		if(lowerChar(name[i]) == lowerChar(query[q]))
+			q++;
+		else if(q > 0)
+			gaps++;
+	}
+	
+	if(q == query.length())
+		score += 1000 - std::min<uint32_t>(gaps, 500);
+		
+	score -= std::min<size_t>(name.length(), 400) / 2;
+	
+	return std::max(score, 1);
+}
+
+uint32_t SymbolIndex::trigram(const char *p)
+{
+	return (foldChar(p[0]) << 12) | (foldChar(p[1]) << 6) | foldChar(p[2]);
+}
+
+void SymbolIndex::nameTrigrams(std::string_view name, std::vector<uint32_t> &out)
+{
+	out.clear();
+	for(size_t i = 0; i + 3 <= name.length(); i++)
+		out.push_back(trigram(name.data() + i));
+		
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+void SymbolIndex::nameWordStarts(std::string_view name, std::vector<uint32_t> &out)
+{
+	out.clear();
+	for(size_t i = 0; i < name.length(); i++)
+	{
+		bool start = (i == 0);
+		if(start == false && isAlnum(name[i]))
+			start = (isAlnum(name[i - 1]) == false) || (isLower(name[i - 1]) && isUpper(name[i]));
+			
+		if(start == false)
+			continue;
+			
+		// A one character word has nothing after it; fold values start at 1
+		uint32_t second = (i + 1 < name.length()) ? foldChar(name[i + 1]) : 0;
+		out.push_back((foldChar(name[i]) << 6) | second);
+	}
+	
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+// Lays out one posting list per key back to back, as CSR: the symbols with
+// key k end up in postings[offsets[k]] up to postings[offsets[k + 1]], in
+// the order they're visited.
+template<typename KeysOf>
+static void buildPostings(const std::vector<uint32_t> &order, uint32_t keyCount, KeysOf keysOf,
+						  std::vector<uint32_t> &offsets, std::vector<uint32_t> &postings)
+{
+	// Two passes over the names: count each key's symbols, then fill the lists in
+	std::vector<uint32_t> counts(keyCount + 1, 0);
+	std::vector<uint32_t> keys;
+	
+	for(uint32_t i : order)
+	{
+		keysOf(i, keys);
+		for(uint32_t key : keys)
+			counts[key]++;
+	}
+	
+	offsets.assign(keyCount + 1, 0);
+	for(uint32_t k = 0; k < keyCount; k++)
+		offsets[k + 1] = offsets[k] + counts[k];
+		
+	postings.assign(offsets.back(), 0);
+	
+	// counts[k] becomes the next free slot in k's list
+	std::copy(offsets.begin(), offsets.end(), counts.begin());
+	
+	for(uint32_t i : order)
+	{
+		keysOf(i, keys);
+		for(uint32_t key : keys)
+			postings[counts[key]++] = i;
+	}
+}
+
+void SymbolIndex::build(const SymbolTable &table)
+{
+	m_table = &table;
+	
+	std::vector<uint32_t> order(table.size());
+	for(size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+		
+	buildPostings(order, 1 << TrigramBits, [&](uint32_t i, std::vector<uint32_t> &keys)
+	{
+		nameTrigrams(table.name(i), keys);
+	}, m_offsets, m_postings);
+	
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return table.name(a).length() < table.name(b).length();
+	});
+	
+	buildPostings(order, 1 << 12, [&](uint32_t i, std::vector<uint32_t> &keys)
+	{
+		nameWordStarts(table.name(i), keys);
+	}, m_wordOffsets, m_wordPostings);
+}
+
+SymbolIndex::Range SymbolIndex::postings(uint32_t tri) const
+{
+	const uint32_t *base = m_postings.data();
+	return { base + m_offsets[tri], base + m_offsets[tri + 1] };
+}
+
+// First element in a sorted [first, last) not less than value. Candidates
+// come in ascending order, so the one looked for is usually close by:
+// doubling the step until it's passed touches far less memory than
+// bisecting the rest of the list.
+static const uint32_t *gallop(const uint32_t *first, const uint32_t *last, uint32_t value)
+{
+	size_t step = 1;
+	while(first + step < last && first[step] < value)
+	{
+		first += step;
+		step *= 2;
+	}
+	
+	return std::lower_bound(first, std::min(first + step + 1, last), value);
+}
+
+std::vector<SymbolIndex::Match> SymbolIndex::search(std::string_view query, size_t maxResults) const
+{
+	std::vector<Match> matches;
+	
+	if(m_table == 0 || query.length() == 0 || maxResults == 0)
+		return matches;
+		
+	if(query.length() < 3)
+		searchWordStarts(query, maxResults, matches);
+	else searchTrigrams(query, maxResults, matches);
+	
+	auto better = [](const Match & a, const Match & b)
+	{
+		return (a.score != b.score) ? (a.score > b.score) : (a.symbol < b.symbol);
+	};
+	
+	if(matches.size() > maxResults)
+	{
+		std::partial_sort(matches.begin(), matches.begin() + maxResults, matches.end(), better);
+		matches.resize(maxResults);
+	}
+	else std::sort(matches.begin(), matches.end(), better);
+	
+	return matches;
+}
+
+void SymbolIndex::searchWordStarts(std::string_view query, size_t maxResults, std::vector<Match> &matches) const
+{
+	const SymbolTable &table = *m_table;
+	
+	// One character: every list for a word starting with it
+	uint32_t firstKey = foldChar(query[0]) << 6;
+	uint32_t lastKey = firstKey + 63;
+	
+	if(query.length() == 2)
+		firstKey = lastKey = firstKey | foldChar(query[1]);
+		
+	// The lists are shortest name first, which is mostly best first; a few
+	// times more than needed are scored so the position in the name gets
+	// a say too.
+	size_t budget = maxResults * 4;
+	
+	for(uint32_t key = firstKey; key <= lastKey; key++)
+	{
+		const uint32_t *base = m_wordPostings.data();
+		const uint32_t *end = base + m_wordOffsets[key + 1];
+		
+		size_t found = 0;
+		for(const uint32_t *id = base + m_wordOffsets[key]; id != end && found < budget; id++)
+		{
+			int32_t score = matchScore(table.name(*id), query);
+			if(score > 0)
+			{
+				matches.push_back({ *id, score });
+				found++;
+			}
+		}
+	}
+	
+	// A name with several words starting with the character is in several lists
+	if(firstKey != lastKey)
+	{
+		std::sort(matches.begin(), matches.end(), [](const Match & a, const Match & b)
+		{
+			return a.symbol < b.symbol;
+		});
+		
+		matches.erase(std::unique(matches.begin(), matches.end(), [](const Match & a, const Match & b)
+		{
+			return a.symbol == b.symbol;
+		}), matches.end());
+	}
+}
+
+void SymbolIndex::searchTrigrams(std::string_view query, size_t maxResults, std::vector<Match> &matches) const
+{
+	const SymbolTable &table = *m_table;
+	
+	std::vector<uint32_t> tris;
+	nameTrigrams(query, tris);
+	
+	std::vector<Range> lists;
+	for(uint32_t tri : tris)
+		lists.push_back(postings(tri));
+		
+	std::sort(lists.begin(), lists.end(), [](const Range & a, const Range & b)
+	{
+		return (a.second - a.first) < (b.second - b.first);
+	});
+	
+	// Candidates for a real match have every trigram. Walk the shortest
+	// list and look each symbol up in the others, which only move forward.
+	// The name is checked anyway, so lists much longer than the shortest
+	// aren't worth walking: nearly every candidate would be in them.
+	std::vector<Range> cursors = lists;
+	
+	size_t filters = 1;
+	while(filters < lists.size() && (size_t)(lists[filters].second - lists[filters].first) <= (size_t)(lists[0].second - lists[0].first) * 8)
+		filters++;
+		
+	std::vector<uint32_t> candidates;
+	
+	for(const uint32_t *id = lists[0].first; id != lists[0].second; id++)
+	{
+		bool inAll = true;
+		for(size_t l = 1; l < filters && inAll; l++)
+		{
+			cursors[l].first = gallop(cursors[l].first, cursors[l].second, *id);
+			inAll = (cursors[l].first != cursors[l].second && *cursors[l].first == *id);
+		}
+		
+		if(inAll)
+			candidates.push_back(*id);
+	}
+	
+	// Each name is a cache miss or two away, and a popular query can have
+	// tens of thousands of candidates. Finding a block of names and
+	// prefetching their text before checking any lets those misses overlap
+	// instead of queueing one after another.
+	const size_t block = 16;
+	std::string_view names[block];
+	
+	for(size_t first = 0; first < candidates.size(); first += block)
+	{
+		size_t count = std::min(block, candidates.size() - first);
+		for(size_t c = 0; c < count; c++)
+			names[c] = table.name(candidates[first + c]);
+			
+		for(size_t c = 0; c < count; c++)
+			__builtin_prefetch(names[c].data());
+			
+		for(size_t c = 0; c < count; c++)
+		{
+			int32_t score = matchScore(names[c], query);
+			if(score > 0)
+				matches.push_back({ candidates[first + c], score });
+		}
+	}
+	
+	if(matches.size() >= maxResults)
+		return;
+		
+	// Not enough; add names sharing two thirds of the trigrams. Trigrams in
+	// more than a quarter of all names say little about a match, and
+	// would cost the most to count, so they're left out.
+	size_t commonLength = std::max<size_t>(table.size() / 4, 64);
+	
+	size_t informative = 0;
+	while(informative < lists.size() && (size_t)(lists[informative].second - lists[informative].first) <= commonLength)
+		informative++;
+		
+	uint32_t needed = std::max<uint32_t>(1, (tris.size() * 2 + 2) / 3);
+	
+	if(informative < needed)
+		return;
+		
+	std::vector<uint8_t> shared(table.size(), 0);
+	
+	for(size_t l = 0; l < informative; l++)
+	{
+		for(const uint32_t *id = lists[l].first; id != lists[l].second; id++)
+		{
+			if(shared[*id] < 255)
+				shared[*id]++;
+		}
+	}
+	
+	for(auto &m : matches)
+		shared[m.symbol] = 0;
+		
+	for(size_t i = 0; i < shared.size(); i++)
+	{
+		if(shared[i] >= needed)
+			matches.push_back({ (uint32_t) i, fuzzyScore(table.name(i), query, shared[i], tris.size()) });
+	}
+}
+
+size_t SymbolIndex::trigramCount() const
+{
+	size_t count = 0;
+	for(size_t t = 0; t + 1 < m_offsets.size(); t++)
+	{
+		if(m_offsets[t + 1] != m_offsets[t])
+			count++;
+	}
+	
+	return count;
+}
+
+size_t SymbolIndex::memoryUsage() const
+{
+	size_t words = m_offsets.capacity() + m_postings.capacity() + m_wordOffsets.capacity() + m_wordPostings.capacity();
+	return sizeof(*this) + words * sizeof(uint32_t);
+}
@@ -0,0 +1,94 @@
+#ifndef UNIQUE_GDBMI_SYMINDEX_H
+#define UNIQUE_GDBMI_SYMINDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string_view>
+#include <utility>
+
+#include "gdbmi_symtab.h"
+
+/*
+	Trigram index over the symbol names in a SymbolTable, for searching as
+	the user types.
+	
+	Every name is split into overlapping three character pieces, and each
+	trigram keeps the sorted list of symbols containing it. Characters are
+	folded to six bits first (case is ignored, and rare punctuation
+	shares values), so a trigram is an 18 bit number and the lists can be
+	found by indexing instead of hashing. A fold collision only lets in
+	extra candidates, which the check against the name itself drops.
+	
+	A query's trigrams narrow a million names down to the few that contain
+	all of them before any name is looked at. Queries shorter than a
+	trigram only match where a name or a word in it starts ("ns::Name",
+	"my_name", "myName"); those are indexed by their first two
+	characters, shortest names first, so only the best few are checked.
+	
+	Matches are ranked: whole name, then prefix, then the start of a
+	scope or word ("ns::name", "my_name", "myName"), then anywhere in the name,
+	shorter names first. If that doesn't fill the results, names sharing
+	most of the query's trigrams are added as fuzzy matches, so typos and
+	missing characters still find something.
+	
+	The index keeps a pointer to the table it was built from; the table
+	has to outlive it (and can't change, which a published one doesn't).
+*/
+
+class SymbolIndex
+{
+	public:
+	
+		struct Match
+		{
+			uint32_t symbol;	// Index into the SymbolTable
+			int32_t score;		// Higher is better
+		};
+		
+		void build(const SymbolTable &table);
+		
+		// Best matches first, at most maxResults of them
+		std::vector<Match> search(std::string_view query, size_t maxResults) const;
+		
+		// Distinct trigrams in the index
+		size_t trigramCount() const;
+		
+		// Bytes held by the index (not counting the table)
+		size_t memoryUsage() const;
+		
+	private:
+	
+		static const uint32_t TrigramBits = 18;
+		
+		// Folded characters packed into the low TrigramBits bits
+		static uint32_t trigram(const char *p);
+		
+		// Sorted, without duplicates
+		static void nameTrigrams(std::string_view name, std::vector<uint32_t> &out);
+		
+		// First two (folded) characters of each word in the name, without duplicates
+		static void nameWordStarts(std::string_view name, std::vector<uint32_t> &out);
+		
+		typedef std::pair<const uint32_t *, const uint32_t *> Range;
+		
+		// Posting list of a trigram: [begin, end) in m_postings, empty if no name has it
+		Range postings(uint32_t tri) const;
+		
+		void searchTrigrams(std::string_view query, size_t maxResults, std::vector<Match> &matches) const;
+		void searchWordStarts(std::string_view query, size_t maxResults, std::vector<Match> &matches) const;
+		
+		const SymbolTable *m_table = 0;
+		
+		// The symbols with trigram t are m_postings[m_offsets[t]] up to
+		// m_postings[m_offsets[t + 1]], in ascending order
+		std::vector<uint32_t> m_offsets;
+		std::vector<uint32_t> m_postings;
+		
+		// Same layout, keyed by the two characters a word starts with (12 bits),
+		// with shorter names first
+		std::vector<uint32_t> m_wordOffsets;
+		std::vector<uint32_t> m_wordPostings;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "gdbmi_symstream.h"
+#include "gdbmi_mibind.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+// {line="10",name="main",type="int (int, char **)",description="int main(int, char **);"}
+// The strings are only looked at until SymbolTable::addSymbol() copies them.
+struct SymbolFields
+{
+	uint32_t line = 0;
+	std::string_view name;
+	std::string_view type;
+	std::string_view description;
+};
+
+static constexpr auto symbolSchema = miSchema<SymbolFields>(
+			MIField(MIKey::Line, &SymbolFields::line),
+			MIField(MIKey::Name, &SymbolFields::name),
+			MIField(MIKey::Type, &SymbolFields::type),
+			MIField(MIKey::Description, &SymbolFields::description));
+			
+bool MISymbolStream::feed(std::string_view text)
+{
+	if(m_failed || m_done)
+		return m_failed == false;
+		
+	m_bytesFed += text.length();
+	m_buffer.append(text);
+	
+	m_structurals.clear();
+	size_t scanned = m_scanner.scanBlocks(std::string_view(m_buffer).substr(m_scanned), m_structurals);
+	
+	walk(m_scanned);
+	m_scanned += scanned;
+	
+	compact();
+	return m_failed == false;
+}
+
+bool MISymbolStream::finish()
+{
+	if(m_failed == false && m_done == false && m_scanned < m_buffer.length())
+	{
+		// The last few bytes, padded out to a block
+		m_buffer.append(64 - (m_buffer.length() - m_scanned), ' ');
+		
+		m_structurals.clear();
+		m_scanner.scanBlocks(std::string_view(m_buffer).substr(m_scanned), m_structurals);
+		
+		walk(m_scanned);
+	}
+	
+	std::string().swap(m_buffer);
+	m_symbols.finish();
+	
+	return m_failed == false && m_done;
+}
+
+void MISymbolStream::addFile(const MIValue &file, SymbolTable &symbols)
+{
+	const MIValue *symList = file.find(MIKey::Symbols);
+	if(symList == 0)
+		return;
+		
+	uint32_t fileID = symbols.addFile(file.get(MIKey::Fullname), file.get(MIKey::Filename));
+	
+	for(const MIValue &sym : *symList)
+	{
+		SymbolFields fields;
+		symbolSchema.bind(sym, fields);
+		
+		symbols.addSymbol(fileID, fields.line, fields.name, fields.type, fields.description);
+	}
+}
+
+void MISymbolStream::walk(size_t base)
+{
+	for(uint32_t offset : m_structurals)
+	{
+		size_t pos = base + offset;
+		char c = m_buffer[pos];
+		
+		// Strings don't matter here, only where the brackets are
+		if(c == '"')
+			continue;
+			
+		if(c == '=')
+		{
+			if(m_depth <= 1)
+				m_key.assign(m_buffer, m_keyStart, pos - m_keyStart);
+		}
+		else if(c == '{' || c == '[')
+		{
+			if(m_depth == 0 && (c != '{' || m_key != "symbols"))
+			{
+				m_failed = true;
+				return;
+			}
+			
+			if(m_depth == 1)
+				m_inDebug = (c == '[' && m_key == "debug");
+			else if(m_depth == 2 && m_inDebug && c == '{')
+				m_fileStart = pos;
+				
+			m_depth++;
+		}
+		else if(c == '}' || c == ']')
+		{
+			if(m_depth == 0)
+			{
+				m_failed = true;
+				return;
+			}
+			
+			m_depth--;
+			
+			if(m_depth == 2 && m_fileStart != NotInFile)
+			{
+				size_t consumed = 0;
+				std::string_view fileText(m_buffer.data() + m_fileStart, pos + 1 - m_fileStart);
+				
+				m_arena.clear();
+				const MIValue *file = MIParser::parseItem(fileText, m_arena, consumed);
+				
+				if(file != 0)
+					addFile(*file, m_symbols);
+					
+				m_fileStart = NotInFile;
+			}
+			else if(m_depth == 0)
+			{
+				m_done = true;
+				return;
+			}
+		}
+		
+		m_keyStart = pos + 1;
+	}
+}
+
+void MISymbolStream::compact()
+{
+	// Inside an entry, everything from its opening bracket is needed. Keys
+	// are only looked at in the top two levels, and never get long.
+	size_t keep = m_scanned;
+	if(m_fileStart != NotInFile)
+		keep = m_fileStart;
+	else if(m_depth <= 1)
+		keep = std::min(m_keyStart, m_scanned);
+		
+	if(keep > 0)
+	{
+		m_buffer.erase(0, keep);
+		m_scanned -= keep;
+		m_keyStart = (m_keyStart > keep) ? m_keyStart - keep : 0;
+		
+		if(m_fileStart != NotInFile)
+			m_fileStart -= keep;
+	}
+	
+	m_peakBuffered = std::max(m_peakBuffered, m_buffer.length());
+}
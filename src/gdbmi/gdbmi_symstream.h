@@ -0,0 +1,91 @@
+#ifndef UNIQUE_GDBMI_SYMSTREAM_H
+#define UNIQUE_GDBMI_SYMSTREAM_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <string_view>
+
+#include "gdbmi_scan.h"
+#include "gdbmi_mivalue.h"
+#include "gdbmi_symtab.h"
+
+/*
+	Parses the results of -symbol-info-functions or -symbol-info-variables
+	
+		symbols={debug=[{filename="a.c",fullname="/src/a.c",symbols=[...]},...],nondebug=[...]}
+		
+	as they arrive, in pieces split anywhere, instead of waiting for the
+	whole line. On a big C++ binary that line is hundreds of megabytes.
+	
+	Each piece goes through an MIScanner in whole 64 byte blocks, and the
+	structural characters it finds are enough to follow the brackets down
+	to the entries of the debug list. An entry is parsed with MIParser and
+	added to the table as soon as its closing bracket turns up, and its
+	text is dropped. All that's kept between pieces is the entry being
+	read and the odd bytes short of a block, so the memory used depends
+	on the biggest source file, not on the size of the response.
+	
+	Symbols without debug info (the nondebug list) are skipped, as
+	parseSymbolList() has always done.
+*/
+
+class MISymbolStream
+{
+	public:
+	
+		// The next piece of the results (everything after "^done,").
+		// Returns false once they turn out not to be a symbol list; the
+		// rest is ignored after that.
+		bool feed(std::string_view text);
+		
+		// After the last piece. Returns false if the list was malformed or
+		// cut short; the files before that are still in the table.
+		bool finish();
+		
+		// The files read so far, finished when finish() has been called
+		SymbolTable &symbols() { return m_symbols; }
+		
+		size_t bytesFed() const { return m_bytesFed; }
+		
+		// Most bytes held back between pieces
+		size_t peakBuffered() const { return m_peakBuffered; }
+		
+		// Adds an entry of the debug list ({filename=...,fullname=...,symbols=[...]})
+		static void addFile(const MIValue &file, SymbolTable &symbols);
+		
+	private:
+	
+		// Follows the structural characters just scanned (m_structurals,
+		// offsets from 'base' in m_buffer)
+		void walk(size_t base);
+		
+		// Drops the text that's no longer needed from the front of m_buffer
+		void compact();
+		
+		static constexpr size_t NotInFile = ~(size_t) 0;
+		
+		MIScanner m_scanner;
+		std::vector<uint32_t> m_structurals;
+		
+		std::string m_buffer;
+		size_t m_scanned = 0;			// Bytes of m_buffer that have been scanned
+		
+		uint32_t m_depth = 0;
+		size_t m_keyStart = 0;			// Just after the last structural character
+		std::string m_key;				// Of the last result in the top two levels
+		bool m_inDebug = false;			// In the debug=[...] list
+		size_t m_fileStart = NotInFile;	// Opening bracket of the entry being read
+		
+		bool m_done = false;			// The closing bracket of symbols={...} has been seen
+		bool m_failed = false;
+		
+		MIArena m_arena;
+		SymbolTable m_symbols;
+		
+		size_t m_bytesFed = 0;
+		size_t m_peakBuffered = 0;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include "gdbmi_symtab.h"
+
+uint32_t SymbolTable::addFile(std::string_view fullPath, std::string_view shortName)
+{
+	FileInfo info;
+	info.fullPath = intern(fullPath);
+	info.shortName = intern(shortName);
+	m_files.push_back(info);
+	
+	return m_files.size() - 1;
+}
+
+void SymbolTable::addSymbol(uint32_t file, uint32_t line, std::string_view name,
+							std::string_view type, std::string_view description)
+{
+	m_file.push_back(file);
+	m_line.push_back(line);
+	m_name.push_back(append(name));
+	m_type.push_back(intern(type));
+	m_description.push_back(append(description));
+}
+
+void SymbolTable::finish()
+{
+	m_chars.shrink_to_fit();
+	m_files.shrink_to_fit();
+	m_file.shrink_to_fit();
+	m_line.shrink_to_fit();
+	m_name.shrink_to_fit();
+	m_type.shrink_to_fit();
+	m_description.shrink_to_fit();
+	
+	decltype(m_interned)().swap(m_interned);
+}
+
+SymbolTable SymbolTable::finishedCopy() const
+{
+	// Copying a vector only allocates what's in use, and the interning
+	// table is left behind
+	SymbolTable copy;
+	copy.m_chars = m_chars;
+	copy.m_files = m_files;
+	copy.m_file = m_file;
+	copy.m_line = m_line;
+	copy.m_name = m_name;
+	copy.m_type = m_type;
+	copy.m_description = m_description;
+	
+	return copy;
+}
+
+size_t SymbolTable::memoryUsage() const
+{
+	size_t bytes = sizeof(*this);
+	bytes += m_chars.capacity();
+	bytes += m_files.capacity() * sizeof(FileInfo);
+	bytes += (m_file.capacity() + m_line.capacity()) * sizeof(uint32_t);
+	bytes += (m_name.capacity() + m_type.capacity() + m_description.capacity()) * sizeof(StrRef);
+	
+	// Roughly; each node holds the key, the value and a hash table pointer
+	for(auto &entry : m_interned)
+		bytes += sizeof(entry) + sizeof(void *) * 2 + entry.first.capacity();
+		
+	return bytes;
+}
+
+SymbolTable::StrRef SymbolTable::append(std::string_view s)
+{
+	StrRef ref;
+	ref.offset = m_chars.size();
+	ref.length = s.length();
+	m_chars.insert(m_chars.end(), s.begin(), s.end());
+	
+	return ref;
+}
+
+SymbolTable::StrRef SymbolTable::intern(std::string_view s)
+{
+	auto found = m_interned.find(s);
+	if(found != m_interned.end())
+		return found->second;
+		
+	StrRef ref = append(s);
+	m_interned.emplace(std::string(s), ref);
+	
+	return ref;
+}
@@ -0,0 +1,105 @@
+#ifndef UNIQUE_GDBMI_SYMTAB_H
+#define UNIQUE_GDBMI_SYMTAB_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+
+/*
+	A list of symbols (as returned by -symbol-info-functions and
+	-symbol-info-variables), stored by column instead of one struct per
+	symbol.
+	
+	All the text lives in one character pool. A symbol refers to its
+	strings by offset and length, and to its source file by index, so a
+	file's paths are stored once however many symbols it has. Types
+	(like "int (int, char **)") repeat a lot too, and are interned the
+	same way. Names and descriptions are nearly always unique, so they're
+	appended to the pool without looking them up first.
+	
+	A table is filled with addFile() and addSymbol(), then finish() drops
+	what was only needed while building. After that it's only read, which
+	is how GDBMI hands it out (see getFunctionSymbols()). The string_views
+	returned stay valid for as long as the table does.
+*/
+
+class SymbolTable
+{
+	public:
+	
+		// Returns the file's index, to be passed to addSymbol()
+		uint32_t addFile(std::string_view fullPath, std::string_view shortName);
+		
+		void addSymbol(uint32_t file, uint32_t line, std::string_view name,
+					   std::string_view type, std::string_view description);
+					   
+		// Trims the columns to size and frees the interning table
+		void finish();
+		
+		// A finished copy of what's been added so far, for handing out a
+		// table that's still being filled
+		SymbolTable finishedCopy() const;
+		
+		size_t size() const { return m_line.size(); }
+		size_t fileCount() const { return m_files.size(); }
+		
+		std::string_view name(size_t i) const			{ return str(m_name[i]); }
+		std::string_view type(size_t i) const			{ return str(m_type[i]); }
+		std::string_view description(size_t i) const	{ return str(m_description[i]); }
+		uint32_t line(size_t i) const					{ return m_line[i]; }
+		uint32_t file(size_t i) const					{ return m_file[i]; }
+		
+		std::string_view fullPath(size_t i) const		{ return str(m_files[m_file[i]].fullPath); }
+		std::string_view shortName(size_t i) const		{ return str(m_files[m_file[i]].shortName); }
+		
+		std::string_view fileFullPath(uint32_t file) const	{ return str(m_files[file].fullPath); }
+		std::string_view fileShortName(uint32_t file) const	{ return str(m_files[file].shortName); }
+		
+		// Bytes held by the table, its own size included
+		size_t memoryUsage() const;
+		
+	private:
+	
+		struct StrRef
+		{
+			uint32_t offset = 0;
+			uint32_t length = 0;
+		};
+		
+		struct FileInfo
+		{
+			StrRef fullPath;
+			StrRef shortName;
+		};
+		
+		std::string_view str(StrRef ref) const { return std::string_view(m_chars.data() + ref.offset, ref.length); }
+		
+		StrRef append(std::string_view s);
+		StrRef intern(std::string_view s);
+		
+		std::vector<char> m_chars;
+		std::vector<FileInfo> m_files;
+		
+		// One entry per symbol in each
+		std::vector<uint32_t> m_file;
+		std::vector<uint32_t> m_line;
+		std::vector<StrRef> m_name;
+		std::vector<StrRef> m_type;
+		std::vector<StrRef> m_description;
+		
+		// Lets the interning table be searched with a string_view
+		struct ViewHash
+		{
+			typedef void is_transparent;
+			size_t operator()(std::string_view s) const { return std::hash<std::string_view>()(s); }
+		};
+		
+		// Only used while building
+		std::unordered_map<std::string, StrRef, ViewHash, std::equal_to<>> m_interned;
+};
+
+#endif
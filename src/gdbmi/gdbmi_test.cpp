@@ -1,5 +1,8 @@
 #ifdef BUILD_GDBMI_TESTS
 #include "gdbmi.h"
+#include "gdbmi_testutil.h"
+
+#include <atomic>
 
 #define CATCH_CONFIG_MAIN
 #include "../catch.h"
@@ -80,4 +83,1523 @@ TEST_CASE("GDBMI response parsers are working correctly", "[parser]")
 	}
 }
 
+TEST_CASE("MI records parse into a value tree in one pass", "[parser]")
+{
+	MIArena arena;
+	
+	SECTION("Results, tuples and lists")
+	{
+		string rec = "reason=\"breakpoint-hit\",bkptno=\"1\",frame={addr=\"0x1131\",func=\"main\","
+					 "args=[{name=\"argc\",value=\"1\"}]},thread-groups=[\"i1\",\"i2\"]";
+					 
+		const MIValue *root = MIParser::parseResults(rec, arena);
+		
+		REQUIRE(root->kind == MIValue::Kind::Tuple);
+		REQUIRE(root->count == 4);
+		REQUIRE(root->get("reason") == "breakpoint-hit");
+		REQUIRE(root->find("missing") == 0);
+		REQUIRE(root->get("missing") == "");
+		
+		const MIValue *frame = root->find("frame");
+		REQUIRE(frame->kind == MIValue::Kind::Tuple);
+		REQUIRE(frame->get("addr") == "0x1131");
+		REQUIRE(frame->find("args")->kind == MIValue::Kind::List);
+		REQUIRE(frame->find("args")->count == 1);
+		REQUIRE(frame->find("args")->child->get("name") == "argc");
+		REQUIRE(frame->item().substr(0, 12) == "frame={addr=");
+		
+		vector<string> groups;
+		for(const MIValue &group : *root->find("thread-groups"))
+			groups.push_back(string(group.text()));
+			
+		REQUIRE(groups == vector<string>({ "i1", "i2" }));
+		
+		// Nothing is copied out of the record
+		REQUIRE(frame->source.data() > rec.data());
+		REQUIRE(frame->source.data() < rec.data() + rec.length());
+	}
+	
+	SECTION("Escapes are skipped over, and left as they are")
+	{
+		string rec = "msg=\"say \\\"hi\\\", then \\\\\",next=\"x\"";
+		const MIValue *root = MIParser::parseResults(rec, arena);
+		
+		REQUIRE(root->count == 2);
+		REQUIRE(root->get("msg") == "say \\\"hi\\\", then \\\\");
+		REQUIRE(root->get("next") == "x");
+	}
+	
+	SECTION("Malformed input keeps what came before it")
+	{
+		string rec = "a=\"1\",b={c=\"2\",d=\"unterminated";
+		size_t consumed = 0;
+		const MIValue *root = MIParser::parseResults(rec, arena, &consumed);
+		
+		REQUIRE(root->count == 1);
+		REQUIRE(consumed == 6);
+		
+		REQUIRE(MIParser::parseItem("{x=\"1\"", arena, consumed) == 0);
+		REQUIRE(consumed == 0);
+	}
+	
+	SECTION("The arena hands out values in blocks, and can be reused")
+	{
+		string rec = "list=[";
+		for(uint32_t i = 0; i < 1000; i++)
+			rec += (i > 0 ? ",{n=\"" : "{n=\"") + std::to_string(i) + "\"}";
+		rec += "]";
+		
+		const MIValue *root = MIParser::parseResults(rec, arena);
+		
+		REQUIRE(root->find("list")->count == 1000);
+		REQUIRE(arena.valueCount() == 2 + 1000 * 2);
+		
+		size_t bytes = arena.memoryUsage();
+		arena.clear();
+		REQUIRE(arena.valueCount() == 0);
+		
+		root = MIParser::parseResults(rec, arena);
+		REQUIRE(root->find("list")->count == 1000);
+		REQUIRE(arena.memoryUsage() <= bytes);
+	}
+}
+
+TEST_CASE("Record views only parse the fields asked for", "[parser]")
+{
+	string rec = "reason=\"breakpoint-hit\",bkptno=\"1\",frame={addr=\"0x1131\",func=\"main\","
+				 "args=[{name=\"argc\",value=\"1\"}],line=\"7\"},thread-id=\"1\"";
+				 
+	SECTION("Top level and nested fields")
+	{
+		MIRecordView stop(rec);
+		
+		REQUIRE(stop.get("reason") == "breakpoint-hit");
+		REQUIRE(stop.get("thread-id") == "1");
+		REQUIRE(stop.get("frame", "addr") == "0x1131");
+		REQUIRE(stop.get("frame", "line") == "7");
+		REQUIRE(stop.source("frame", "args") == "[{name=\"argc\",value=\"1\"}]");
+		REQUIRE(stop.get("bkptno") == "1");
+		
+		REQUIRE(stop.get("missing") == "");
+		REQUIRE(stop.get("frame", "missing") == "");
+		REQUIRE(stop.get("reason", "addr") == "");
+	}
+	
+	SECTION("Nothing past the field asked for is looked at")
+	{
+		// Everything after the start of args is garbage
+		string broken = "reason=\"end-stepping-range\",frame={addr=\"0x2004\",func=\"helper\",args=[{name=\"x";
+		MIRecordView stop(broken);
+		
+		REQUIRE(stop.get("reason") == "end-stepping-range");
+		REQUIRE(stop.get("frame", "addr") == "0x2004");
+		REQUIRE(stop.get("frame", "func") == "helper");
+		
+		// Going further finds the end of it, and stops there
+		REQUIRE(stop.get("frame", "args") == "");
+		REQUIRE(stop.get("thread-id") == "");
+	}
+	
+	SECTION("A whole value can be had as a tree")
+	{
+		MIRecordView stop(rec);
+		REQUIRE(stop.get("frame", "func") == "main");
+		
+		const MIValue *frame = stop.find("frame");
+		REQUIRE(frame->kind == MIValue::Kind::Tuple);
+		REQUIRE(frame->count == 4);
+		REQUIRE(frame->find("args")->child->get("name") == "argc");
+		REQUIRE(stop.find("frame") == frame);
+		
+		REQUIRE(stop.find("reason")->text() == "breakpoint-hit");
+		REQUIRE(stop.find("missing") == 0);
+	}
+}
+
+TEST_CASE("Known keys are tagged with an ID as they're parsed", "[parser]")
+{
+	SECTION("Every name maps to its own ID")
+	{
+		for(uint32_t i = 1; i < (uint32_t) MIKey::Count; i++)
+		{
+			MIKey id = (MIKey) i;
+			
+			REQUIRE(MIKeyTable::name(id).length() > 0);
+			REQUIRE(MIKeyTable::lookup(MIKeyTable::name(id)) == id);
+		}
+		
+		static_assert(MIKeyTable::lookup("func-name") == MIKey::FuncName);
+		
+		REQUIRE(MIKeyTable::lookup("") == MIKey::Unknown);
+		REQUIRE(MIKeyTable::lookup("func_name") == MIKey::Unknown);
+		REQUIRE(MIKeyTable::lookup("addr ") == MIKey::Unknown);
+		REQUIRE(MIKeyTable::lookup("thread-groups-extra") == MIKey::Unknown);
+		REQUIRE(MIKeyTable::name(MIKey::Unknown) == "");
+	}
+	
+	SECTION("The parser tags keys, and unknown ones keep their name")
+	{
+		MIArena arena;
+		const MIValue *results = MIParser::parseResults("asm_insns=[{address=\"0x1000\",func-name=\"main\","
+								 "offset=\"4\",inst=\"nop\",opcodes=\"90\"}]", arena);
+								 
+		const MIValue *asmList = results->find(MIKey::AsmInsns);
+		REQUIRE(asmList != 0);
+		REQUIRE(asmList->id == MIKey::AsmInsns);
+		
+		const MIValue &inst = *asmList->child;
+		REQUIRE(inst.id == MIKey::Unknown);
+		
+		vector<MIKey> ids;
+		for(const MIValue &field : inst)
+			ids.push_back(field.id);
+			
+		REQUIRE(ids == vector<MIKey>({ MIKey::Address, MIKey::FuncName, MIKey::Offset, MIKey::Inst, MIKey::Unknown }));
+		REQUIRE(inst.get(MIKey::FuncName) == "main");
+		REQUIRE(inst.get(MIKey::Addr) == "");
+		REQUIRE(inst.get("opcodes") == "90");
+	}
+}
+
+TEST_CASE("MI tuples bind straight into structs", "[parser]")
+{
+	struct Record
+	{
+		uint32_t line = 0;
+		uint64_t address = 0;
+		string addrStr;
+		std::string_view func;
+		bool enabled = false;
+		bool isArg = false;
+		uint32_t times = 7;
+	};
+	
+	static constexpr auto schema = miSchema<Record>(MIField(MIKey::Line, &Record::line),
+							   MIField(MIKey::Addr, &Record::address),
+							   MIField(MIKey::Addr, &Record::addrStr),
+							   MIField(MIKey::Func, &Record::func),
+							   MIField(MIKey::Enabled, &Record::enabled),
+							   MIField(MIKey::Arg, &Record::isArg),
+							   MIField(MIKey::Times, &Record::times));
+							   
+	MIArena arena;
+	
+	SECTION("Values are converted to the member types")
+	{
+		string text = "line=\"42\",addr=\"0x7fffF7a0\",func=\"main\",enabled=\"y\",arg=\"1\",unknown={a=\"1\"}";
+		Record rec = schema.bind(*MIParser::parseResults(text, arena));
+		
+		REQUIRE(rec.line == 42);
+		REQUIRE(rec.address == 0x7fffF7a0);
+		REQUIRE(rec.addrStr == "0x7fffF7a0");
+		REQUIRE(rec.func == "main");
+		REQUIRE(rec.enabled);
+		REQUIRE(rec.isArg);
+		
+		// Not in the record, so left alone
+		REQUIRE(rec.times == 7);
+	}
+	
+	SECTION("Malformed numbers and flags")
+	{
+		Record rec = schema.bind(*MIParser::parseResults("line=\"12abc\",addr=\"<unavailable>\",enabled=\"n\"", arena));
+		
+		REQUIRE(rec.line == 12);
+		REQUIRE(rec.address == 0);
+		REQUIRE(rec.addrStr == "<unavailable>");
+		REQUIRE(rec.enabled == false);
+		
+		uint32_t tooBig = 5;
+		miConvert("4294967296", tooBig);
+		REQUIRE(tooBig == 0);
+	}
+	
+	SECTION("Stack variables fill the innermost frame")
+	{
+		GDBMI gdb;
+		gdb.m_backtrace.publish({ GDBMI::FrameInfo(), GDBMI::FrameInfo() });
+		
+		GDBMI::Snapshot<GDBMI::FrameInfo> bt = respondAndWait(gdb, GDBMI::getStackVarsCallbackThunk, GDBMI::OrderDomain::Backtrace,
+											   "variables=[{name=\"argc\",arg=\"1\",type=\"int\",value=\"1\"},{name=\"hm\",type=\"Huffman\"}]",
+											   [&]() { return gdb.getBacktrace(); });
+											   
+		REQUIRE(bt->data[0].vars.size() == 2);
+		REQUIRE(bt->data[0].vars[0].name == "argc");
+		REQUIRE(bt->data[0].vars[0].isArg);
+		REQUIRE(bt->data[0].vars[0].value == "1");
+		REQUIRE(bt->data[0].vars[1].type == "Huffman");
+		REQUIRE(bt->data[0].vars[1].isArg == false);
+		REQUIRE(bt->data[0].vars[1].value == "");
+		REQUIRE(bt->data[1].vars.size() == 0);
+	}
+}
+
+TEST_CASE("Structural characters are found the same way by every kernel", "[parser]")
+{
+	// One character at a time; backslashes only come up inside strings
+	auto reference = [](const string & text)
+	{
+		vector<uint32_t> ret;
+		bool inString = false;
+		
+		for(uint32_t i = 0; i < text.length(); i++)
+		{
+			char c = text[i];
+			
+			if(inString)
+			{
+				if(c == '\\')
+					i++;
+				else if(c == '"')
+				{
+					inString = false;
+					ret.push_back(i);
+				}
+			}
+			else if(c == '"')
+			{
+				inString = true;
+				ret.push_back(i);
+			}
+			else if(strchr("{}[],=", c) != 0)
+				ret.push_back(i);
+		}
+		
+		return ret;
+	};
+	
+	// MI-like text, with strings full of escapes and brackets that run across block edges
+	srand(1234);
+	string text;
+	while(text.length() < 20000)
+	{
+		switch(rand() % 4)
+		{
+			case 0:
+			{
+				text += '"';
+				uint32_t length = rand() % 150;
+				for(uint32_t i = 0; i < length; i++)
+				{
+					const char *pieces[] = { "a", "b", "{", "]", ",", "=", "\\\"", "\\\\", "\\n", " " };
+					text += pieces[rand() % 10];
+				}
+				text += '"';
+			}
+			break;
+			
+			case 1: text += "{}[],="[rand() % 6]; break;
+			case 2: text += "key-" + std::to_string(rand() % 1000); break;
+			case 3:
+			{
+				// Long runs of backslashes; an odd one escapes the quote after it
+				uint32_t run = rand() % 70;
+				text += '"' + string(run, '\\') + ((run % 2) ? "\"\"" : "\"");
+			}
+			break;
+		}
+	}
+	
+	vector<uint32_t> expected = reference(text);
+	REQUIRE(expected.size() > 500);
+	
+	for(auto kernel : { MIScanner::Kernel::Scalar, MIScanner::Kernel::SSE2, MIScanner::Kernel::AVX2 })
+	{
+		if(MIScanner::kernelSupported(kernel) == false)
+			continue;
+			
+		INFO(MIScanner::kernelName(kernel));
+		
+		vector<uint32_t> found;
+		MIScanner::findStructurals(text, found, kernel);
+		REQUIRE(found == expected);
+		
+		// A bit at a time, and text that doesn't fill its last block
+		for(size_t chunk : { 64, 192, 4096 })
+		{
+			string partial = text.substr(0, text.length() - chunk / 3);
+			vector<uint32_t> partialExpected = reference(partial);
+			
+			found.clear();
+			MIScanner scanner(partial, kernel);
+			while(scanner.scanMore(chunk, found));
+			
+			REQUIRE(found == partialExpected);
+		}
+	}
+}
+
+TEST_CASE("GDBMI is ready once GDB prints its first prompt", "[startup]")
+{
+	GDBMI gdb;
+	
+	// The constructor already waited for the prompt
+	REQUIRE(gdb.isReady());
+	REQUIRE(gdb.waitReady(0));
+	
+	bool cbCalled = false;
+	gdb.setReadyCallback([&](GDBMI *) { cbCalled = true; });
+	REQUIRE(cbCalled);
+}
+
+TEST_CASE("GDBMI reports a GDB binary that can't be launched", "[startup]")
+{
+	GDBMI::LaunchOptions opts;
+	opts.gdbPath = "/nonexistent/path/to/gdb";
+	opts.extraArgs.push_back("--quiet");
+	opts.env.push_back("LC_ALL=C");
+	
+	GDBMI gdb(opts);
+	
+	REQUIRE(gdb.isReady() == false);
+	REQUIRE(gdb.waitReady(0) == false);
+	REQUIRE(gdb.getLaunchOptions().gdbPath == opts.gdbPath);
+}
+
+TEST_CASE("GDBMI handles records on a fixed worker pool", "[dispatch]")
+{
+	GDBMI::LaunchOptions opts;
+	opts.handlerThreads = 2;
+	
+	GDBMI gdb(opts);
+	
+	// GDB answers the two -gdb-set commands sent by the constructor
+	waitUntil([&]() { return gdb.getDispatchStats().recordsHandled >= 2; });
+	GDBMI::DispatchStats stats = gdb.getDispatchStats();
+	
+	REQUIRE(stats.workerCount == 2);
+	REQUIRE(stats.recordsHandled >= 2);
+	REQUIRE(stats.maxQueueDepth >= 1);
+	REQUIRE(stats.avgServiceUs <= stats.maxServiceUs);
+}
+
+TEST_CASE("Records in the same ordering domain are handled in arrival order", "[dispatch]")
+{
+	GDBMI::LaunchOptions opts;
+	opts.handlerThreads = 4;
+	
+	GDBMI gdb(opts);
+	
+	mutex seenMutex;
+	vector<uint32_t> seen;
+	std::atomic<uint32_t> active(0);
+	std::atomic<uint32_t> maxActive(0);
+	
+	auto orderedCB = [&](GDBMI * obj, GDBMI::GDBResponse resp)
+	{
+		uint32_t nowActive = ++active;
+		if(nowActive > maxActive)
+			maxActive = nowActive;
+			
+		usleep(200);
+		
+		seenMutex.lock();
+		seen.push_back(strtoul(resp.recordData.c_str(), 0, 10));
+		seenMutex.unlock();
+		
+		active--;
+	};
+	
+	vector<uint32_t> tokens;
+	for(uint32_t i = 0; i < 50; i++)
+	{
+		tokens.push_back(gdb.getToken());
+		gdb.registerCallback(tokens.back(), orderedCB, GDBMI::OrderDomain::Registers);
+	}
+	
+	for(uint32_t i = 0; i < 50; i++)
+		gdb.handleResponse(std::to_string(tokens[i]) + "^done," + std::to_string(i));
+		
+	auto seenCount = [&]() -> size_t
+	{
+		std::lock_guard<mutex> lock(seenMutex);
+		return seen.size();
+	};
+	
+	waitUntil([&]() { return seenCount() == 50; });
+	
+	seenMutex.lock();
+	REQUIRE(seen.size() == 50);
+	for(uint32_t i = 0; i < seen.size(); i++)
+		REQUIRE(seen[i] == i);
+	seenMutex.unlock();
+	
+	REQUIRE(maxActive == 1);
+}
+
+TEST_CASE("Token callback table", "[tokens]")
+{
+	TokenMap<uint32_t> map(16);
+	
+	// Enough entries to make the table grow a few times
+	for(uint32_t tk = 1; tk <= 1000; tk++)
+		map.insert(tk, tk * 2);
+		
+	REQUIRE(map.size() == 1000);
+	REQUIRE(map.find(0) == 0);
+	REQUIRE(map.find(1001) == 0);
+	REQUIRE(*map.find(500) == 1000);
+	
+	// Erase every other entry; the rest must still be found
+	for(uint32_t tk = 1; tk <= 1000; tk += 2)
+		REQUIRE(map.erase(tk));
+		
+	REQUIRE(map.size() == 500);
+	REQUIRE(map.erase(1) == false);
+	
+	for(uint32_t tk = 1; tk <= 1000; tk++)
+	{
+		uint32_t *val = map.find(tk);
+		
+		if(tk % 2 == 0)
+		{
+			REQUIRE(val != 0);
+			REQUIRE(*val == tk * 2);
+		}
+		else REQUIRE(val == 0);
+	}
+	
+	uint32_t out = 0;
+	REQUIRE(map.take(42, out));
+	REQUIRE(out == 84);
+	REQUIRE(map.find(42) == 0);
+}
+
+TEST_CASE("Record tokens and classes are parsed without strings", "[tokens]")
+{
+	GDBMI gdb;
+	
+	uint32_t first = gdb.getToken();
+	REQUIRE(gdb.getToken() == first + 1);
+	
+	REQUIRE(GDBMI::getRecordClass("stopped") == GDBMI::RecordClass::Stopped);
+	REQUIRE(GDBMI::getRecordClass("breakpoint-modified") == GDBMI::RecordClass::BreakpointModified);
+	REQUIRE(GDBMI::getRecordClass("done") == GDBMI::RecordClass::Unknown);
+	
+	std::atomic<uint32_t> gotToken(0);
+	uint32_t token = respond(gdb, [&](GDBMI *, GDBMI::GDBResponse resp) { gotToken = resp.recordToken; }, GDBMI::OrderDomain::None,
+							 "value=\"1\"");
+							 
+	REQUIRE(waitUntil([&]() { return gotToken != 0; }));
+	REQUIRE(gotToken == token);
+}
+
+TEST_CASE("sendCommand() hands back the command's result", "[commands]")
+{
+	SECTION("Results and errors from GDB complete the handle")
+	{
+		GDBMI gdb;
+		
+		std::atomic<bool> cbCalled(false);
+		GDBMI::CommandHandle done = gdb.sendCommand("-gdb-set confirm off",
+												   [&](GDBMI *, GDBMI::GDBResponse) { cbCalled = true; });
+		GDBMI::CommandHandle error = gdb.sendCommand("-no-such-command");
+		
+		REQUIRE(done.waitFor(5000));
+		REQUIRE(done.get().ok());
+		REQUIRE(done.get().token == done.token());
+		REQUIRE(done.get().resultClass == "done");
+		
+		// The callback runs before the result is set
+		REQUIRE(cbCalled);
+		
+		REQUIRE(error.waitFor(5000));
+		REQUIRE(error.get().status == GDBMI::MIResult::Status::Error);
+		REQUIRE(error.get().data.find("msg=") == 0);
+		
+		// Completed commands are off the pending table
+		GDBMI::CommandStats stats = gdb.getCommandStats();
+		REQUIRE(stats.pending == 0);
+		REQUIRE(stats.completed >= 4); // Including the constructor's -gdb-set commands
+		REQUIRE(stats.errors == 1);
+		REQUIRE(stats.avgLatencyUs <= stats.maxLatencyUs);
+		
+		REQUIRE(done.cancel() == false);
+	}
+	
+	SECTION("Commands GDB doesn't get to in time time out, or can be cancelled")
+	{
+		GDBMI gdb;
+		
+		// Keeps GDB from reading the commands after it for a second
+		gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+		
+		GDBMI::CommandHandle timesOut = gdb.sendCommand("-break-list", 0, GDBMI::OrderDomain::None, 50);
+		GDBMI::CommandHandle cancelled = gdb.sendCommand("-break-list", 0, GDBMI::OrderDomain::None, 0);
+		
+		REQUIRE(cancelled.isDone() == false);
+		REQUIRE(cancelled.cancel());
+		REQUIRE(cancelled.get().status == GDBMI::MIResult::Status::Cancelled);
+		REQUIRE(cancelled.cancel() == false);
+		
+		REQUIRE(timesOut.waitFor(5000));
+		REQUIRE(timesOut.get().status == GDBMI::MIResult::Status::Timeout);
+		
+		GDBMI::CommandStats stats = gdb.getCommandStats();
+		REQUIRE(stats.timedOut == 1);
+		REQUIRE(stats.cancelled == 1);
+		REQUIRE(stats.maxPending >= 3);
+	}
+	
+	SECTION("Commands are failed once GDB is gone")
+	{
+		GDBMI::CommandHandle orphan;
+		
+		{
+			GDBMI gdb;
+			gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+			orphan = gdb.sendCommand("-break-list", 0, GDBMI::OrderDomain::None, 0);
+		}
+		
+		REQUIRE(orphan.isDone());
+		REQUIRE(orphan.get().status == GDBMI::MIResult::Status::GDBExited);
+		
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		
+		GDBMI noGDB(opts);
+		GDBMI::CommandHandle unanswered = noGDB.sendCommand("-break-list");
+		
+		REQUIRE(unanswered.isDone());
+		REQUIRE(unanswered.get().status == GDBMI::MIResult::Status::GDBExited);
+		REQUIRE(noGDB.getCommandStats().pending == 0);
+	}
+	
+	SECTION("Async records for a command without a callback are let through")
+	{
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		
+		GDBMI gdb(opts);
+		
+		// What sendCommand("-exec-run") leaves on the pending table
+		uint32_t token = gdb.getToken();
+		gdb.registerCallback(token, 0, GDBMI::OrderDomain::Registers);
+		
+		std::atomic<bool> after(false);
+		uint32_t afterToken = gdb.getToken();
+		gdb.registerCallback(afterToken, [&](GDBMI *, GDBMI::GDBResponse) { after = true; }, GDBMI::OrderDomain::Registers);
+		
+		gdb.handleResponse(std::to_string(token) + "*running,thread-id=\"all\"");
+		gdb.handleResponse(std::to_string(token) + "+download,section=\".text\"");
+		gdb.handleResponse(std::to_string(token) + "=thread-selected,id=\"1\"");
+		gdb.handleResponse(std::to_string(afterToken) + "^done");
+		
+		REQUIRE(waitUntil([&]() { return after == true; }));
+	}
+}
+
+TEST_CASE("Identical data requests in flight are coalesced", "[commands]")
+{
+	GDBMI gdb;
+	
+	waitIdle(gdb);
+	GDBMI::CommandStats before = gdb.getCommandStats();
+	
+	// Keeps the first -break-list in flight while the rest of the burst comes in
+	gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+	
+	// Each notification asks for the breakpoint list again
+	for(uint32_t i = 1; i <= 50; i++)
+		gdb.handleResponse("=breakpoint-created,bkpt={number=\"" + std::to_string(i) + "\"}");
+		
+	waitIdle(gdb);
+	GDBMI::CommandStats after = gdb.getCommandStats();
+	
+	// The sleep, the first -break-list and a single trailing one
+	REQUIRE(after.completed - before.completed == 3);
+	REQUIRE(after.coalesced - before.coalesced == 49);
+	REQUIRE(after.trailingFetches - before.trailingFetches == 1);
+	REQUIRE(after.pending == 0);
+}
+
+TEST_CASE("Results for an older stop are dropped", "[commands]")
+{
+	GDBMI gdb;
+	
+	waitUntil([&]() { return gdb.getCommandStats().pending == 0; });
+	
+	GDBMI::CommandStats before = gdb.getCommandStats();
+	uint32_t generation = gdb.getStopGeneration();
+	
+	// Nothing is answered until all three records below have been handled
+	gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+	
+	// The first stop asks for registers, backtrace, position and disassembly.
+	// By the time GDB answers, the inferior has run and stopped again, so those
+	// results are dropped and the second stop's (trailing) requests are kept.
+	// The changed-registers list is the exception; it's never dropped.
+	gdb.handleResponse("*stopped,reason=\"signal-received\",signal-name=\"SIGINT\"");
+	gdb.handleResponse("*running,thread-id=\"all\"");
+	gdb.handleResponse("*stopped,reason=\"signal-received\",signal-name=\"SIGINT\"");
+	
+	REQUIRE(waitUntil([&]() { return gdb.getStopGeneration() == generation + 3; }, 500));
+	
+	waitIdle(gdb);
+	GDBMI::CommandStats after = gdb.getCommandStats();
+	
+	REQUIRE(after.stale - before.stale == 3);
+	REQUIRE(after.trailingFetches - before.trailingFetches == 4);
+	REQUIRE(after.pending == 0);
+}
+
+TEST_CASE("Interactive commands are written ahead of queued view and bulk ones", "[commands]")
+{
+	REQUIRE(GDBMI::getCommandPriority("-exec-step") == GDBMI::CmdPriority::Interactive);
+	REQUIRE(GDBMI::getCommandPriority("-break-insert *0x1000") == GDBMI::CmdPriority::Interactive);
+	REQUIRE(GDBMI::getCommandPriority("-break-list") == GDBMI::CmdPriority::View);
+	REQUIRE(GDBMI::getCommandPriority("-stack-list-frames") == GDBMI::CmdPriority::View);
+	REQUIRE(GDBMI::getCommandPriority("-symbol-info-functions") == GDBMI::CmdPriority::Bulk);
+	
+	GDBMI::LaunchOptions opts;
+	opts.commandWindow = 1;
+	GDBMI gdb(opts);
+	
+	std::mutex orderMutex;
+	vector<string> order;
+	auto record = [&](const char *name)
+	{
+		return [&, name](GDBMI *, GDBMI::GDBResponse)
+		{
+			orderMutex.lock();
+			order.push_back(name);
+			orderMutex.unlock();
+		};
+	};
+	
+	// Everything below queues up behind this one
+	gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+	
+	// All in one domain, so the callbacks run in the order GDB answered
+	vector<GDBMI::CommandHandle> handles;
+	handles.push_back(gdb.sendCommand("-symbol-info-functions", record("bulk1"), GDBMI::OrderDomain::Breakpoints, 0));
+	handles.push_back(gdb.sendCommand("-stack-list-frames", record("view1"), GDBMI::OrderDomain::Breakpoints, 0));
+	handles.push_back(gdb.sendCommand("-gdb-set confirm off", record("interactive1"), GDBMI::OrderDomain::Breakpoints, 0));
+	handles.push_back(gdb.sendCommand("-symbol-info-variables", record("bulk2"), GDBMI::OrderDomain::Breakpoints, 0));
+	handles.push_back(gdb.sendCommand("-stack-list-frames", record("view2"), GDBMI::OrderDomain::Breakpoints, 0));
+	
+	// An explicit priority overrides the one picked from the command text
+	handles.push_back(gdb.sendCommand("-data-list-register-names", record("interactive2"), GDBMI::OrderDomain::Breakpoints, 0,
+									  GDBMI::CmdPriority::Interactive));
+									  
+	GDBMI::CommandStats queued = gdb.getCommandStats();
+	REQUIRE(queued.unanswered == 1);
+	REQUIRE(queued.queued[(size_t) GDBMI::CmdPriority::Interactive] + queued.queued[(size_t) GDBMI::CmdPriority::View] +
+			queued.queued[(size_t) GDBMI::CmdPriority::Bulk] >= 5);
+			
+	for(auto &handle : handles)
+		REQUIRE(handle.waitFor(5000));
+		
+	vector<string> expected = { "interactive1", "interactive2", "view1", "view2", "bulk1", "bulk2" };
+	REQUIRE(order == expected);
+	
+	GDBMI::CommandStats after = gdb.getCommandStats();
+	REQUIRE(after.unanswered == 0);
+	REQUIRE(after.queued[(size_t) GDBMI::CmdPriority::Bulk] == 0);
+}
+
+TEST_CASE("Events are delivered to every subscriber in batches", "[events]")
+{
+	using EventType = GDBMI::EventType;
+	
+	GDBMI gdb;
+	
+	mutex eventMutex;
+	std::condition_variable eventCond;
+	vector<vector<GDBMI::Event>> regBatches;
+	vector<GDBMI::Event> bpEvents;
+	
+	gdb.subscribe((uint32_t) EventType::RegistersChanged | (uint32_t) EventType::BacktraceChanged,
+				  [&](GDBMI *, const vector<GDBMI::Event> &events)
+	{
+		std::lock_guard<mutex> lock(eventMutex);
+		regBatches.push_back(events);
+		eventCond.notify_all();
+	});
+	
+	uint32_t bpSub = gdb.subscribe(EventType::BreakpointsChanged, [&](GDBMI *, const vector<GDBMI::Event> &events)
+	{
+		std::lock_guard<mutex> lock(eventMutex);
+		bpEvents.insert(bpEvents.end(), events.begin(), events.end());
+		eventCond.notify_all();
+	});
+	
+	auto waitFor = [&](function<bool()> done)
+	{
+		std::unique_lock<mutex> lock(eventMutex);
+		return eventCond.wait_for(lock, std::chrono::seconds(5), done);
+	};
+	
+	SECTION("Events published while a batch waits go out with it")
+	{
+		// Holds up delivery until everything below has been published
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		gdb.postTask(GDBMI::OrderDomain::Events, [released]() { released.wait(); });
+		
+		GDBMI::Event regs;
+		regs.type = EventType::RegistersChanged;
+		regs.registers = { 1, 3 };
+		gdb.publishEvent(regs);
+		
+		regs.registers = { 3, 7 };
+		gdb.publishEvent(regs);
+		
+		gdb.publishEvent(EventType::BacktraceChanged);
+		gdb.publishEvent(EventType::FunctionsChanged); // Nobody asked for these
+		release.set_value();
+		
+		REQUIRE(waitFor([&]() { return regBatches.size() > 0; }));
+		
+		std::lock_guard<mutex> lock(eventMutex);
+		REQUIRE(regBatches.size() == 1);
+		REQUIRE(regBatches[0].size() == 2);
+		REQUIRE(regBatches[0][0].type == EventType::RegistersChanged);
+		REQUIRE(regBatches[0][0].registers == vector<uint32_t>({ 1, 3, 7 }));
+		REQUIRE(regBatches[0][0].stopGeneration == gdb.getStopGeneration());
+		REQUIRE(regBatches[0][1].type == EventType::BacktraceChanged);
+		REQUIRE(bpEvents.size() == 0);
+	}
+	
+	SECTION("Breakpoint list updates carry what changed")
+	{
+		auto sendBpList = [&](const string &body)
+		{
+			respond(gdb, GDBMI::bpListCallbackThunk, GDBMI::OrderDomain::Breakpoints,
+					"BreakpointTable={nr_rows=\"1\",nr_cols=\"6\",body=[" + body + "]}");
+		};
+		
+		string bp1 = "bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x1000\",times=\"0\"}";
+		string bp1Hit = "bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x1000\",times=\"1\"}";
+		string bp2 = "bkpt={number=\"2\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x2000\",times=\"0\"}";
+		
+		sendBpList(bp1);
+		REQUIRE(waitFor([&]() { return bpEvents.size() >= 1; }));
+		
+		sendBpList(bp1Hit + "," + bp2);
+		REQUIRE(waitFor([&]() { return bpEvents.size() >= 2; }));
+		
+		sendBpList(bp2);
+		REQUIRE(waitFor([&]() { return bpEvents.size() >= 3; }));
+		
+		std::lock_guard<mutex> lock(eventMutex);
+		REQUIRE(bpEvents[0].bpAdded == vector<uint32_t>({ 1 }));
+		REQUIRE(bpEvents[1].bpAdded == vector<uint32_t>({ 2 }));
+		REQUIRE(bpEvents[1].bpModified == vector<uint32_t>({ 1 }));
+		REQUIRE(bpEvents[2].bpRemoved == vector<uint32_t>({ 1 }));
+		REQUIRE(bpEvents[2].bpAdded.size() == 0);
+		REQUIRE(regBatches.size() == 0);
+	}
+	
+	gdb.unsubscribe(bpSub);
+}
+
+TEST_CASE("Unsubscribing waits for a batch being delivered", "[events]")
+{
+	using EventType = GDBMI::EventType;
+	
+	GDBMI gdb;
+	
+	SECTION("A slow callback has finished when unsubscribe() returns")
+	{
+		std::atomic<bool> started(false);
+		std::atomic<bool> finished(false);
+		
+		uint32_t sub = gdb.subscribe(EventType::RegistersChanged, [&](GDBMI *, const vector<GDBMI::Event> &)
+		{
+			started = true;
+			usleep(1000 * 200);
+			finished = true;
+		});
+		
+		gdb.publishEvent(EventType::RegistersChanged);
+		
+		REQUIRE(waitUntil([&]() { return started == true; }));
+		
+		gdb.unsubscribe(sub);
+		REQUIRE(finished);
+	}
+	
+	SECTION("Callbacks can unsubscribe, and the rest of the batch skips them")
+	{
+		std::atomic<uint32_t> secondCalls(0);
+		std::atomic<bool> lastCalled(false);
+		uint32_t second = 0;
+		
+		uint32_t first = gdb.subscribe(EventType::RegistersChanged, [&](GDBMI *obj, const vector<GDBMI::Event> &)
+		{
+			obj->unsubscribe(second);
+		});
+		
+		second = gdb.subscribe(EventType::RegistersChanged, [&](GDBMI *, const vector<GDBMI::Event> &) { secondCalls++; });
+		gdb.subscribe(EventType::RegistersChanged, [&](GDBMI *, const vector<GDBMI::Event> &) { lastCalled = true; });
+		
+		gdb.publishEvent(EventType::RegistersChanged);
+		
+		REQUIRE(waitUntil([&]() { return lastCalled == true; }));
+		REQUIRE(secondCalls == 0);
+		
+		gdb.unsubscribe(first);
+	}
+}
+
+TEST_CASE("Data getters hand out immutable snapshots", "[snapshot]")
+{
+	SECTION("Readers keep the version they got")
+	{
+		SnapshotCell<vector<int>> cell;
+		REQUIRE(cell.version() == 0);
+		REQUIRE(cell.get()->data.size() == 0);
+		
+		REQUIRE(cell.publish({ 1, 2, 3 }) == 1);
+		SnapshotCell<vector<int>>::Ptr held = cell.get();
+		
+		REQUIRE(cell.update([](vector<int> &v) { v.push_back(4); }) == 2);
+		REQUIRE(cell.publish({}) == 3);
+		
+		REQUIRE(held->version == 1);
+		REQUIRE(held->data == vector<int>({ 1, 2, 3 }));
+		REQUIRE(cell.get()->data.size() == 0);
+	}
+	
+	SECTION("Concurrent updates are all kept")
+	{
+		SnapshotCell<vector<int>> cell;
+		vector<thread> writers;
+		
+		for(int w = 0; w < 4; w++)
+		{
+			writers.push_back(thread([&cell, w]()
+			{
+				for(int i = 0; i < 250; i++)
+					cell.update([&](vector<int> &v) { v.push_back(w); });
+			}));
+		}
+		
+		for(auto &writer : writers)
+			writer.join();
+			
+		REQUIRE(cell.version() == 1000);
+		REQUIRE(cell.get()->data.size() == 1000);
+	}
+	
+	SECTION("A new breakpoint list doesn't touch the one a reader holds")
+	{
+		GDBMI gdb;
+		GDBMI::Snapshot<GDBMI::BreakpointInfo> before = gdb.getBpList();
+		
+		GDBMI::Snapshot<GDBMI::BreakpointInfo> after = respondAndWait(gdb, GDBMI::bpListCallbackThunk, GDBMI::OrderDomain::Breakpoints,
+				"BreakpointTable={nr_rows=\"1\",nr_cols=\"6\",body=["
+				"bkpt={number=\"1\",type=\"breakpoint\",disp=\"keep\",enabled=\"y\",addr=\"0x1000\",times=\"0\"}]}",
+				[&]() { return gdb.getBpList(); });
+				
+		REQUIRE(after->version == before->version + 1);
+		REQUIRE(after->data.size() == 1);
+		REQUIRE(after->data[0].addr == "0x1000");
+		REQUIRE(before->data.size() == 0);
+	}
+}
+
+TEST_CASE("Registers are kept by number and refreshed in place", "[registers]")
+{
+	GDBMI gdb;
+	
+	auto respondRegs = [&](GDBMI::CmdCallback cb, const string &data)
+	{
+		return respondAndWait(gdb, cb, GDBMI::OrderDomain::Registers, data, [&]() { return gdb.getRegisters(); });
+	};
+	
+	GDBMI::Snapshot<GDBMI::RegisterInfo> regs = respondRegs(GDBMI::getregNamesCallbackThunk, "register-names=[\"rax\",\"rbx\",\"\",\"rip\"]");
+	REQUIRE(regs->data.size() == 4);
+	REQUIRE(regs->data[3].regName == "rip");
+	REQUIRE(regs->data[3].regNum == 3);
+	REQUIRE(regs->data[3].regValue.length() == 0);
+	
+	regs = respondRegs(GDBMI::getregValsCallbackThunk, "register-values=[{number=\"0\",value=\"0x1\"},"
+				   "{number=\"1\",value=\"0x2\"},{number=\"2\",value=\"0x3\"},{number=\"3\",value=\"0x1000\"}]");
+	REQUIRE(regs->data[0].regValue == "0x1");
+	REQUIRE(regs->data[2].regValue.length() == 0); // No name, so not kept
+	REQUIRE(regs->data[3].regValue == "0x1000");
+	REQUIRE(regs->data[3].updated == false);
+	
+	// A step where only rip changed
+	GDBMI::Snapshot<GDBMI::RegisterInfo> before = regs;
+	regs = respondRegs(GDBMI::getregValsCallbackThunk, "register-values=[{number=\"3\",value=\"0x1004\"}]");
+	REQUIRE(regs->data[3].regValue == "0x1004");
+	REQUIRE(regs->data[3].updated);
+	REQUIRE(regs->data[0].regValue == "0x1");
+	REQUIRE(regs->data[0].updated == false);
+	REQUIRE(before->data[3].regValue == "0x1000");
+	
+	// Nothing changed since, so only the change marks go
+	regs = respondRegs(GDBMI::getChangedRegsCallbackThunk, "changed-registers=[]");
+	REQUIRE(regs->data[3].regValue == "0x1004");
+	REQUIRE(regs->data[3].updated == false);
+}
+
+TEST_CASE("Stops inside a cached function don't ask GDB for disassembly", "[disassembly]")
+{
+	GDBMI gdb;
+	
+	auto listFunction = [&](const string &func, uint64_t start)
+	{
+		string body;
+		for(uint64_t addr = start; addr <= start + 0x10; addr += 4)
+		{
+			if(body.length() > 0)
+				body += ",";
+				
+			char addrStr[32];
+			snprintf(addrStr, sizeof(addrStr), "0x%lx", (unsigned long) addr);
+			body += string("{address=\"") + addrStr + "\",func-name=\"" + func + "\",offset=\"" +
+					std::to_string(addr - start) + "\",inst=\"nop\"}";
+		}
+		
+		return respondAndWait(gdb, GDBMI::getDisassemblyCallbackThunk, GDBMI::OrderDomain::Disassembly, "asm_insns=[" + body + "]",
+							  [&]() { return gdb.getDisassembly(); });
+	};
+	
+	listFunction("main", 0x1000);
+	GDBMI::Snapshot<GDBMI::DisassemblyInstruction> disas = listFunction("helper", 0x2000);
+	REQUIRE(disas->data.front().funcName == "helper");
+	REQUIRE(gdb.getDisasCacheStats().entries == 2);
+	
+	SECTION("Stepping inside the function on screen changes nothing")
+	{
+		gdb.requestStopDisassembly("$pc", 0x2008);
+		
+		REQUIRE(gdb.getDisassembly()->version == disas->version);
+		REQUIRE(gdb.getDisasCacheStats().hits == 1);
+		REQUIRE(gdb.getDisasCacheStats().misses == 0);
+	}
+	
+	SECTION("Returning to another cached function publishes it")
+	{
+		gdb.requestStopDisassembly("$pc", 0x100c);
+		
+		disas = gdb.getDisassembly();
+		REQUIRE(disas->data.size() == 5);
+		REQUIRE(disas->data.front().funcName == "main");
+		
+		GDBMI::DisasCacheStats stats = gdb.getDisasCacheStats();
+		REQUIRE(stats.hits == 1);
+		REQUIRE(stats.hitRate == 1.0);
+	}
+	
+	SECTION("A breakpoint hit inside a cached function moves the highlight without asking GDB")
+	{
+		auto inFlight = [&](const string & cmd)
+		{
+			std::lock_guard<mutex> lock(gdb.m_inFlightMutex);
+			return gdb.m_inFlightRequests.count(cmd) > 0;
+		};
+		
+		// Keeps whatever the stop sends waiting, so it's still in flight below
+		gdb.sendCommand("-interpreter-exec console \"shell sleep 1\"");
+		
+		gdb.handleResponse("*stopped,reason=\"breakpoint-hit\",disp=\"keep\",bkptno=\"1\",frame={addr=\"0x0000000000002008\","
+						   "func=\"helper\",args=[],file=\"a.c\",line=\"3\"},thread-id=\"1\",stopped-threads=\"all\"");
+						   
+		REQUIRE(waitUntil([&]() { return gdb.getDisasCacheStats().hits == 1; }));
+		REQUIRE(inFlight("-stack-list-frames"));
+		
+		GDBMI::CurrentInstruction pos = gdb.getCurrentExecutionPos();
+		REQUIRE(pos.first == 0x2008);
+		REQUIRE(pos.second == "helper");
+		
+		REQUIRE(inFlight("-data-evaluate-expression $pc") == false);
+		REQUIRE(inFlight("-data-disassemble -a $pc 0") == false);
+		REQUIRE(gdb.getDisassembly()->version == disas->version);
+	}
+	
+	SECTION("Memory writes and library loads drop the cache")
+	{
+		gdb.handleResponse("=memory-changed,thread-group=\"i1\",addr=\"0x1004\",len=\"0x4\"");
+		
+		waitUntil([&]() { return gdb.getDisasCacheStats().entries == 0; });
+		
+		GDBMI::DisasCacheStats stats = gdb.getDisasCacheStats();
+		REQUIRE(stats.entries == 0);
+		REQUIRE(stats.invalidations == 1);
+		
+		listFunction("main", 0x1000);
+		gdb.handleResponse("=library-loaded,id=\"/lib/libc.so.6\",target-name=\"/lib/libc.so.6\"");
+		
+		waitUntil([&]() { return gdb.getDisasCacheStats().entries == 0; });
+		
+		REQUIRE(gdb.getDisasCacheStats().invalidations == 2);
+	}
+	
+	SECTION("The stop record's frame gives the PC")
+	{
+		MIRecordView stepped("reason=\"end-stepping-range\",frame={addr=\"0x0000000000002004\",func=\"helper\","
+							 "args=[],file=\"a.c\",line=\"3\"},thread-id=\"1\"");
+		REQUIRE(gdb.getStopFramePC(stepped) == 0x2004);
+		
+		MIRecordView signalled("reason=\"signal-received\",signal-name=\"SIGINT\"");
+		REQUIRE(gdb.getStopFramePC(signalled) == 0);
+	}
+}
+
+TEST_CASE("Symbols are stored by column with shared strings", "[symbols]")
+{
+	SECTION("Paths and types are stored once")
+	{
+		SymbolTable table;
+		uint32_t a = table.addFile("/src/a.c", "a.c");
+		uint32_t b = table.addFile("/src/b.c", "b.c");
+		
+		table.addSymbol(a, 10, "main", "int (void)", "int main(void);");
+		table.addSymbol(a, 20, "helper", "int (void)", "static int helper(void);");
+		table.addSymbol(b, 5, "other", "void (int)", "void other(int);");
+		table.finish();
+		
+		REQUIRE(table.size() == 3);
+		REQUIRE(table.fileCount() == 2);
+		REQUIRE(table.name(1) == "helper");
+		REQUIRE(table.line(1) == 20);
+		REQUIRE(table.description(2) == "void other(int);");
+		REQUIRE(table.fullPath(1) == "/src/a.c");
+		REQUIRE(table.shortName(2) == "b.c");
+		REQUIRE(table.type(0) == table.type(1));
+		REQUIRE(table.type(0).data() == table.type(1).data());
+		REQUIRE(table.type(2) == "void (int)");
+	}
+	
+	SECTION("A symbol list from GDB is published as one table")
+	{
+		GDBMI gdb;
+		uint64_t version = gdb.getFunctionSymbols()->version;
+		
+		GDBMI::SymbolSnapshot symbols = respondAndWait(gdb, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::OrderDomain::Symbols,
+										"symbols={debug=["
+										"{filename=\"a.c\",fullname=\"/src/a.c\",symbols=["
+										"{line=\"10\",name=\"main\",type=\"int (void)\",description=\"int main(void);\"},"
+										"{line=\"20\",name=\"helper\",type=\"int (void)\",description=\"static int helper(void);\"}]},"
+										"{filename=\"b.c\",fullname=\"/src/b.c\",symbols=["
+										"{line=\"5\",name=\"other\",type=\"void (int)\",description=\"void other(int);\"}]}]}",
+										[&]() { return gdb.getFunctionSymbols(); });
+										
+		const SymbolTable &table = symbols->data;
+		
+		REQUIRE(symbols->version == version + 1);
+		REQUIRE(table.size() == 3);
+		REQUIRE(table.fileCount() == 2);
+		REQUIRE(table.name(0) == "main");
+		REQUIRE(table.line(0) == 10);
+		REQUIRE(table.file(2) == 1);
+		REQUIRE(table.shortName(2) == "b.c");
+		REQUIRE(table.fullPath(1) == "/src/a.c");
+	}
+}
+
+TEST_CASE("Long symbol lists are parsed as they're read", "[symbols]")
+{
+	SECTION("Any split of the text gives the same table")
+	{
+		string text = makeSymbolResults(20, 30);
+		
+		MIArena arena;
+		SymbolTable expected;
+		for(const MIValue &file : *MIParser::parseResults(text, arena)->find("symbols")->find("debug"))
+			MISymbolStream::addFile(file, expected);
+			
+		for(size_t piece : { (size_t) 1, (size_t) 7, (size_t) 64, (size_t) 1000, text.length() })
+		{
+			MISymbolStream stream;
+			for(size_t i = 0; i < text.length(); i += piece)
+				REQUIRE(stream.feed(std::string_view(text).substr(i, piece)));
+				
+			REQUIRE(stream.finish());
+			REQUIRE(stream.bytesFed() == text.length());
+			
+			SymbolTable &table = stream.symbols();
+			REQUIRE(table.size() == expected.size());
+			REQUIRE(table.fileCount() == 20);
+			
+			for(size_t i = 0; i < table.size(); i += 37)
+			{
+				REQUIRE(table.name(i) == expected.name(i));
+				REQUIRE(table.description(i) == expected.description(i));
+				REQUIRE(table.line(i) == expected.line(i));
+				REQUIRE(table.fullPath(i) == expected.fullPath(i));
+			}
+			
+			// No more than a file's worth, and a piece, is held back
+			REQUIRE(stream.peakBuffered() < text.length() / 10 + piece);
+		}
+	}
+	
+	SECTION("A list that's cut short keeps the files before the cut")
+	{
+		string text = makeSymbolResults(3, 4);
+		
+		MISymbolStream stream;
+		REQUIRE(stream.feed(std::string_view(text).substr(0, text.find("file_2.cpp") + 20)));
+		REQUIRE(stream.finish() == false);
+		REQUIRE(stream.symbols().fileCount() == 2);
+		REQUIRE(stream.symbols().size() == 8);
+		
+		// Only whole blocks are looked at before finish()
+		MISymbolStream notSymbols;
+		REQUIRE(notSymbols.feed("msg={text=\"symbols={debug=[]}\",pad=\"" + string(64, '.') + "\"}") == false);
+		REQUIRE(notSymbols.finish() == false);
+	}
+	
+	SECTION("GDBMI publishes the table as it grows, without holding the line")
+	{
+		// Nothing reads from the framer on the read thread without a GDB
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		GDBMI gdb(opts);
+		
+		// It's the mark that counts, not which callback answers it
+		uint32_t token = gdb.getToken();
+		auto wrapped = [](GDBMI *gdb, GDBMI::GDBResponse response) { GDBMI::getFuncSymbolsCallbackThunk(gdb, response); };
+		registerSymbolList(gdb, token, wrapped, GDBMI::SymbolListKind::Functions);
+		
+		string line = std::to_string(token) + "^done," + makeSymbolResults(200, 40) + "\n";
+		REQUIRE(line.length() > GDB_SYMBOL_STREAM_BYTES * 4);
+		
+		const size_t piece = 64 * 1024;
+		size_t seenPartial = 0;
+		
+		for(size_t i = 0; i < line.length(); i += piece)
+		{
+			std::string_view data = std::string_view(line).substr(i, piece);
+			memcpy(gdb.m_framer.writePtr(data.length()), data.data(), data.length());
+			gdb.m_framer.commit(data.length());
+			
+			gdb.dispatchFramed();
+			
+			REQUIRE(gdb.m_framer.pending() < GDB_SYMBOL_STREAM_BYTES + piece);
+			
+			size_t published = gdb.getFunctionSymbols()->data.size();
+			if(published > 0 && published < 200 * 40)
+				seenPartial++;
+		}
+		
+		REQUIRE(seenPartial > 0);
+		
+		// The whole table gets published with its search index
+		auto indexed = [&]()
+		{
+			GDBMI::SymbolSnapshot symbols = gdb.m_functionIndex.get()->data.symbols;
+			return symbols != 0 && symbols->data.size() == 200 * 40;
+		};
+		
+		waitUntil(indexed);
+		
+		REQUIRE(gdb.getFunctionSymbols()->data.size() == 200 * 40);
+		REQUIRE(gdb.getFunctionSymbols()->data.name(0) == "ns_0::function_0");
+		REQUIRE(gdb.m_functionIndex.get()->data.symbols == gdb.getFunctionSymbols());
+		
+		// The command was answered
+		GDBMI::PendingCommand cmd;
+		REQUIRE(waitUntil([&]() { return gdb.findCallback(token, cmd) == false; }));
+		REQUIRE(gdb.m_symbolStream.parser == nullptr);
+	}
+	
+	SECTION("A command that isn't marked as a symbol list is framed whole")
+	{
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		GDBMI gdb(opts);
+		
+		uint32_t token = gdb.getToken();
+		gdb.registerCallback(token, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::OrderDomain::Symbols);
+		
+		string line = std::to_string(token) + "^done," + makeSymbolResults(200, 40);
+		REQUIRE(line.length() > GDB_SYMBOL_STREAM_BYTES * 2);
+		
+		memcpy(gdb.m_framer.writePtr(line.length()), line.data(), line.length());
+		gdb.m_framer.commit(line.length());
+		gdb.dispatchFramed();
+		
+		REQUIRE(gdb.m_symbolStream.parser == nullptr);
+		REQUIRE(gdb.m_framer.pending() == line.length());
+		REQUIRE(gdb.getFunctionSymbols()->data.size() == 0);
+		
+		// The newline hands it to the callback as a whole line
+		memcpy(gdb.m_framer.writePtr(1), "\n", 1);
+		gdb.m_framer.commit(1);
+		gdb.dispatchFramed();
+		
+		REQUIRE(waitUntil([&]() { return gdb.getFunctionSymbols()->data.size() == 200 * 40; }));
+		waitIdle(gdb);
+	}
+	
+	SECTION("A streamed list that's cut short puts back the table from before")
+	{
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		GDBMI gdb(opts);
+		
+		GDBMI::SymbolSnapshot before = respondAndWait(gdb, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::OrderDomain::Symbols,
+									   makeSymbolResults(2, 3), [&]() { return gdb.getFunctionSymbols(); });
+		REQUIRE(waitUntil([&]() { return gdb.m_functionIndex.get()->data.symbols == before; }));
+		
+		uint32_t token = gdb.getToken();
+		registerSymbolList(gdb, token, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::SymbolListKind::Functions);
+		
+		// GDB's output ends halfway through the list
+		string line = std::to_string(token) + "^done," + makeSymbolResults(200, 40);
+		line = line.substr(0, line.length() / 2) + "\n";
+		REQUIRE(line.length() > GDB_SYMBOL_STREAM_BYTES * 2);
+		
+		const size_t piece = 64 * 1024;
+		size_t seenPartial = 0;
+		
+		for(size_t i = 0; i < line.length(); i += piece)
+		{
+			std::string_view data = std::string_view(line).substr(i, piece);
+			memcpy(gdb.m_framer.writePtr(data.length()), data.data(), data.length());
+			gdb.m_framer.commit(data.length());
+			
+			gdb.dispatchFramed();
+			
+			if(gdb.getFunctionSymbols()->data.size() > before->data.size())
+				seenPartial++;
+		}
+		
+		REQUIRE(seenPartial > 0);
+		REQUIRE(gdb.m_symbolStream.parser == nullptr);
+		
+		GDBMI::PendingCommand cmd;
+		REQUIRE(waitUntil([&]() { return gdb.findCallback(token, cmd) == false; }));
+		waitIdle(gdb);
+		
+		GDBMI::SymbolSnapshot after = gdb.getFunctionSymbols();
+		REQUIRE(after->data.size() == before->data.size());
+		REQUIRE(after->data.name(5) == before->data.name(5));
+		REQUIRE(gdb.m_functionIndex.get()->data.symbols == before);
+	}
+}
+
+TEST_CASE("Symbol search ranks and fuzzy-matches names", "[search]")
+{
+	SymbolTable table;
+	uint32_t file = table.addFile("/src/a.c", "a.c");
+	
+	vector<string> names = { "domain_check", "remainder", "ns::mainWindow", "main_loop", "main", "unrelated" };
+	for(auto &name : names)
+		table.addSymbol(file, 1, name, "void (void)", name);
+	table.finish();
+	
+	SymbolIndex index;
+	index.build(table);
+	
+	auto found = [&](const string & query)
+	{
+		vector<string> ret;
+		for(auto &match : index.search(query, 10))
+			ret.push_back(string(table.name(match.symbol)));
+			
+		return ret;
+	};
+	
+	SECTION("Whole names, then prefixes, then scopes, then anywhere")
+	{
+		REQUIRE(found("main") == vector<string>({ "main", "main_loop", "ns::mainWindow", "remainder", "domain_check" }));
+		REQUIRE(found("MAIN_L")[0] == "main_loop");
+		REQUIRE(index.search("main", 2).size() == 2);
+	}
+	
+	SECTION("Queries shorter than a trigram")
+	{
+		// Only where a name or a word starts
+		REQUIRE(found("ma") == vector<string>({ "main", "main_loop", "ns::mainWindow" }));
+		REQUIRE(found("w") == vector<string>({ "ns::mainWindow" }));
+		REQUIRE(found("q").size() == 0);
+	}
+	
+	SECTION("Names that only share most of the query still come up")
+	{
+		REQUIRE(found("mainloop") == vector<string>({ "main_loop" }));
+		REQUIRE(found("unrelatde") == vector<string>({ "unrelated" }));
+		REQUIRE(found("xyzzy").size() == 0);
+	}
+}
+
+TEST_CASE("Symbol searches run on the worker pool, newest first", "[search]")
+{
+	GDBMI gdb;
+	
+	uint64_t indexVersion = gdb.m_functionIndex.version();
+	respond(gdb, GDBMI::getFuncSymbolsCallbackThunk, GDBMI::OrderDomain::Symbols,
+			"symbols={debug=[{filename=\"a.c\",fullname=\"/src/a.c\",symbols=["
+			"{line=\"10\",name=\"main\",type=\"int (void)\",description=\"int main(void);\"},"
+			"{line=\"20\",name=\"helper\",type=\"int (void)\",description=\"static int helper(void);\"}]}]}");
+			
+	waitUntil([&]() { return gdb.m_functionIndex.version() != indexVersion; });
+	REQUIRE(gdb.m_functionIndex.version() == indexVersion + 1);
+	
+	auto waitForQuery = [&](uint64_t queryID)
+	{
+		waitUntil([&]() { return gdb.getSearchResults()->data.queryID == queryID; });
+		return gdb.getSearchResults();
+	};
+	
+	SECTION("Results point into the symbol table they came from")
+	{
+		GDBMI::SearchSnapshot results = waitForQuery(gdb.searchSymbols("help"));
+		
+		REQUIRE(results->data.query == "help");
+		REQUIRE(results->data.hits.size() == 1);
+		REQUIRE(results->data.hits[0].kind == GDBMI::SymbolKind::Function);
+		REQUIRE(results->data.functions->data.name(results->data.hits[0].index) == "helper");
+	}
+	
+	SECTION("Queries typed over each other only answer the last one")
+	{
+		// Holds the search strand until all three are queued
+		std::promise<void> release;
+		std::shared_future<void> released = release.get_future().share();
+		gdb.postTask(GDBMI::OrderDomain::Search, [released]() { released.wait(); });
+		
+		uint64_t version = gdb.getSearchResults()->version;
+		gdb.searchSymbols("m");
+		gdb.searchSymbols("ma");
+		uint64_t last = gdb.searchSymbols("mai");
+		release.set_value();
+		
+		GDBMI::SearchSnapshot results = waitForQuery(last);
+		REQUIRE(results->data.query == "mai");
+		REQUIRE(results->version == version + 1);
+		REQUIRE(results->data.functions->data.name(results->data.hits[0].index) == "main");
+	}
+}
+
+static GDBMI::CommandTask commandSequence(GDBMI &gdb, std::promise<vector<GDBMI::MIResult>> &done,
+		std::thread::id &resumedOn)
+{
+	vector<GDBMI::MIResult> results;
+	results.push_back(co_await gdb.command("-gdb-set confirm off"));
+	resumedOn = std::this_thread::get_id();
+	
+	vector<GDBMI::CommandAwaiter> fetches;
+	fetches.push_back(gdb.command("-break-list"));
+	fetches.push_back(gdb.command("-no-such-command"));
+	fetches.push_back(gdb.command("-stack-list-frames"));
+	
+	vector<GDBMI::MIResult> fetched = co_await gdb.whenAll(std::move(fetches));
+	results.insert(results.end(), fetched.begin(), fetched.end());
+	
+	done.set_value(results);
+}
+
+TEST_CASE("Command sequences can be written as coroutines", "[commands]")
+{
+	std::promise<vector<GDBMI::MIResult>> done;
+	std::future<vector<GDBMI::MIResult>> doneFuture = done.get_future();
+	std::thread::id resumedOn;
+	
+	SECTION("Each step continues on the worker pool with its result")
+	{
+		GDBMI gdb;
+		commandSequence(gdb, done, resumedOn);
+		
+		REQUIRE(doneFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+		vector<GDBMI::MIResult> results = doneFuture.get();
+		
+		REQUIRE(resumedOn != std::this_thread::get_id());
+		REQUIRE(results.size() == 4);
+		REQUIRE(results[0].ok());
+		
+		// whenAll() keeps the order the commands were given in
+		REQUIRE(results[1].ok());
+		REQUIRE(results[2].status == GDBMI::MIResult::Status::Error);
+		REQUIRE(results[3].ok());
+		REQUIRE(results[1].token < results[2].token);
+		REQUIRE(results[2].token < results[3].token);
+		
+		REQUIRE(gdb.getCommandStats().pending == 0);
+	}
+	
+	SECTION("Sequences are resumed when their commands can't be sent")
+	{
+		GDBMI::LaunchOptions opts;
+		opts.gdbPath = "/nonexistent/path/to/gdb";
+		
+		GDBMI gdb(opts);
+		commandSequence(gdb, done, resumedOn);
+		
+		REQUIRE(doneFuture.wait_for(std::chrono::seconds(5)) == std::future_status::ready);
+		vector<GDBMI::MIResult> results = doneFuture.get();
+		
+		REQUIRE(results.size() == 4);
+		for(auto &res : results)
+			REQUIRE(res.status == GDBMI::MIResult::Status::GDBExited);
+	}
+	
+	SECTION("Loading an inferior fetches its data once the load is done")
+	{
+		GDBMI gdb;
+		gdb.doFileCommand(GDBMI::FileCmd::FileExecWithSymbols, "/bin/true");
+		
+		// The load, then symbols and register names
+		waitUntil([&]() { return gdb.getCommandStats().completed >= 6; });
+		
+		REQUIRE(gdb.getStatusMsg() == "Inferior loaded, not running");
+		REQUIRE(gdb.getCommandStats().completed >= 6);
+		REQUIRE(gdb.getCommandStats().pending == 0);
+	}
+}
+
+TEST_CASE("MI line framer splits the raw stream into records", "[framer]")
+{
+	MILineFramer framer(16);
+	
+	auto feed = [&](const string & data)
+	{
+		char *dst = framer.writePtr(data.length());
+		memcpy(dst, data.data(), data.length());
+		framer.commit(data.length());
+	};
+	
+	std::string_view line;
+	
+	SECTION("Complete lines are handed out in order, empty lines are skipped")
+	{
+		feed("^done\n\n\n*stopped,reason=\"end-stepping-range\"\n(gdb) \n");
+		
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line == "^done");
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line == "*stopped,reason=\"end-stepping-range\"");
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line == "(gdb) ");
+		REQUIRE(framer.nextLine(line) == false);
+		REQUIRE(framer.pending() == 0);
+	}
+	
+	SECTION("Lines split across reads are reassembled")
+	{
+		feed("123^done,value=\"0x4");
+		REQUIRE(framer.nextLine(line) == false);
+		
+		feed("01000 <main>\"");
+		REQUIRE(framer.nextLine(line) == false);
+		
+		feed("\n=thread-");
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line == "123^done,value=\"0x401000 <main>\"");
+		REQUIRE(framer.nextLine(line) == false);
+		REQUIRE(framer.pending() == 8);
+		
+		feed("exited\n");
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line == "=thread-exited");
+	}
+	
+	SECTION("Embedded NUL bytes are kept")
+	{
+		feed(string("~\"a\0b\"\n", 7));
+		
+		REQUIRE(framer.nextLine(line));
+		REQUIRE(line.length() == 6);
+		REQUIRE(line[3] == '\0');
+	}
+}
+
 #endif
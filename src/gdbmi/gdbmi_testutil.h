@@ -0,0 +1,114 @@
+#ifndef UNIQUE_GDBMI_TESTUTIL_H
+#define UNIQUE_GDBMI_TESTUTIL_H
+
+#ifdef BUILD_GDBMI_TESTS
+#include "gdbmi.h"
+
+#include <chrono>
+
+// Shared by gdbmi_test.cpp and gdbmi_bench.cpp
+
+// Checks 'done' every pollUs until it's true or timeoutMs have passed
+static inline bool waitUntil(function<bool()> done, uint32_t timeoutMs = 2000, uint32_t pollUs = 1000 * 5)
+{
+	auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	
+	while(done() == false)
+	{
+		if(std::chrono::steady_clock::now() >= until)
+			return done();
+			
+		usleep(pollUs);
+	}
+	
+	return true;
+}
+
+// Waits for every command sent to be answered and every record to be handled
+static inline bool waitIdle(GDBMI &gdb)
+{
+	return waitUntil([&]() { return gdb.getCommandStats().pending == 0 && gdb.getDispatchStats().queueDepth == 0; });
+}
+
+// Hands 'cb' a result record as if GDB had answered the command it was
+// registered for. 'results' is what follows "^done,".
+static inline uint32_t respond(GDBMI &gdb, GDBMI::CmdCallback cb, GDBMI::OrderDomain domain, const string &results)
+{
+	uint32_t token = gdb.getToken();
+	gdb.registerCallback(token, cb, domain);
+	gdb.handleResponse(std::to_string(token) + "^done" + (results.empty() ? "" : "," + results));
+	
+	return token;
+}
+
+// registerCallback(), marked as a symbol list the way requestFunctionSymbols()
+// and requestGlobalVarSymbols() mark their commands, so its result is streamed
+static inline void registerSymbolList(GDBMI &gdb, uint32_t token, GDBMI::CmdCallback cb, GDBMI::SymbolListKind kind)
+{
+	GDBMI::PendingCommand pc;
+	pc.callback = cb;
+	pc.domain = GDBMI::OrderDomain::Symbols;
+	pc.symbolList = kind;
+	
+	gdb.m_pendingCmdMutex.lock();
+	gdb.m_pendingCommands.insert(token, std::move(pc));
+	gdb.m_pendingCmdMutex.unlock();
+}
+
+// respond(), then waits for the snapshot 'getter' hands out to change version
+// and returns the new one
+template<typename Getter>
+static inline auto respondAndWait(GDBMI &gdb, GDBMI::CmdCallback cb, GDBMI::OrderDomain domain, const string &results,
+								  Getter getter)
+{
+	uint64_t version = getter()->version;
+	
+	respond(gdb, cb, domain, results);
+	waitUntil([&]() { return getter()->version != version; });
+	
+	return getter();
+}
+
+// The results of a '-symbol-info-functions' response (what follows "^done,")
+// with fileCount source files and symsPerFile symbols in each file. The types
+// and descriptions have brackets, commas and escaped quotes inside the
+// strings, and there's a nondebug list after the debug one, as GDB sends them.
+static inline string makeSymbolResults(uint32_t fileCount, uint32_t symsPerFile)
+{
+	string ret = "symbols={debug=[";
+	
+	for(uint32_t f = 0; f < fileCount; f++)
+	{
+		string fname = "file_" + std::to_string(f) + ".cpp";
+		
+		if(f > 0)
+			ret += ",";
+			
+		ret += "{filename=\"src/" + fname + "\",fullname=\"/home/user/project/src/" + fname + "\",symbols=[";
+		
+		for(uint32_t s = 0; s < symsPerFile; s++)
+		{
+			string name = "ns_" + std::to_string(f) + "::function_" + std::to_string(s);
+			
+			if(s > 0)
+				ret += ",";
+				
+			ret += "{line=\"" + std::to_string(10 + s * 7) + "\",name=\"" + name + "\",";
+			ret += "type=\"int (std::map<int, char[4]>, char **)\",description=\"int " + name + "(const char *x = \\\"a,}]\\\");\"}";
+		}
+		
+		ret += "]}";
+	}
+	
+	ret += "],nondebug=[{address=\"0x1000\",name=\"_init\"},{address=\"0x1010\",name=\"{weird]\"}]}";
+	return ret;
+}
+
+// The same as a whole response line, without the trailing newline
+static inline string makeSymbolResponse(uint32_t token, uint32_t fileCount, uint32_t symsPerFile)
+{
+	return std::to_string(token) + "^done," + makeSymbolResults(fileCount, symsPerFile);
+}
+
+#endif
+#endif
@@ -0,0 +1,162 @@
+#ifndef UNIQUE_GDBMI_TOKENMAP_H
+#define UNIQUE_GDBMI_TOKENMAP_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+/*
+	Open-addressing hash table keyed by MI command token.
+
+	Tokens are handed out sequentially and are never 0, so 0 marks an empty
+	slot. Collisions are resolved with linear probing, and erase() shifts
+	the following entries back instead of leaving tombstones, so lookups
+	never slow down as commands come and go.
+
+	Not thread safe; the owner provides the locking.
+*/
+
+template<typename T>
+class TokenMap
+{
+	public:
+	
+		TokenMap(size_t initialCapacity = 256)
+		{
+			size_t cap = 16;
+			while(cap < initialCapacity)
+				cap *= 2;
+				
+			m_slots.resize(cap);
+		}
+		
+		// Inserts or replaces the value for 'token'
+		void insert(uint32_t token, T value)
+		{
+			if(token == 0)
+				return;
+				
+			if((m_count + 1) * 10 > m_slots.size() * 7) // Keep the load under 70%
+				grow();
+				
+			size_t i = findSlot(token);
+			
+			if(m_slots[i].first == 0)
+				m_count++;
+				
+			m_slots[i] = {token, std::move(value)};
+		}
+		
+		// Returns a pointer to the value, or 0. The pointer is
+		// invalidated by the next insert() or erase().
+		T *find(uint32_t token)
+		{
+			if(token == 0)
+				return 0;
+				
+			size_t i = findSlot(token);
+			return (m_slots[i].first == token ? &m_slots[i].second : 0);
+		}
+		
+		bool erase(uint32_t token)
+		{
+			T discard;
+			return take(token, discard);
+		}
+		
+		// Moves the value out of the table and removes the entry
+		bool take(uint32_t token, T &out)
+		{
+			if(token == 0)
+				return false;
+				
+			size_t mask = m_slots.size() - 1;
+			size_t i = findSlot(token);
+			
+			if(m_slots[i].first != token)
+				return false;
+				
+			out = std::move(m_slots[i].second);
+			
+			// Backward-shift deletion: pull later entries of the probe
+			// sequence into the hole so no tombstone is needed
+			size_t hole = i;
+			size_t j = i;
+			while(true)
+			{
+				j = (j + 1) & mask;
+				
+				if(m_slots[j].first == 0)
+					break;
+					
+				size_t home = hashToken(m_slots[j].first) & mask;
+				
+				// Move the entry unless its home slot lies cyclically in (hole, j]
+				bool inRange = (hole <= j) ? (hole < home && home <= j) : (hole < home || home <= j);
+				if(inRange)
+					continue;
+					
+				m_slots[hole] = std::move(m_slots[j]);
+				hole = j;
+			}
+			
+			m_slots[hole] = {0, T()};
+			m_count--;
+			
+			return true;
+		}
+		
+		size_t size() const { return m_count; }
+		size_t capacity() const { return m_slots.size(); }
+		
+		template<typename F>
+		void forEach(F func)
+		{
+			for(auto &slot : m_slots)
+			{
+				if(slot.first != 0)
+					func(slot.first, slot.second);
+			}
+		}
+		
+	private:
+	
+		static size_t hashToken(uint32_t token)
+		{
+			// Sequential tokens would otherwise fill neighbouring slots in runs
+			return (size_t)((token * 0x9E3779B1u) ^ (token >> 16));
+		}
+		
+		// Returns the slot holding 'token', or the empty slot where it would go
+		size_t findSlot(uint32_t token) const
+		{
+			size_t mask = m_slots.size() - 1;
+			size_t i = hashToken(token) & mask;
+			
+			while(m_slots[i].first != 0 && m_slots[i].first != token)
+				i = (i + 1) & mask;
+				
+			return i;
+		}
+		
+		void grow()
+		{
+			std::vector<std::pair<uint32_t, T>> old;
+			old.swap(m_slots);
+			
+			m_slots.resize(old.size() * 2);
+			m_count = 0;
+			
+			for(auto &slot : old)
+			{
+				if(slot.first != 0)
+					insert(slot.first, std::move(slot.second));
+			}
+		}
+		
+		std::vector<std::pair<uint32_t, T>> m_slots;
+		size_t m_count = 0;
+};
+
+#endif
@@ -35,14 +35,8 @@ class GuiParentWrapper
 		virtual ImFont *getItalicFont() = 0;
 		virtual ImFont *getBoldItalicFont() = 0;
 		virtual ImVec2 getMainWindowSize() = 0;
-		virtual mutex &getFuncListMutex() = 0;
-		virtual vector<GDBMI::SymbolObject> &getFuncList() = 0;
 		virtual mutex &getCodeLinesMtx() = 0;
 		virtual AsmDump &getCodeLines() = 0;
-		virtual mutex &getGlobVarListMtx() = 0;
-		virtual vector<GDBMI::SymbolObject> &getGlobVarList() = 0;
-		virtual mutex &getBreakpointMutex() = 0;
-		virtual vector<GDBMI::BreakpointInfo> &getBreakpointList() = 0;
 		virtual bool isKeyPressed(uint32_t key) = 0;
 		virtual void clearKeyPress(uint32_t key) = 0;
 		virtual bool isKeyboardAvailable() = 0;
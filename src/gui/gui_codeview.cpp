@@ -33,14 +33,11 @@ void GuiCodeView::draw()
 	
 	if(BeginChild("CodeViewPane", { mwSize.x * m_width, mwSize.y * m_height }, true))
 	{
-		vector<GDBMI::BreakpointInfo> bpListCopy;
-		m_parent->getBreakpointMutex().lock();
-		bpListCopy = m_parent->getBreakpointList();
-		m_parent->getBreakpointMutex().unlock();
+		GDBMI::Snapshot<GDBMI::BreakpointInfo> bpList = gdb->getBpList();
 		
 		auto addrIsBP = [&](string address) -> const GDBMI::BreakpointInfo*
 		{
-			for(auto &bp : bpListCopy)
+			for(auto &bp : bpList->data)
 			{
 				if(bp.addr == address)
 					return &bp;
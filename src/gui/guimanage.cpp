@@ -10,7 +10,10 @@ GuiManager::GuiManager(SDL_Window *sdlWin, SDL_GLContext *glCtx)
 		return;
 	}
 	
-	gdb->setNotifyCallback(GuiManager::updateNotifyCBThunk, this);
+	m_gdbSubscription = gdb->subscribe(GDBMI::EventType::DisassemblyChanged, [this](GDBMI *, const vector<GDBMI::Event> &events)
+	{
+		handleGdbEvents(events);
+	});
 	m_cacheThread = thread(GuiManager::cacheHandlerThreadThunk, this);
 	
 	m_sdlWindow = sdlWin;
@@ -82,7 +85,13 @@ GuiManager::GuiManager(SDL_Window *sdlWin, SDL_GLContext *glCtx)
 
 GuiManager::~GuiManager()
 {
+	gdb->unsubscribe(m_gdbSubscription);
+	
+	m_cacheFlagMutex.lock();
 	m_exitProgram = true;
+	m_cacheFlagMutex.unlock();
+	m_cacheFlagCond.notify_one();
+	
 	m_cacheThread.join();
 }
 
@@ -445,74 +454,45 @@ void GuiManager::handleInput()
 	}
 }
 
-void GuiManager::updateNotifyCB(GDBMI::UpdateType updateType)
+void GuiManager::handleGdbEvents(const vector<GDBMI::Event> &events)
 {
-	using LogLevel = GDBMI::LogLevel;
-	using UpdateType = GDBMI::UpdateType;
+	using EventType = GDBMI::EventType;
 	
 	m_cacheFlagMutex.lock();
 	
-	uint64_t updType = (uint64_t) updateType;
-	if((updType & (uint64_t) UpdateType::FuncSymbols) != 0)
-		setCacheFlag(FLAG_FUNC_CACHE_STALE);
-		
-	if((updType & (uint64_t) UpdateType::GVarSymbols) != 0)
-		setCacheFlag(FLAG_GLOBVAR_CACHE_STALE);
-		
-	if((updType & (uint64_t) UpdateType::Disassembly) != 0)
-		setCacheFlag(FLAG_DISASM_CACHE_STALE);
-		
-	if((updType & (uint64_t) UpdateType::RegisterInfo) != 0)
-		setCacheFlag(FLAG_REGISTER_CACHE_STALE);
-		
-	if((updType & (uint64_t) UpdateType::Backtrace) != 0)
-		setCacheFlag(FLAG_STACKTRACE_CACHE_STALE);
-		
-	if((updType & (uint64_t) UpdateType::BreakPtList) != 0)
-		setCacheFlag(FLAG_BREAKPOINT_CACHE_STALE);
-		
+	for(auto &ev : events)
+	{
+		if(ev.type == EventType::DisassemblyChanged)
+			setCacheFlag(FLAG_DISASM_CACHE_STALE);
+	}
+	
 	m_cacheFlagMutex.unlock();
+	m_cacheFlagCond.notify_one();
 }
 
 void GuiManager::cacheHandlerThread()
 {
 	using LogLevel = GDBMI::LogLevel;
 	
-	while(!m_exitProgram)
+	std::unique_lock<mutex> flagLock(m_cacheFlagMutex);
+	
+	while(true)
 	{
-		m_cacheFlagMutex.lock();
-		
-		if(isFlagSet(FLAG_FUNC_CACHE_STALE))
-		{
-			m_funcListMutex.lock();
-			
-			m_funcSymbolCache.clear();
-			m_funcSymbolCache = gdb->getFunctionSymbols();
-			
-			clearCacheFlag(FLAG_FUNC_CACHE_STALE);
-			m_funcListMutex.unlock();
-		}
+		// Sleeps until handleGdbEvents() marks something stale
+		m_cacheFlagCond.wait(flagLock, [this]() { return m_cacheStaleFlags != 0 || m_exitProgram; });
 		
-		if(isFlagSet(FLAG_GLOBVAR_CACHE_STALE))
-		{
-			m_gvarListMutex.lock();
-			
-			m_globalVarCache.clear();
-			m_globalVarCache = gdb->getGlobalVarSymbols();
+		if(m_exitProgram)
+			break;
 			
-			clearCacheFlag(FLAG_GLOBVAR_CACHE_STALE);
-			m_gvarListMutex.unlock();
-		}
-		
 		if(isFlagSet(FLAG_DISASM_CACHE_STALE))
 		{
 			m_codeLinesMutex.lock();
 			
-			vector<GDBMI::DisassemblyInstruction> gdbDisasm = gdb->getDisassembly();
+			GDBMI::Snapshot<GDBMI::DisassemblyInstruction> gdbDisasm = gdb->getDisassembly();
 			m_codeLines.clear();
 			
 			uint32_t ctr = 0;
-			for(auto &inst : gdbDisasm)
+			for(auto &inst : gdbDisasm->data)
 			{
 				AsmLineDesc tmp;
 				tmp.addr = inst.addrStr;
@@ -531,42 +511,6 @@ void GuiManager::cacheHandlerThread()
 			clearCacheFlag(FLAG_DISASM_CACHE_STALE);
 			m_codeLinesMutex.unlock();
 		}
-		
-		if(isFlagSet(FLAG_REGISTER_CACHE_STALE))
-		{
-			m_registerCacheMutex.lock();
-			
-			m_registerCache.clear();
-			m_registerCache = gdb->getRegisters();
-			
-			clearCacheFlag(FLAG_REGISTER_CACHE_STALE);
-			m_registerCacheMutex.unlock();
-		}
-		
-		if(isFlagSet(FLAG_STACKTRACE_CACHE_STALE))
-		{
-			m_backtraceMutex.lock();
-			
-			m_backtraceCache.clear();
-			m_backtraceCache = gdb->getBacktrace();
-			
-			clearCacheFlag(FLAG_STACKTRACE_CACHE_STALE);
-			m_backtraceMutex.unlock();
-		}
-		
-		if(isFlagSet(FLAG_BREAKPOINT_CACHE_STALE))
-		{
-			m_bpCacheMutex.lock();
-			
-			m_breakpointCache.clear();
-			m_breakpointCache = gdb->getBpList();
-			
-			clearCacheFlag(FLAG_BREAKPOINT_CACHE_STALE);
-			m_bpCacheMutex.unlock();
-		}
-		
-		m_cacheFlagMutex.unlock();
-		usleep(1000 * 50);
 	}
 }
 
@@ -14,12 +14,7 @@
 
 using namespace ImGui;
 
-#define FLAG_FUNC_CACHE_STALE			(((uint64_t) 1) << 0)
-#define FLAG_GLOBVAR_CACHE_STALE		(((uint64_t) 1) << 1)
 #define FLAG_DISASM_CACHE_STALE			(((uint64_t) 1) << 2)
-#define FLAG_REGISTER_CACHE_STALE		(((uint64_t) 1) << 3)
-#define FLAG_STACKTRACE_CACHE_STALE		(((uint64_t) 1) << 4)
-#define FLAG_BREAKPOINT_CACHE_STALE		(((uint64_t) 1) << 5)
 
 
 class GuiManager : public GuiParentWrapper
@@ -56,25 +51,11 @@ class GuiManager : public GuiParentWrapper
 			return m_guiColors[item];
 		}
 		
-		// Debug info caches
-		mutex &getFuncListMutex() { return m_funcListMutex; }
-		vector<GDBMI::SymbolObject> &getFuncList() { return m_funcSymbolCache; }
-		
+		// Disassembly, formatted for the code view. Symbols, registers, the
+		// backtrace and breakpoints are read straight from GDBMI's snapshots.
 		mutex &getCodeLinesMtx() { return m_codeLinesMutex; }
 		AsmDump &getCodeLines() { return m_codeLines; }
 		
-		mutex &getGlobVarListMtx() { return m_gvarListMutex; }
-		vector<GDBMI::SymbolObject> &getGlobVarList() { return m_globalVarCache; }
-		
-		mutex &getRegListMutex() { return m_registerCacheMutex;}
-		vector<GDBMI::RegisterInfo> &getRegList() { return m_registerCache; }
-		
-		mutex &getBacktraceMutex() { return m_backtraceMutex; }
-		vector<GDBMI::FrameInfo> &getBacktrace() { return m_backtraceCache; }
-		
-		mutex &getBreakpointMutex() { return m_bpCacheMutex; }
-		vector<GDBMI::BreakpointInfo> &getBreakpointList() { return m_breakpointCache; }
-		
 		bool isKeyPressed(uint32_t key);
 		void clearKeyPress(uint32_t key);
 		bool isKeyboardAvailable()	{ return !m_wantCaptureKeyboard; }
@@ -94,9 +75,6 @@ class GuiManager : public GuiParentWrapper
 		void setInferiorPathInfo(string path) { m_inferiorInfo.path = path; }
 		void setInferiorArgsInfo(string args) { m_inferiorInfo.args = args; }
 		
-		static void updateNotifyCBThunk(GDBMI::UpdateType updateType, void *obj)
-		{ ((GuiManager *) obj)->updateNotifyCB(updateType); }
-		
 		static void cacheHandlerThreadThunk(GuiManager *obj)
 		{ obj->cacheHandlerThread(); }
 		
@@ -111,31 +89,19 @@ class GuiManager : public GuiParentWrapper
 		// Handles keyboard/mouse input
 		void handleInput();
 		
-		vector<GDBMI::SymbolObject> m_funcSymbolCache;
-		mutex m_funcListMutex;
-		
-		vector<GDBMI::SymbolObject> m_globalVarCache;
-		mutex m_gvarListMutex;
-		
 		AsmDump m_codeLines;
 		mutex m_codeLinesMutex;
 		
-		vector<GDBMI::RegisterInfo> m_registerCache;
-		mutex m_registerCacheMutex;
-		
-		vector<GDBMI::FrameInfo> m_backtraceCache;
-		mutex m_backtraceMutex;
-		
-		vector<GDBMI::BreakpointInfo> m_breakpointCache;
-		mutex m_bpCacheMutex;
-		
-		void updateNotifyCB(GDBMI::UpdateType updateType);
+		// Subscribed to GDBMI's events. Marks the caches as stale and wakes the cache thread.
+		void handleGdbEvents(const vector<GDBMI::Event> &events);
+		uint32_t m_gdbSubscription = 0;
 		
 		// Handles updating the various caches when update notifications come in
 		void cacheHandlerThread();
 		
 		thread m_cacheThread;
 		mutex m_cacheFlagMutex;
+		std::condition_variable m_cacheFlagCond;
 		uint64_t m_cacheStaleFlags = 0;
 		void setCacheFlag(uint64_t f) 		{ m_cacheStaleFlags |= f; }
 		void clearCacheFlag(uint64_t f)		{ m_cacheStaleFlags &= ~f; }
@@ -2,6 +2,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <string>
+#include <map>
 #include <csignal>
 
 #include <unistd.h>
@@ -466,39 +467,103 @@ int main(int argc, char **argv)
 
 void symbolTabPainter(string tabName, void *userData)
 {
-	if(tabName == "Local Func" || tabName == "Imports")
+	// One search box for all the symbol tabs; each shows the hits of its own kind
+	static char searchBuf[256] = {0};
+	
+	SetNextItemWidth(-1.0f);
+	if(InputTextWithHint("##symbolsearch", "Search symbols", searchBuf, sizeof(searchBuf)))
+		gdb->searchSymbols(searchBuf);
+		
+	bool isGlobals = (tabName == "Global Vars");
+	
+	auto belongsInTab = [&](const SymbolTable & table, uint32_t i) -> bool
+	{
+		// TODO: Fix this cheap-ass method of checking for external symbols
+		if(tabName == "Imports")
+			return table.fullPath(i).find("/include/") != std::string::npos;
+		else if(tabName == "Local Func")
+			return table.fullPath(i).find("/include/") == std::string::npos;
+			
+		return true;
+	};
+	
+	// The rows to show, as indices into 'table'. Without a search that's
+	// every symbol of the tab, which is only worked out again when the
+	// symbols change.
+	struct TabRows
 	{
-		mutex &funcListMutex = gui->getFuncListMutex();
+		uint64_t version = UINT64_MAX;
+		vector<uint32_t> rows;
+	};
+	
+	static std::map<string, TabRows> tabRows;
+	
+	GDBMI::SymbolSnapshot symbols;
+	GDBMI::SearchSnapshot results;
+	vector<uint32_t> hitRows;
+	const vector<uint32_t> *rows = &hitRows;
+	
+	if(searchBuf[0] != 0)
+	{
+		results = gdb->getSearchResults();
+		symbols = isGlobals ? results->data.globals : results->data.functions;
 		
-		funcListMutex.lock();
-		const vector<GDBMI::SymbolObject> &funcList = gui->getFuncList();
-		GDBMI::CurrentInstruction curPos = gdb->getCurrentExecutionPos();
+		GDBMI::SymbolKind kind = isGlobals ? GDBMI::SymbolKind::GlobalVar : GDBMI::SymbolKind::Function;
+		for(auto &hit : results->data.hits)
+		{
+			if(hit.kind == kind && belongsInTab(symbols->data, hit.index))
+				hitRows.push_back(hit.index);
+		}
+	}
+	else
+	{
+		symbols = isGlobals ? gdb->getGlobalVarSymbols() : gdb->getFunctionSymbols();
 		
-		static std::string selectedFunc = "";
-		for(uint32_t i = 0; i < funcList.size(); i++)
+		TabRows &cache = tabRows[tabName];
+		if(cache.version != symbols->version)
 		{
-			// TODO: Fix this cheap-ass method of checking for external symbols
-			if(tabName == "Imports")
-			{
-				if(funcList[i].fullPath.find("/include/") == std::string::npos)
-					continue;
-			}
-			else
+			cache.version = symbols->version;
+			cache.rows.clear();
+			
+			for(uint32_t i = 0; i < symbols->data.size(); i++)
 			{
-				if(funcList[i].fullPath.find("/include/") != std::string::npos)
-					continue;
+				if(belongsInTab(symbols->data, i))
+					cache.rows.push_back(i);
 			}
+		}
+		
+		rows = &cache.rows;
+	}
+	
+	// No search has finished yet
+	if(symbols == nullptr)
+		return;
+		
+	const SymbolTable &table = symbols->data;
+	GDBMI::CurrentInstruction curPos = gdb->getCurrentExecutionPos();
+	
+	static std::string selectedFunc = "";
+	static std::string selectedVar = "";
+	std::string &selected = isGlobals ? selectedVar : selectedFunc;
+	
+	// Only the rows in view are drawn
+	ImGuiListClipper clipper(rows->size());
+	while(clipper.Step())
+	{
+		for(int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+		{
+			uint32_t i = (*rows)[row];
 			
 			bool funcIsActive = false;
-			if(curPos.second.length() > 0 && funcList[i].name.find(curPos.second) != string::npos)
+			if(isGlobals == false && curPos.second.length() > 0 && table.name(i).find(curPos.second) != string::npos)
 				funcIsActive = true;
 				
 			if(funcIsActive)
 				PushFont(gui->getBoldFont());
 				
-			string itemText = funcList[i].description;
-			if(Selectable((string(" ") + itemText).c_str(), (selectedFunc == itemText)))
-				selectedFunc = itemText;
+			string itemText(table.description(i));
+			if(Selectable((string(" ") + itemText).c_str(), (selected == itemText)))
+				selected = itemText;
 				
 			if(funcIsActive)
 				PopFont();
@@ -508,42 +573,12 @@ void symbolTabPainter(string tabName, void *userData)
 				
 			if(IsItemClicked())
 			{
-				//
-				gdb->requestDisassembleLine(funcList[i].shortName, funcList[i].lineNumber);
-			}
-		}
-		
-		funcListMutex.unlock();
-		
-	}
-	else if(tabName == "Global Vars")
-	{
-		mutex &gvarMutex = gui->getGlobVarListMtx();
-		
-		gvarMutex.lock();
-		vector<GDBMI::SymbolObject> &gvarList = gui->getGlobVarList();
-		
-		static std::string selectedVar = "";
-		for(uint32_t i = 0; i < gvarList.size(); i++)
-		{
-			// if(gvarList[i].fullPath.find("/include/") == std::string::npos)
-			// continue;
-			
-			string itemText = gvarList[i].description;
-			if(Selectable((string(" ") + itemText).c_str(), (selectedVar == itemText)))
-				selectedVar = itemText;
-				
-			if(IsItemHovered())
-				SetTooltip("%s", itemText.c_str());
-				
-			if(IsItemClicked())
-			{
+				if(isGlobals == false)
+					gdb->requestDisassembleLine(string(table.shortName(i)), std::to_string(table.line(i)));
+					
 				// TODO: Handle click input on global variable list
-				//
 			}
 		}
-		
-		gvarMutex.unlock();
 	}
 }
 
@@ -551,15 +586,14 @@ void registerTabPainter(string tabName, void *userData)
 {
 	// TODO: This function is going to need to be able to handle multiple architectures
 	
-	mutex &regMutex = gui->getRegListMutex();
-	vector<GDBMI::RegisterInfo> &regList = gui->getRegList();
+	GDBMI::Snapshot<GDBMI::RegisterInfo> registers = gdb->getRegisters();
 	
 	vector<string> generalRegisters =
 	{
 		"rax", "rbx", "rcx", "rdx", "rsi", "rdi", "rsp", "rip", "eflags"
 	};
 	
-	auto isGenReg = [&](string & r) -> bool
+	auto isGenReg = [&](const string & r) -> bool
 	{
 		for(auto &genreg : generalRegisters)
 		{
@@ -576,8 +610,7 @@ void registerTabPainter(string tabName, void *userData)
 	ImVec4 ripColor = gui->getColor(GuiItem::RegisterProgCtr);
 	ImVec4 chgColor = gui->getColor(GuiItem::RegisterValChg);
 	
-	regMutex.lock();
-	for(auto &reg : regList)
+	for(auto &reg : registers->data)
 	{
 		if(isGenReg(reg.regName))
 		{
@@ -615,14 +648,11 @@ void registerTabPainter(string tabName, void *userData)
 		}
 	}
 	
-	regMutex.unlock();
 	Columns(1);
 }
 
 void backtraceTabPainter(string tabname, void *userData)
 {
-	mutex &btMutex = gui->getBacktraceMutex();
-	
 	ImFont *boldFont = gui->getBoldFont();
 	// ImFont *boldItalicFont = gui->getBoldItalicFont();
 	
@@ -645,10 +675,8 @@ void backtraceTabPainter(string tabname, void *userData)
 	Separator();
 	PopFont();
 	
-	btMutex.lock();
-	
-	vector<GDBMI::FrameInfo> &backtrace = gui->getBacktrace();
-	for(auto &frame : backtrace)
+	GDBMI::Snapshot<GDBMI::FrameInfo> backtrace = gdb->getBacktrace();
+	for(auto &frame : backtrace->data)
 	{
 		// PushStyleColor(ImGuiCol_Header, gui->getColor(GuiItem::ActiveFrame));
 		
@@ -704,7 +732,6 @@ void backtraceTabPainter(string tabname, void *userData)
 	}
 	
 	Columns(1);
-	btMutex.unlock();
 }
 
 void breakpointsTabPainter(string tabName, void *userData)
@@ -712,11 +739,8 @@ void breakpointsTabPainter(string tabName, void *userData)
 	GDBMI::StepFrame stepFrame = gdb->getStepFrame();
 	GDBMI::CurrentInstruction curPos = gdb->getCurrentExecutionPos();
 	
-	mutex &bpMutex = gui->getBreakpointMutex();
-	bpMutex.lock();
-	
 	ImFont *boldFont = gui->getBoldFont();
-	vector<GDBMI::BreakpointInfo> &bpList = gui->getBreakpointList();
+	GDBMI::Snapshot<GDBMI::BreakpointInfo> bpList = gdb->getBpList();
 	
 	
 	Columns(4);
@@ -737,7 +761,7 @@ void breakpointsTabPainter(string tabName, void *userData)
 	Separator();
 	PopFont();
 	
-	for(auto &bp : bpList)
+	for(auto &bp : bpList->data)
 	{
 		bool bpIsPC = false;
 		if(stepFrame.isValid)
@@ -779,5 +803,4 @@ void breakpointsTabPainter(string tabName, void *userData)
 	}
 	
 	Columns(1);
-	bpMutex.unlock();
 }